@@ -0,0 +1,35 @@
+# Script for collecting import times for the modules in the standard and HoTT libraries.
+# Each module is imported by a small Lean file, and the time needed to process it is reported.
+# It is used to compare the module loading code of two different Lean binaries.
+#
+# Usage: import_perf.sh [lean-binary]
+#
+# It assumes the standard library has already been compiled (i.e., .olean files are available)
+# It assumes the programs time and realpath are available
+TIME=/usr/bin/time
+REALPATH=realpath
+
+MY_PATH="`dirname \"$0\"`"
+LEAN=${1:-$MY_PATH/../bin/lean}
+TMP_DIR=`mktemp -d`
+trap "rm -rf $TMP_DIR" EXIT
+
+# import_time <library-dir> <olean-file> <extension>
+import_time() {
+    lib=$1
+    f=$2
+    mod=`echo ${f#$lib/} | sed -e 's/\.olean$//' -e 's|/|.|g'`
+    tst=$TMP_DIR/import_tst.$3
+    echo "import $mod" > $tst
+    $TIME --format="$mod %e %MKb" $LEAN $tst > /dev/null
+}
+
+LIB=`$REALPATH $MY_PATH/../library`
+for f in `find $LIB -name '*.olean'`; do
+  import_time $LIB $f lean
+done
+
+LIB=`$REALPATH $MY_PATH/../hott`
+for f in `find $LIB -name '*.olean'`; do
+  import_time $LIB $f hlean
+done
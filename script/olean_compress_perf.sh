@@ -0,0 +1,49 @@
+# Script for comparing plain and compressed .olean files for the standard library.
+# It reports the total size of the .olean files, and the time needed to import each module.
+#
+# Usage: olean_compress_perf.sh [lean-binary]
+#
+# It assumes the standard library has already been compiled (i.e., .olean files are available)
+# It assumes the programs time and realpath are available
+# Remark: the file system cache is not dropped, the script should be executed twice
+# to compare warm caches, or after dropping the caches to compare cold ones.
+TIME=/usr/bin/time
+REALPATH=realpath
+
+MY_PATH="`dirname \"$0\"`"
+LEAN=`$REALPATH ${1:-$MY_PATH/../bin/lean}`
+LIB=`$REALPATH $MY_PATH/../library`
+TMP_DIR=`mktemp -d`
+trap "rm -rf $TMP_DIR" EXIT
+
+# Create a copy of the library containing compressed .olean files
+cp -r $LIB $TMP_DIR/plain
+cp -r $LIB $TMP_DIR/lz
+for f in `find $TMP_DIR/lz -name '*.lean'`; do
+  olean=${f%.lean}.olean
+  if [ -f $olean ]; then
+      LEAN_PATH=$TMP_DIR/lz $LEAN --compress $f -o $olean > /dev/null || exit 1
+  fi
+done
+
+# total_size <library-dir>
+total_size() {
+    find $1 -name '*.olean' -print0 | xargs -0 cat | wc -c
+}
+
+# import_time <library-dir> <olean-file>
+import_time() {
+    lib=$1
+    f=$2
+    mod=`echo ${f#$lib/} | sed -e 's/\.olean$//' -e 's|/|.|g'`
+    tst=$TMP_DIR/import_tst.lean
+    echo "import $mod" > $tst
+    LEAN_PATH=$lib $TIME --format="%e" $LEAN $tst 2>&1 > /dev/null
+}
+
+echo "module plain_time lz_time"
+for f in `find $TMP_DIR/plain -name '*.olean'`; do
+    mod=${f#$TMP_DIR/plain/}
+    echo "$mod `import_time $TMP_DIR/plain $f` `import_time $TMP_DIR/lz $TMP_DIR/lz/$mod`"
+done
+echo "total_bytes plain: `total_size $TMP_DIR/plain` lz: `total_size $TMP_DIR/lz`"
@@ -47,6 +47,7 @@ struct be_config {
             s.m_pre_tac_body = e.m_tac;
         }
     }
+    static bool add_entry_reads_env() { return false; }
     static name const & get_class_name() {
         return *g_class_name;
     }
@@ -134,6 +134,7 @@ struct calc_config {
         case calc_cmd::Symm:  s.add_calc_symm(env, e.m_name); break;
         }
     }
+    static bool add_entry_reads_env() { return true; }
     static name const & get_class_name() {
         return *g_calc_name;
     }
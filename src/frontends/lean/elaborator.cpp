@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include "util/lazy_list_fn.h"
 #include "util/sstream.h"
 #include "util/name_map.h"
+#include "util/region.h"
 #include "kernel/abstract.h"
 #include "kernel/instantiate.h"
 #include "kernel/for_each_fn.h"
@@ -1925,14 +1926,25 @@ pair<expr, constraints> elaborator::elaborate_nested(list<expr> const & ctx, opt
 
 static name * g_tmp_prefix = nullptr;
 
+/** \brief Return true if the terms created by the elaborator can be allocated in a region.
+    Remark: only the result is copied out of the region. So, regions are not used when an info_manager is available,
+    since the terms stored in it would keep the region alive. */
+static bool use_region(elaborator_context const & ctx) {
+    return ctx.get_info_manager() == nullptr;
+}
+
 std::tuple<expr, level_param_names> elaborate(elaborator_context & env, list<expr> const & ctx, expr const & e,
                                               bool relax_main_opaque, bool ensure_type, bool nice_mvar_names) {
-    return elaborator(env, name_generator(*g_tmp_prefix), nice_mvar_names)(ctx, e, ensure_type, relax_main_opaque);
+    region_scope scope(use_region(env));
+    auto r = elaborator(env, name_generator(*g_tmp_prefix), nice_mvar_names)(ctx, e, ensure_type, relax_main_opaque);
+    return std::make_tuple(copy_out_of_region(std::get<0>(r)), std::get<1>(r));
 }
 
 std::tuple<expr, expr, level_param_names> elaborate(elaborator_context & env, name const & n, expr const & t, expr const & v,
                                                     bool is_opaque) {
-    return elaborator(env, name_generator(*g_tmp_prefix))(t, v, n, is_opaque);
+    region_scope scope(use_region(env));
+    auto r = elaborator(env, name_generator(*g_tmp_prefix))(t, v, n, is_opaque);
+    return std::make_tuple(copy_out_of_region(std::get<0>(r)), copy_out_of_region(std::get<1>(r)), std::get<2>(r));
 }
 
 void initialize_elaborator() {
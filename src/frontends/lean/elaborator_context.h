@@ -29,6 +29,7 @@ class elaborator_context {
 public:
     elaborator_context(environment const & env, io_state const & ios, local_decls<level> const & lls,
                        pos_info_provider const * pp = nullptr, info_manager * info = nullptr, bool check_unassigned = true);
+    info_manager * get_info_manager() const { return m_info_manager; }
 };
 void initialize_elaborator_context();
 void finalize_elaborator_context();
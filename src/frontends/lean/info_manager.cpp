@@ -8,6 +8,7 @@ Author: Leonardo de Moura
 #include <vector>
 #include <set>
 #include "util/thread.h"
+#include "util/memory.h"
 #include "kernel/environment.h"
 #include "library/choice.h"
 #include "library/scoped_ext.h"
@@ -18,6 +19,7 @@ Author: Leonardo de Moura
 
 namespace lean {
 class info_data;
+static memory_category g_info_memory = 0;
 
 enum class info_kind { Type = 0, ExtraType, Synth, Overload, Coercion, Symbol, Identifier, ProofState };
 bool operator<(info_kind k1, info_kind k2) { return static_cast<unsigned>(k1) < static_cast<unsigned>(k2); }
@@ -80,6 +82,7 @@ struct tmp_info_data : public info_data_cell {
 
 static info_data * g_dummy = nullptr;
 void initialize_info_manager() {
+    g_info_memory = register_memory_category("info_manager");
     g_dummy = new info_data(new tmp_info_data(0));
 }
 
@@ -727,35 +730,71 @@ struct info_manager::imp {
     }
 };
 
-info_manager::info_manager():m_ptr(new imp()) {}
+info_manager::info_manager() { memory_scope scope(g_info_memory); m_ptr.reset(new imp()); }
 info_manager::~info_manager() {}
-void info_manager::add_type_info(unsigned l, unsigned c, expr const & e) { m_ptr->add_type_info(l, c, e); }
-void info_manager::add_extra_type_info(unsigned l, unsigned c, expr const & e, expr const & t) { m_ptr->add_extra_type_info(l, c, e, t); }
-void info_manager::add_synth_info(unsigned l, unsigned c, expr const & e) { m_ptr->add_synth_info(l, c, e); }
-void info_manager::add_overload_info(unsigned l, unsigned c, expr const & e) { m_ptr->add_overload_info(l, c, e); }
-void info_manager::add_overload_notation_info(unsigned l, unsigned c, list<expr> const & a) { m_ptr->add_overload_notation_info(l, c, a); }
-void info_manager::add_coercion_info(unsigned l, unsigned c, expr const & e, expr const & t) { m_ptr->add_coercion_info(l, c, e, t); }
-void info_manager::erase_coercion_info(unsigned l, unsigned c) { m_ptr->erase_coercion_info(l, c); }
-void info_manager::add_symbol_info(unsigned l, unsigned c, name const & s) { m_ptr->add_symbol_info(l, c, s); }
+void info_manager::add_type_info(unsigned l, unsigned c, expr const & e) {
+    memory_scope scope(g_info_memory);
+    m_ptr->add_type_info(l, c, e);
+}
+void info_manager::add_extra_type_info(unsigned l, unsigned c, expr const & e, expr const & t) {
+    memory_scope scope(g_info_memory);
+    m_ptr->add_extra_type_info(l, c, e, t);
+}
+void info_manager::add_synth_info(unsigned l, unsigned c, expr const & e) {
+    memory_scope scope(g_info_memory);
+    m_ptr->add_synth_info(l, c, e);
+}
+void info_manager::add_overload_info(unsigned l, unsigned c, expr const & e) {
+    memory_scope scope(g_info_memory);
+    m_ptr->add_overload_info(l, c, e);
+}
+void info_manager::add_overload_notation_info(unsigned l, unsigned c, list<expr> const & a) {
+    memory_scope scope(g_info_memory);
+    m_ptr->add_overload_notation_info(l, c, a);
+}
+void info_manager::add_coercion_info(unsigned l, unsigned c, expr const & e, expr const & t) {
+    memory_scope scope(g_info_memory);
+    m_ptr->add_coercion_info(l, c, e, t);
+}
+void info_manager::erase_coercion_info(unsigned l, unsigned c) {
+    memory_scope scope(g_info_memory);
+    m_ptr->erase_coercion_info(l, c);
+}
+void info_manager::add_symbol_info(unsigned l, unsigned c, name const & s) {
+    memory_scope scope(g_info_memory);
+    m_ptr->add_symbol_info(l, c, s);
+}
 void info_manager::add_identifier_info(unsigned l, unsigned c, name const & full_id) {
+    memory_scope scope(g_info_memory);
     m_ptr->add_identifier_info(l, c, full_id);
 }
 void info_manager::add_proof_state_info(unsigned l, unsigned c, proof_state const & ps) {
+    memory_scope scope(g_info_memory);
     m_ptr->add_proof_state_info(l, c, ps);
 }
-void info_manager::instantiate(substitution const & s) { m_ptr->instantiate(s); }
-void info_manager::merge(info_manager const & m, bool overwrite) { m_ptr->merge(*m.m_ptr, overwrite); }
-void info_manager::insert_line(unsigned l) { m_ptr->insert_line(l); }
-void info_manager::remove_line(unsigned l) { m_ptr->remove_line(l); }
-void info_manager::invalidate_line(unsigned l) { m_ptr->invalidate_line(l); }
-void info_manager::invalidate_line_col(unsigned l, unsigned c) { m_ptr->invalidate_line_col(l, c); }
-void info_manager::commit_upto(unsigned l, bool valid) { m_ptr->commit_upto(l, valid); }
+void info_manager::instantiate(substitution const & s) { memory_scope scope(g_info_memory); m_ptr->instantiate(s); }
+void info_manager::merge(info_manager const & m, bool overwrite) {
+    memory_scope scope(g_info_memory);
+    m_ptr->merge(*m.m_ptr, overwrite);
+}
+void info_manager::insert_line(unsigned l) { memory_scope scope(g_info_memory); m_ptr->insert_line(l); }
+void info_manager::remove_line(unsigned l) { memory_scope scope(g_info_memory); m_ptr->remove_line(l); }
+void info_manager::invalidate_line(unsigned l) { memory_scope scope(g_info_memory); m_ptr->invalidate_line(l); }
+void info_manager::invalidate_line_col(unsigned l, unsigned c) {
+    memory_scope scope(g_info_memory);
+    m_ptr->invalidate_line_col(l, c);
+}
+void info_manager::commit_upto(unsigned l, bool valid) {
+    memory_scope scope(g_info_memory);
+    m_ptr->commit_upto(l, valid);
+}
 void info_manager::set_processed_upto(unsigned l) { m_ptr->set_processed_upto(l); }
 bool info_manager::is_invalidated(unsigned l) const { return m_ptr->is_invalidated(l); }
 void info_manager::save_environment_options(unsigned l, unsigned c, environment const & env, options const & o) {
+    memory_scope scope(g_info_memory);
     m_ptr->save_environment_options(l, c, env, o);
 }
-void info_manager::clear() { m_ptr->clear(); }
+void info_manager::clear() { memory_scope scope(g_info_memory); m_ptr->clear(); }
 optional<pair<environment, options>> info_manager::get_final_env_opts() const { return m_ptr->get_final_env_opts(); }
 optional<pair<environment, options>> info_manager::get_closest_env_opts(unsigned linenum) const { return m_ptr->get_closest_env_opts(linenum); }
 void info_manager::display(environment const & env, io_state const & ios, unsigned line, optional<unsigned> const & col) const {
@@ -765,8 +804,9 @@ unsigned info_manager::get_processed_upto() const { return m_ptr->m_processed_up
 optional<expr> info_manager::get_type_at(unsigned line, unsigned col) const { return m_ptr->get_type_at(line, col); }
 optional<expr> info_manager::get_meta_at(unsigned line, unsigned col) const { return m_ptr->get_meta_at(line, col); }
 void info_manager::block_new_info() { m_ptr->block_new_info(true); }
-void info_manager::start_from(unsigned l) { m_ptr->start_from(l); }
+void info_manager::start_from(unsigned l) { memory_scope scope(g_info_memory); m_ptr->start_from(l); }
 void info_manager::remove_proof_state_info(unsigned start_line, unsigned start_col, unsigned end_line, unsigned end_col) {
+    memory_scope scope(g_info_memory);
     m_ptr->remove_proof_state_info(start_line, start_col, end_line, end_col);
 }
 }
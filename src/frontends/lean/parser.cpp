@@ -9,6 +9,7 @@ Author: Leonardo de Moura
 #include <limits>
 #include <vector>
 #include "util/interrupt.h"
+#include "util/memory.h"
 #include "util/script_exception.h"
 #include "util/sstream.h"
 #include "util/flet.h"
@@ -1666,10 +1667,13 @@ void parser::add_delayed_theorem(environment const & env, name const & n, level_
     m_theorem_queue.add(env, n, ls, get_local_level_decls(), t, v);
 }
 
+static memory_category g_snapshot_memory = 0;
+
 void parser::save_snapshot() {
     m_pre_info_manager.clear();
     if (!m_snapshot_vector)
         return;
+    memory_scope scope(g_snapshot_memory);
     if (m_snapshot_vector->empty() || static_cast<int>(m_snapshot_vector->back().m_line) != m_scanner.get_line())
         m_snapshot_vector->push_back(snapshot(m_env, m_local_level_decls, m_local_decls,
                                               m_level_variables, m_variables, m_include_vars,
@@ -1752,6 +1756,7 @@ bool parse_commands(environment & env, io_state & ios, char const * fname, bool
 }
 
 void initialize_parser() {
+    g_snapshot_memory        = register_memory_category("snapshots");
     g_parser_show_errors     = new name{"parser", "show_errors"};
     g_parser_parallel_import = new name{"parser", "parallel_import"};
     register_bool_option(*g_parser_show_errors, LEAN_DEFAULT_PARSER_SHOW_ERRORS,
@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #include <string>
 #include "util/sstream.h"
 #include "util/list_fn.h"
+#include "util/memory.h"
 #include "library/scoped_ext.h"
 #include "library/kernel_serializer.h"
 #include "frontends/lean/parser_config.h"
@@ -18,6 +19,8 @@ using notation::transition;
 using notation::action;
 using notation::action_kind;
 
+static memory_category g_parser_tables_memory = 0;
+
 notation_entry replace(notation_entry const & e, std::function<expr(expr const &)> const & f) {
     if (e.is_numeral())
         return notation_entry(e.get_num(), f(e.get_expr()), e.overload(), e.parse_only());
@@ -81,8 +84,10 @@ struct token_config {
     static std::string * g_key;
 
     static void add_entry(environment const &, io_state const &, state & s, entry const & e) {
+        memory_scope scope(g_parser_tables_memory);
         s.m_table = add_token(s.m_table, e.m_token.c_str(), e.m_prec);
     }
+    static bool add_entry_reads_env() { return false; }
     static name const & get_class_name() {
         return *g_class_name;
     }
@@ -233,6 +238,7 @@ struct notation_config {
     }
 
     static void add_entry(environment const &, io_state const &, state & s, entry const & e) {
+        memory_scope scope(g_parser_tables_memory);
         buffer<transition> ts;
         switch (e.kind()) {
         case notation_entry_kind::NuD: {
@@ -264,6 +270,7 @@ struct notation_config {
             }
         }
     }
+    static bool add_entry_reads_env() { return false; }
     static name const & get_class_name() {
         return *g_class_name;
     }
@@ -411,6 +418,7 @@ cmd_table const & get_cmd_table(environment const & env) {
 }
 
 void initialize_parser_config() {
+    g_parser_tables_memory     = register_memory_category("parser tables");
     token_config::g_class_name = new name("notations");
     token_config::g_key        = new std::string("tk");
     token_ext::initialize();
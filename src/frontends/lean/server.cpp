@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include <vector>
 #include "util/sstream.h"
 #include "util/exception.h"
+#include "util/memory.h"
 #include "util/sexpr/option_declarations.h"
 #include "util/bitap_fuzzy_search.h"
 #include "kernel/instantiate.h"
@@ -317,6 +318,7 @@ static std::string * g_valid = nullptr;
 static std::string * g_sleep = nullptr;
 static std::string * g_findp = nullptr;
 static std::string * g_findg = nullptr;
+static std::string * g_memory = nullptr;
 
 static bool is_command(std::string const & cmd, std::string const & line) {
     return line.compare(0, cmd.size(), cmd) == 0;
@@ -547,6 +549,13 @@ void server::show_options() {
     m_out << "-- ENDOPTIONS" << std::endl;
 }
 
+void server::show_memory() {
+    m_out << "-- BEGINMEMORY" << std::endl;
+    for (memory_category_stats const & c : get_memory_category_stats())
+        m_out << "-- " << c.m_name << "|" << c.live() << "|" << c.m_allocated << "|" << c.m_freed << "\n";
+    m_out << "-- ENDMEMORY" << std::endl;
+}
+
 void server::show(bool valid) {
     check_file();
     m_out << "-- BEGINSHOW" << std::endl;
@@ -890,6 +899,8 @@ bool server::operator()(std::istream & in) {
                     process_from(0);
             } else if (is_command(*g_options, line)) {
                 show_options();
+            } else if (is_command(*g_memory, line)) {
+                show_memory();
             } else if (is_command(*g_wait, line)) {
                 optional<unsigned> ms = get_optional_num(line, *g_wait);
                 wait(ms);
@@ -953,6 +964,7 @@ void initialize_server() {
     g_sleep = new std::string("SLEEP");
     g_findp = new std::string("FINDP");
     g_findg = new std::string("FINDG");
+    g_memory = new std::string("MEMORY");
 }
 void finalize_server() {
     delete g_auto_completion_max_results;
@@ -976,5 +988,6 @@ void finalize_server() {
     delete g_sleep;
     delete g_findp;
     delete g_findg;
+    delete g_memory;
 }
 }
@@ -90,6 +90,7 @@ class server {
     void read_line(std::istream & in, std::string & line);
     void interrupt_worker();
     void show_options();
+    void show_memory();
     void show(bool valid);
     void sync(std::vector<std::string> const & lines);
     void wait(optional<unsigned> ms);
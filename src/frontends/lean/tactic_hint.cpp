@@ -30,6 +30,7 @@ struct tactic_hint_config {
         s = cons(e, filter(s, [&](expr const & e1) { return e1 != e; }));
     }
 
+    static bool add_entry_reads_env() { return false; }
     static name const & get_class_name() {
         return *g_class_name;
     }
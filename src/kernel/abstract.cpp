@@ -10,10 +10,12 @@ Author: Leonardo de Moura
 #include "kernel/abstract.h"
 #include "kernel/free_vars.h"
 #include "kernel/replace_fn.h"
+#include "kernel/kernel_stats.h"
 
 namespace lean {
 expr abstract(expr const & e, unsigned s, unsigned n, expr const * subst) {
     lean_assert(std::all_of(subst, subst+n, closed));
+    inc_stat(g_abstract_stat);
     return replace(e, [=](expr const & e, unsigned offset) -> optional<expr> {
             if (closed(e)) {
                 unsigned i = n;
@@ -33,6 +35,7 @@ expr abstract_locals(expr const & e, unsigned n, expr const * subst) {
     lean_assert(std::all_of(subst, subst+n, [](expr const & e) { return closed(e) && is_local(e); }));
     if (!has_local(e))
         return e;
+    inc_stat(g_abstract_stat);
     return replace(e, [=](expr const & m, unsigned offset) -> optional<expr> {
             if (!has_local(m))
                 return some_expr(m); // expression m does not contain local constants
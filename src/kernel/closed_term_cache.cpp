@@ -0,0 +1,114 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <iomanip>
+#include "util/hash.h"
+#include "kernel/closed_term_cache.h"
+
+#ifndef LEAN_CLOSED_TERM_CACHE_SHARDS
+#define LEAN_CLOSED_TERM_CACHE_SHARDS 64
+#endif
+
+namespace lean {
+closed_term_cache::closed_term_cache(environment const & env, unsigned capacity):
+    m_num_shards(LEAN_CLOSED_TERM_CACHE_SHARDS), m_shards(new shard[m_num_shards]),
+    m_shard_capacity(std::max(capacity / m_num_shards, 1u)) {
+    for (unsigned i = 0; i < m_num_shards; i++)
+        m_shards[i].m_entries.resize(m_shard_capacity, entry(env.get_id()));
+}
+
+auto closed_term_cache::get_entry(kind k, expr const & e, unsigned tag, shard * & s) -> entry & {
+    unsigned h = hash(hash(e.hash(), static_cast<unsigned>(k)), tag);
+    s = &m_shards[h % m_num_shards];
+    return s->m_entries[(h / m_num_shards) % m_shard_capacity];
+}
+
+optional<expr> closed_term_cache::find(kind k, environment const & env, expr const & e, unsigned tag,
+                                       level_param_names const & params) {
+    shard * s;
+    entry & it = get_entry(k, e, tag, s);
+    lock_guard<mutex> lock(s->m_mutex);
+    stats & st = s->m_stats[static_cast<unsigned>(k)];
+    st.m_lookups++;
+    if (it.m_key && it.m_kind == k && it.m_tag == tag && it.m_params == params &&
+        is_bi_equal(*it.m_key, e) && env.get_id().is_descendant(it.m_env_id)) {
+        st.m_hits++;
+        return some_expr(it.m_value);
+    }
+    return none_expr();
+}
+
+void closed_term_cache::insert(kind k, environment const & env, expr const & e, expr const & v, unsigned tag,
+                               level_param_names const & params) {
+    lean_assert(is_cacheable(e));
+    shard * s;
+    entry & it = get_entry(k, e, tag, s);
+    lock_guard<mutex> lock(s->m_mutex);
+    it.m_key    = e;
+    it.m_value  = v;
+    it.m_kind   = k;
+    it.m_tag    = tag;
+    it.m_params = params;
+    it.m_env_id = env.get_id();
+}
+
+auto closed_term_cache::get_stats(kind k) const -> stats {
+    stats r;
+    for (unsigned i = 0; i < m_num_shards; i++) {
+        shard & s = m_shards[i];
+        lock_guard<mutex> lock(s.m_mutex);
+        r.m_lookups += s.m_stats[static_cast<unsigned>(k)].m_lookups;
+        r.m_hits    += s.m_stats[static_cast<unsigned>(k)].m_hits;
+    }
+    return r;
+}
+
+void closed_term_cache::display_stats(std::ostream & out) const {
+    static char const * names[num_kinds] = {"whnf_core", "whnf", "infer_type", "check"};
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision     = out.precision();
+    out << "closed term cache, " << m_num_shards * m_shard_capacity << " entries\n";
+    out << "kind          lookups        hits  hit rate\n";
+    for (unsigned i = 0; i < num_kinds; i++) {
+        stats s = get_stats(static_cast<kind>(i));
+        double rate = s.m_lookups == 0 ? 0.0 : 100.0 * static_cast<double>(s.m_hits) / static_cast<double>(s.m_lookups);
+        out << std::left << std::setw(10) << names[i] << std::right << std::setw(12) << s.m_lookups
+            << std::setw(12) << s.m_hits << std::setw(9) << std::fixed << std::setprecision(1) << rate << "%\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+struct closed_term_cache_ext : public environment_extension {
+    closed_term_cache_ptr m_cache;
+};
+
+struct closed_term_cache_ext_reg {
+    unsigned m_ext_id;
+    closed_term_cache_ext_reg() { m_ext_id = environment::register_extension(std::make_shared<closed_term_cache_ext>()); }
+};
+
+static closed_term_cache_ext_reg * g_ext = nullptr;
+
+environment set_closed_term_cache(environment const & env, closed_term_cache_ptr const & c) {
+    auto ext = std::make_shared<closed_term_cache_ext>();
+    ext->m_cache = c;
+    return env.update(g_ext->m_ext_id, ext);
+}
+
+closed_term_cache_ptr const & get_closed_term_cache(environment const & env) {
+    return static_cast<closed_term_cache_ext const &>(env.get_extension(g_ext->m_ext_id)).m_cache;
+}
+
+void initialize_closed_term_cache() {
+    g_ext = new closed_term_cache_ext_reg();
+}
+
+void finalize_closed_term_cache() {
+    delete g_ext;
+}
+}
@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include <iostream>
+#include <vector>
+#include "util/int64.h"
+#include "util/thread.h"
+#include "kernel/environment.h"
+
+namespace lean {
+/**
+   \brief Concurrent and bounded cache shared by the type checkers created by \c check.
+   It stores the results of whnf_core, whnf and infer_type for closed terms, i.e., terms that
+   do not contain free variables, local constants nor metavariables.
+
+   An entry is only used by a type checker whose environment is a descendant of the environment
+   used to compute it. Thus, entries computed by different threads (e.g., threads checking theorems
+   or importing modules) are reused without caring about declarations added in the meantime.
+
+   The cache is a direct mapped table. So, a new entry overwrites the entry in the same slot.
+   The table is split in shards, and each shard is protected by its own mutex.
+
+   \see set_closed_term_cache
+*/
+class closed_term_cache {
+public:
+    enum class kind { WhnfCore, Whnf, InferType, Check };
+    static unsigned const num_kinds = 4;
+    struct stats {
+        uint64 m_lookups;
+        uint64 m_hits;
+        stats():m_lookups(0), m_hits(0) {}
+    };
+private:
+    struct entry {
+        optional<expr>      m_key;
+        expr                m_value;
+        kind                m_kind;
+        unsigned            m_tag;
+        level_param_names   m_params;
+        environment_id      m_env_id;
+        entry(environment_id const & id):m_kind(kind::WhnfCore), m_tag(0), m_env_id(id) {}
+    };
+    struct shard {
+        mutex              m_mutex;
+        std::vector<entry> m_entries;
+        stats              m_stats[num_kinds];
+    };
+    unsigned                 m_num_shards;
+    std::unique_ptr<shard[]> m_shards;
+    unsigned                 m_shard_capacity;
+    entry & get_entry(kind k, expr const & e, unsigned tag, shard * & s);
+public:
+    /** \brief Create a cache with (approximately) \c capacity entries. \c env is any environment,
+        it is only used for initializing the empty entries. */
+    closed_term_cache(environment const & env, unsigned capacity);
+
+    /** \brief Return true if \c e can be stored in the cache. */
+    static bool is_cacheable(expr const & e) { return closed(e) && !has_local(e) && !has_metavar(e); }
+
+    /** \brief Return the result of kind \c k for \c e in \c env (if available).
+        The \c tag and \c params must match the ones used when the entry was inserted.
+        For example, the tag is used to store whether opaque definitions of a module are transparent or not,
+        and \c params are the universe parameters used to check \c e. */
+    optional<expr> find(kind k, environment const & env, expr const & e, unsigned tag = 0,
+                        level_param_names const & params = level_param_names());
+    /** \brief Store the result \c v of kind \c k for \c e in \c env.
+        \pre is_cacheable(e) */
+    void insert(kind k, environment const & env, expr const & e, expr const & v, unsigned tag = 0,
+                level_param_names const & params = level_param_names());
+
+    /** \brief Return the number of lookups and hits for entries of kind \c k. */
+    stats get_stats(kind k) const;
+    /** \brief Display the hit rates of the cache. */
+    void display_stats(std::ostream & out) const;
+};
+typedef std::shared_ptr<closed_term_cache> closed_term_cache_ptr;
+
+/** \brief Return a new environment where the type checkers created by \c check (for this environment and its
+    descendants) share the cache \c c. If \c c is nullptr, then the shared cache is disabled. */
+environment set_closed_term_cache(environment const & env, closed_term_cache_ptr const & c);
+/** \brief Return the cache shared by the type checkers for \c env, nullptr if there is none. */
+closed_term_cache_ptr const & get_closed_term_cache(environment const & env);
+
+void initialize_closed_term_cache();
+void finalize_closed_term_cache();
+}
@@ -9,13 +9,16 @@ Author: Leonardo de Moura
 #include "kernel/for_each_fn.h"
 
 namespace lean {
+static mutex * g_decoder_mutex = nullptr;
+
 struct declaration::cell {
     MK_LEAN_RC();
     name              m_name;
     level_param_names m_params;
     expr              m_type;
     bool              m_theorem;
-    optional<expr>    m_value;        // if none, then declaration is actually a postulate
+    bool              m_definition;   // if false, then declaration is actually a postulate
+    optional<expr>    m_value;
     // The following fields are only meaningful for definitions (which are not theorems)
     unsigned          m_weight;
     unsigned          m_module_idx;   // module idx where it was defined
@@ -27,15 +30,54 @@ struct declaration::cell {
     // we will first check whether a is convertible to b.
     // If the test fails, then we perform the full check.
     bool              m_use_conv_opt;
+    // The following fields are only used by lazy declarations.
+    // The type and/or value are decoded using m_decoder when they are accessed for the first time.
+    enum pending_kind { PendingType = 1, PendingValue = 2 };
+    declaration_decoder_ptr m_decoder;
+    unsigned                m_decoder_idx;
+    atomic_uchar            m_pending;
     void dealloc() { delete this; }
 
     cell(name const & n, level_param_names const & params, expr const & t, bool is_axiom):
-        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_axiom),
-        m_weight(0), m_module_idx(0), m_opaque(true), m_use_conv_opt(false) {}
+        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_axiom), m_definition(false),
+        m_weight(0), m_module_idx(0), m_opaque(true), m_use_conv_opt(false), m_decoder_idx(0), m_pending(0) {}
     cell(name const & n, level_param_names const & params, expr const & t, bool is_thm, expr const & v,
          bool opaque, unsigned w, module_idx mod_idx, bool use_conv_opt):
-        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_thm),
-        m_value(v), m_weight(w), m_module_idx(mod_idx), m_opaque(opaque), m_use_conv_opt(use_conv_opt) {}
+        m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_thm), m_definition(true),
+        m_value(v), m_weight(w), m_module_idx(mod_idx), m_opaque(opaque), m_use_conv_opt(use_conv_opt),
+        m_decoder_idx(0), m_pending(0) {}
+    cell(name const & n, level_param_names const & params, bool is_thm, bool is_def,
+         bool opaque, unsigned w, module_idx mod_idx, bool use_conv_opt, declaration_decoder_ptr const & dec, unsigned idx):
+        m_rc(1), m_name(n), m_params(params), m_theorem(is_thm), m_definition(is_def),
+        m_weight(w), m_module_idx(mod_idx), m_opaque(opaque), m_use_conv_opt(use_conv_opt),
+        m_decoder(dec), m_decoder_idx(idx), m_pending(is_def ? (PendingType | PendingValue) : PendingType) {}
+
+    bool is_pending(pending_kind k) const { return (atomic_load(&m_pending) & k) != 0; }
+
+    /** \brief Decode the type or value, and store the result.
+        The decoder is invoked without holding the lock. If two threads decode the same object,
+        the result of the first one is used. */
+    void decode(pending_kind k) {
+        declaration_decoder_ptr dec;
+        {
+            lock_guard<mutex> lock(*g_decoder_mutex);
+            if (!is_pending(k))
+                return;
+            dec = m_decoder;
+        }
+        expr r = k == PendingType ? dec->decode_type(m_decoder_idx) : dec->decode_value(m_decoder_idx);
+        lock_guard<mutex> lock(*g_decoder_mutex);
+        if (!is_pending(k))
+            return;
+        if (k == PendingType)
+            m_type  = r;
+        else
+            m_value = r;
+        unsigned char new_pending = atomic_load(&m_pending) & ~k;
+        m_pending = new_pending;
+        if (new_pending == 0)
+            m_decoder.reset();
+    }
 };
 
 static declaration * g_dummy = nullptr;
@@ -49,7 +91,7 @@ declaration::~declaration() { if (m_ptr) m_ptr->dec_ref(); }
 declaration & declaration::operator=(declaration const & s) { LEAN_COPY_REF(s); }
 declaration & declaration::operator=(declaration && s) { LEAN_MOVE_REF(s); }
 
-bool declaration::is_definition() const    { return static_cast<bool>(m_ptr->m_value); }
+bool declaration::is_definition() const    { return m_ptr->m_definition; }
 bool declaration::is_constant_assumption() const { return !is_definition(); }
 bool declaration::is_axiom() const         { return is_constant_assumption() && m_ptr->m_theorem; }
 bool declaration::is_theorem() const       { return is_definition() && m_ptr->m_theorem; }
@@ -57,10 +99,19 @@ bool declaration::is_theorem() const       { return is_definition() && m_ptr->m_
 name const & declaration::get_name() const { return m_ptr->m_name; }
 level_param_names const & declaration::get_univ_params() const { return m_ptr->m_params; }
 unsigned declaration::get_num_univ_params() const { return length(get_univ_params()); }
-expr const & declaration::get_type() const { return m_ptr->m_type; }
+expr const & declaration::get_type() const {
+    if (m_ptr->is_pending(cell::PendingType))
+        m_ptr->decode(cell::PendingType);
+    return m_ptr->m_type;
+}
 
 bool declaration::is_opaque() const { return m_ptr->m_opaque; }
-expr const & declaration::get_value() const { lean_assert(is_definition()); return *(m_ptr->m_value); }
+expr const & declaration::get_value() const {
+    lean_assert(is_definition());
+    if (m_ptr->is_pending(cell::PendingValue))
+        m_ptr->decode(cell::PendingValue);
+    return *(m_ptr->m_value);
+}
 unsigned declaration::get_weight() const { return m_ptr->m_weight; }
 module_idx declaration::get_module_idx() const { return m_ptr->m_module_idx; }
 bool declaration::use_conv_opt() const { return m_ptr->m_use_conv_opt; }
@@ -92,11 +143,29 @@ declaration mk_constant_assumption(name const & n, level_param_names const & par
     return declaration(new declaration::cell(n, params, t, false));
 }
 
+declaration mk_lazy_definition(name const & n, level_param_names const & params, bool opaque, unsigned weight,
+                               module_idx mod_idx, bool use_conv_opt, declaration_decoder_ptr const & dec, unsigned idx) {
+    return declaration(new declaration::cell(n, params, false, true, opaque, weight, mod_idx, use_conv_opt, dec, idx));
+}
+declaration mk_lazy_theorem(name const & n, level_param_names const & params, module_idx mod_idx,
+                            declaration_decoder_ptr const & dec, unsigned idx) {
+    return declaration(new declaration::cell(n, params, true, true, true, 0, mod_idx, false, dec, idx));
+}
+declaration mk_lazy_axiom(name const & n, level_param_names const & params, declaration_decoder_ptr const & dec, unsigned idx) {
+    return declaration(new declaration::cell(n, params, true, false, true, 0, 0, false, dec, idx));
+}
+declaration mk_lazy_constant_assumption(name const & n, level_param_names const & params,
+                                        declaration_decoder_ptr const & dec, unsigned idx) {
+    return declaration(new declaration::cell(n, params, false, false, true, 0, 0, false, dec, idx));
+}
+
 void initialize_declaration() {
+    g_decoder_mutex = new mutex();
     g_dummy = new declaration(mk_axiom(name(), level_param_names(), expr()));
 }
 
 void finalize_declaration() {
     delete g_dummy;
+    delete g_decoder_mutex;
 }
 }
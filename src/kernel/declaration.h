@@ -8,6 +8,7 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <string>
 #include <limits>
+#include <memory>
 #include "util/rc.h"
 #include "kernel/expr.h"
 
@@ -27,6 +28,21 @@ typedef unsigned module_idx;
 constexpr module_idx g_main_module_idx = 0;
 constexpr module_idx g_null_module_idx = std::numeric_limits<unsigned>::max();
 
+/**
+    \brief Object for decoding the type and value of declarations on demand.
+    It is used to implement lazy loading of declarations (e.g., from .olean files).
+    The argument \c idx identifies the declaration in the decoder.
+
+    \remark The methods may be invoked concurrently by different threads.
+*/
+class declaration_decoder {
+public:
+    virtual ~declaration_decoder() {}
+    virtual expr decode_type(unsigned idx) const = 0;
+    virtual expr decode_value(unsigned idx) const = 0;
+};
+typedef std::shared_ptr<declaration_decoder const> declaration_decoder_ptr;
+
 /** \brief Environment definitions, theorems, axioms and variable declarations. */
 class declaration {
     struct cell;
@@ -77,6 +93,14 @@ public:
     friend declaration mk_theorem(name const & n, level_param_names const & params, expr const & t, expr const & v, module_idx mod_idx);
     friend declaration mk_axiom(name const & n, level_param_names const & params, expr const & t);
     friend declaration mk_constant_assumption(name const & n, level_param_names const & params, expr const & t);
+
+    friend declaration mk_lazy_definition(name const & n, level_param_names const & params, bool opaque, unsigned weight,
+                                          module_idx mod_idx, bool use_conv_opt, declaration_decoder_ptr const & dec, unsigned idx);
+    friend declaration mk_lazy_theorem(name const & n, level_param_names const & params, module_idx mod_idx,
+                                       declaration_decoder_ptr const & dec, unsigned idx);
+    friend declaration mk_lazy_axiom(name const & n, level_param_names const & params, declaration_decoder_ptr const & dec, unsigned idx);
+    friend declaration mk_lazy_constant_assumption(name const & n, level_param_names const & params,
+                                                   declaration_decoder_ptr const & dec, unsigned idx);
 };
 
 inline optional<declaration> none_declaration() { return optional<declaration>(); }
@@ -91,6 +115,16 @@ declaration mk_theorem(name const & n, level_param_names const & params, expr co
 declaration mk_axiom(name const & n, level_param_names const & params, expr const & t);
 declaration mk_constant_assumption(name const & n, level_param_names const & params, expr const & t);
 
+/** \brief Lazy declarations. Their type and value are only decoded (using \c dec) when
+    they are accessed for the first time. */
+declaration mk_lazy_definition(name const & n, level_param_names const & params, bool opaque, unsigned weight,
+                               module_idx mod_idx, bool use_conv_opt, declaration_decoder_ptr const & dec, unsigned idx);
+declaration mk_lazy_theorem(name const & n, level_param_names const & params, module_idx mod_idx,
+                            declaration_decoder_ptr const & dec, unsigned idx);
+declaration mk_lazy_axiom(name const & n, level_param_names const & params, declaration_decoder_ptr const & dec, unsigned idx);
+declaration mk_lazy_constant_assumption(name const & n, level_param_names const & params,
+                                        declaration_decoder_ptr const & dec, unsigned idx);
+
 void initialize_declaration();
 void finalize_declaration();
 }
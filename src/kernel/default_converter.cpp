@@ -4,18 +4,35 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <unordered_map>
 #include "util/interrupt.h"
 #include "util/flet.h"
 #include "kernel/default_converter.h"
 #include "kernel/instantiate.h"
 #include "kernel/free_vars.h"
 #include "kernel/type_checker.h"
+#include "kernel/kernel_stats.h"
+
+#ifndef LEAN_DEFAULT_CLOSURE_WHNF
+#define LEAN_DEFAULT_CLOSURE_WHNF false
+#endif
+
+#ifndef LEAN_DEFEQ_FAILURE_CACHE_CAPACITY
+#define LEAN_DEFEQ_FAILURE_CACHE_CAPACITY 1024
+#endif
 
 namespace lean {
 static expr * g_dont_care = nullptr;
+static atomic<bool> g_closure_whnf(LEAN_DEFAULT_CLOSURE_WHNF);
 
-default_converter::default_converter(environment const & env, optional<module_idx> mod_idx, bool memoize):
-    m_env(env), m_module_idx(mod_idx), m_memoize(memoize) {
+void set_closure_whnf(bool flag) { g_closure_whnf = flag; }
+bool get_closure_whnf() { return g_closure_whnf; }
+
+default_converter::default_converter(environment const & env, optional<module_idx> mod_idx, bool memoize,
+                                     closed_term_cache_ptr const & shared_cache):
+    m_env(env), m_module_idx(mod_idx), m_memoize(memoize), m_closure_whnf(g_closure_whnf),
+    m_failure_cache(LEAN_DEFEQ_FAILURE_CACHE_CAPACITY),
+    m_shared_cache(shared_cache) {
     m_tc  = nullptr;
     m_jst = nullptr;
 }
@@ -32,8 +49,13 @@ optional<expr> default_converter::expand_macro(expr const & m) {
     return macro_def(m).expand(m, get_extension(*m_tc));
 }
 
-/** \brief Apply normalizer extensions to \c e. */
+/** \brief Apply normalizer extensions to \c e.
+    Applications of definitions implemented by an extension are only reduced if this converter can unfold them,
+    otherwise the result would depend on whether the definition is opaque or not. For example, the elaborator
+    must not prove (0 + 0 = 0) using a converter that only unfolds reducible definitions. */
 optional<pair<expr, constraint_seq>> default_converter::norm_ext(expr const & e) {
+    if (is_app(e) && m_env.norm_ext().is_builtin(m_env, get_app_fn(e)) && !is_builtin_app(e))
+        return none_ecs();
     return m_env.norm_ext()(e, get_extension(*m_tc));
 }
 
@@ -55,6 +77,104 @@ bool default_converter::may_reduce_later(expr const & e, type_checker & c) {
     return static_cast<bool>(m_env.norm_ext().may_reduce_later(e, get_extension(c)));
 }
 
+/** \brief Term \c m_expr where the loose bound variable i is the closure at position i in \c m_env. */
+struct whnf_closure {
+    expr               m_expr;
+    list<whnf_closure> m_env;
+    whnf_closure(expr const & e, list<whnf_closure> const & env):m_expr(e), m_env(env) {}
+};
+
+/** \brief Apply pending substitutions. The closures are stored in immutable lists (and the buffer of arguments),
+    so they are identified by their addresses, and each one is materialized at most once. */
+class materialize_fn {
+    std::unordered_map<whnf_closure const *, expr> m_cache;
+public:
+    expr operator()(expr const & e, list<whnf_closure> const & env) {
+        unsigned range = get_free_var_range(e);
+        if (range == 0 || is_nil(env))
+            return e;
+        buffer<expr> s;
+        for (whnf_closure const & c : env) {
+            if (s.size() == range)
+                break; // e does not contain the remaining variables
+            s.push_back(operator()(c));
+        }
+        return instantiate(e, s.size(), s.data());
+    }
+
+    expr operator()(whnf_closure const & c) {
+        auto it = m_cache.find(&c);
+        if (it != m_cache.end())
+            return it->second;
+        expr r = operator()(c.m_expr, c.m_env);
+        m_cache.insert(mk_pair(&c, r));
+        return r;
+    }
+};
+
+/** \brief Similar to the App and Macro cases of whnf_core, but the bodies of the lambdas are not instantiated
+    at every beta reduction step. The reduction is performed by an abstract machine where the current head
+    is paired with the pending substitution (a list of closures), and the arguments are closures.
+    The substitutions are only applied when the result is produced. */
+expr default_converter::whnf_core_closures(expr const & e) {
+    expr t = e;
+    list<whnf_closure> env;
+    buffer<whnf_closure> args; // reversed arguments
+    bool reduced = false;
+    while (true) {
+        switch (t.kind()) {
+        case expr_kind::Var: {
+            unsigned idx = var_idx(t);
+            list<whnf_closure> it = env;
+            for (unsigned i = 0; i < idx && !is_nil(it); i++)
+                it = tail(it);
+            if (is_nil(it)) {
+                // variable is not in the pending substitution
+                t   = mk_var(idx - length(env));
+                env = list<whnf_closure>();
+                break;
+            }
+            whnf_closure const & c = head(it);
+            t   = c.m_expr;
+            env = c.m_env;
+            continue;
+        }
+        case expr_kind::App:
+            args.push_back(whnf_closure(app_arg(t), env));
+            t = app_fn(t);
+            continue;
+        case expr_kind::Lambda:
+            if (args.empty())
+                break;
+            check_system("whnf");
+            env = cons(args.back(), env);
+            args.pop_back();
+            t   = binding_body(t);
+            reduced = true;
+            continue;
+        case expr_kind::Macro:
+            if (auto m = expand_macro(materialize_fn()(t, env))) {
+                t   = *m;
+                env = list<whnf_closure>();
+                reduced = true;
+                continue;
+            }
+            break;
+        case expr_kind::Sort: case expr_kind::Meta: case expr_kind::Local:
+        case expr_kind::Pi:   case expr_kind::Constant:
+            break;
+        }
+        break;
+    }
+    if (!reduced)
+        return e;
+    materialize_fn materialize;
+    buffer<expr> new_args;
+    for (whnf_closure const & c : args)
+        new_args.push_back(materialize(c));
+    return mk_rev_app(materialize(t, env), new_args);
+}
+
 /** \brief Weak head normal form core procedure. It does not perform delta reduction nor normalization extensions. */
 expr default_converter::whnf_core(expr const & e) {
     check_system("whnf");
@@ -68,46 +188,64 @@ expr default_converter::whnf_core(expr const & e) {
         break;
     }
 
+    inc_stat(g_whnf_core_stat);
     // check cache
     if (m_memoize) {
         auto it = m_whnf_core_cache.find(e);
-        if (it != m_whnf_core_cache.end())
+        if (it != m_whnf_core_cache.end()) {
+            inc_stat(g_whnf_core_cache_hit_stat);
             return it->second;
+        }
+    }
+    bool shared = m_shared_cache && closed_term_cache::is_cacheable(e);
+    if (shared) {
+        if (auto r = m_shared_cache->find(closed_term_cache::kind::WhnfCore, m_env, e, get_shared_cache_tag())) {
+            inc_stat(g_whnf_core_shared_cache_hit_stat);
+            if (m_memoize)
+                m_whnf_core_cache.insert(mk_pair(e, *r));
+            return *r;
+        }
     }
 
     // do the actual work
     expr r;
-    switch (e.kind()) {
-    case expr_kind::Var:    case expr_kind::Sort: case expr_kind::Meta: case expr_kind::Local:
-    case expr_kind::Pi:   case expr_kind::Constant: case expr_kind::Lambda:
-        lean_unreachable(); // LCOV_EXCL_LINE
-    case expr_kind::Macro:
-        if (auto m = expand_macro(e))
-            r = whnf_core(*m);
-        else
-            r = e;
-        break;
-    case expr_kind::App: {
-        buffer<expr> args;
-        expr f0 = get_app_rev_args(e, args);
-        expr f = whnf_core(f0);
-        if (is_lambda(f)) {
-            unsigned m = 1;
-            unsigned num_args = args.size();
-            while (is_lambda(binding_body(f)) && m < num_args) {
-                f = binding_body(f);
-                m++;
+    if (m_closure_whnf) {
+        r = whnf_core_closures(e);
+    } else {
+        switch (e.kind()) {
+        case expr_kind::Var:    case expr_kind::Sort: case expr_kind::Meta: case expr_kind::Local:
+        case expr_kind::Pi:   case expr_kind::Constant: case expr_kind::Lambda:
+            lean_unreachable(); // LCOV_EXCL_LINE
+        case expr_kind::Macro:
+            if (auto m = expand_macro(e))
+                r = whnf_core(*m);
+            else
+                r = e;
+            break;
+        case expr_kind::App: {
+            buffer<expr> args;
+            expr f0 = get_app_rev_args(e, args);
+            expr f = whnf_core(f0);
+            if (is_lambda(f)) {
+                unsigned m = 1;
+                unsigned num_args = args.size();
+                while (is_lambda(binding_body(f)) && m < num_args) {
+                    f = binding_body(f);
+                    m++;
+                }
+                lean_assert(m <= num_args);
+                r = whnf_core(mk_rev_app(instantiate(binding_body(f), m, args.data() + (num_args - m)), num_args - m, args.data()));
+            } else {
+                r = f == f0 ? e : whnf_core(mk_rev_app(f, args.size(), args.data()));
             }
-            lean_assert(m <= num_args);
-            r = whnf_core(mk_rev_app(instantiate(binding_body(f), m, args.data() + (num_args - m)), num_args - m, args.data()));
-        } else {
-            r = f == f0 ? e : whnf_core(mk_rev_app(f, args.size(), args.data()));
-        }
-        break;
-    }}
+            break;
+        }}
+    }
 
     if (m_memoize)
         m_whnf_core_cache.insert(mk_pair(e, r));
+    if (shared)
+        m_shared_cache->insert(closed_term_cache::kind::WhnfCore, m_env, e, r, get_shared_cache_tag());
     return r;
 }
 
@@ -124,8 +262,10 @@ expr default_converter::unfold_name_core(expr e, unsigned w) {
     if (is_constant(e)) {
         if (auto d = m_env.find(const_name(e))) {
             if (d->is_definition() && !is_opaque(*d) && d->get_weight() >= w &&
-                length(const_levels(e)) == d->get_num_univ_params())
+                length(const_levels(e)) == d->get_num_univ_params()) {
+                inc_stat(g_delta_stat, const_name(e));
                 return unfold_name_core(instantiate_value_univ_params(*d, const_levels(e)), w);
+            }
         }
     }
     return e;
@@ -177,13 +317,26 @@ optional<declaration> default_converter::is_delta(expr const & e) const {
 */
 expr default_converter::whnf_core(expr e, unsigned w) {
     while (true) {
-        expr new_e = unfold_names(whnf_core(e), w);
+        expr e1 = whnf_core(e);
+        if (is_builtin_app(e1))
+            return e1; // the normalizer extensions must be tried before unfolding e1
+        expr new_e = unfold_names(e1, w);
         if (is_eqp(e, new_e))
             return e;
         e = new_e;
     }
 }
 
+bool default_converter::is_builtin_app(expr const & e) const {
+    if (!is_app(e))
+        return false;
+    expr const & fn = get_app_fn(e);
+    if (!is_constant(fn) || !m_env.norm_ext().is_builtin(m_env, fn))
+        return false;
+    auto d = m_env.find(const_name(fn));
+    return d && d->is_definition() && !is_opaque(*d);
+}
+
 /** \brief Put expression \c t in weak head normal form */
 pair<expr, constraint_seq> default_converter::whnf(expr const & e_prime) {
     // Do not cache easy cases
@@ -194,24 +347,44 @@ pair<expr, constraint_seq> default_converter::whnf(expr const & e_prime) {
         break;
     }
 
+    inc_stat(g_whnf_stat);
     expr e = e_prime;
     // check cache
     if (m_memoize) {
         auto it = m_whnf_cache.find(e);
-        if (it != m_whnf_cache.end())
+        if (it != m_whnf_cache.end()) {
+            inc_stat(g_whnf_cache_hit_stat);
             return it->second;
+        }
+    }
+    bool shared = m_shared_cache && closed_term_cache::is_cacheable(e);
+    if (shared) {
+        if (auto r = m_shared_cache->find(closed_term_cache::kind::Whnf, m_env, e, get_shared_cache_tag())) {
+            inc_stat(g_whnf_shared_cache_hit_stat);
+            auto p = to_ecs(*r);
+            if (m_memoize)
+                m_whnf_cache.insert(mk_pair(e, p));
+            return p;
+        }
     }
 
     expr t = e;
     constraint_seq cs;
     while (true) {
         expr t1 = whnf_core(t, 0);
+        expr t2;
         if (auto new_t = d_norm_ext(t1, cs)) {
             t  = *new_t;
+        } else if (is_builtin_app(t1) && !is_eqp(t1, (t2 = unfold_names(t1, 0)))) {
+            // the extension failed to reduce t1
+            t  = t2;
         } else {
             auto r = mk_pair(t1, cs);
             if (m_memoize)
                 m_whnf_cache.insert(mk_pair(e, r));
+            // Remark: results containing constraints are not shared.
+            if (shared && !cs)
+                m_shared_cache->insert(closed_term_cache::kind::Whnf, m_env, e, t1, get_shared_cache_tag());
             return r;
         }
     }
@@ -459,6 +632,20 @@ pair<bool, constraint_seq> default_converter::is_def_eq_core(expr const & t, exp
     while (true) {
         // first, keep applying lazy delta-reduction while applicable
         while (true) {
+            // definitions implemented by normalizer extensions are not unfolded if the extension succeeds.
+            // Remark: they are unfolded when t_n or s_n contains metavariables. For example, the unifier must
+            // solve (?m * 0 + 0 =?= n * 0 + 0) by comparing ?m * 0 with n * 0, evaluating n * 0 + 0 to 0
+            // would leave ?m unassigned.
+            if (!has_expr_metavar(t_n) && !has_expr_metavar(s_n)) {
+                if (is_builtin_app(t_n)) {
+                    if (auto new_t_n = d_norm_ext(t_n, cs))
+                        t_n = whnf_core(*new_t_n);
+                }
+                if (is_builtin_app(s_n)) {
+                    if (auto new_s_n = d_norm_ext(s_n, cs))
+                        s_n = whnf_core(*new_s_n);
+                }
+            }
             auto d_t = is_delta(t_n);
             auto d_s = is_delta(s_n);
             if (!d_t && !d_s) {
@@ -497,9 +684,14 @@ pair<bool, constraint_seq> default_converter::is_def_eq_core(expr const & t, exp
             r = quick_is_def_eq(t_n, s_n, cs);
             if (r != l_undef) return to_bcs(r == l_true, cs);
         }
-        // try normalizer extensions
-        auto new_t_n = d_norm_ext(t_n, cs);
-        auto new_s_n = d_norm_ext(s_n, cs);
+        // try normalizer extensions, definitions implemented by them were already unfolded if t_n or s_n
+        // contains metavariables
+        bool has_mvar = has_expr_metavar(t_n) || has_expr_metavar(s_n);
+        optional<expr> new_t_n, new_s_n;
+        if (!has_mvar || !is_builtin_app(t_n))
+            new_t_n = d_norm_ext(t_n, cs);
+        if (!has_mvar || !is_builtin_app(s_n))
+            new_s_n = d_norm_ext(s_n, cs);
         if (!new_t_n && !new_s_n)
             break; // t_n and s_n are in weak head normal form
         if (new_t_n)
@@ -547,10 +739,25 @@ pair<bool, constraint_seq> default_converter::is_def_eq_core(expr const & t, exp
     return to_bcs(false);
 }
 
+/** \brief Return true if the result of is_def_eq(t, s) can be stored in the failure cache. */
+static bool use_failure_cache(expr const & t, expr const & s) {
+    return closed(t) && closed(s) && !has_metavar(t) && !has_metavar(s);
+}
+
 pair<bool, constraint_seq> default_converter::is_def_eq(expr const & t, expr const & s) {
+    inc_stat(g_is_def_eq_stat);
+    if (is_eqp(t, s))
+        inc_stat(g_is_def_eq_eqp_stat);
+    bool use_failure = m_memoize && use_failure_cache(t, s);
+    if (use_failure && m_failure_cache.contains(t, s)) {
+        inc_stat(g_is_def_eq_failure_cache_hit_stat);
+        return to_bcs(false);
+    }
     auto r = is_def_eq_core(t, s);
     if (r.first && !r.second)
         m_eqv_manager.add_equiv(t, s);
+    else if (!r.first && use_failure)
+        m_failure_cache.insert(t, s);
     return r;
 }
 
@@ -11,6 +11,8 @@ Author: Leonardo de Moura
 #include "kernel/converter.h"
 #include "kernel/expr_maps.h"
 #include "kernel/equiv_manager.h"
+#include "kernel/expr_cache.h"
+#include "kernel/closed_term_cache.h"
 
 namespace lean {
 /** \breif Converter used in the kernel */
@@ -19,9 +21,14 @@ protected:
     environment                                 m_env;
     optional<module_idx>                        m_module_idx;
     bool                                        m_memoize;
+    bool                                        m_closure_whnf; // see set_closure_whnf
     expr_struct_map<expr>                       m_whnf_core_cache;
     expr_struct_map<pair<expr, constraint_seq>> m_whnf_cache;
     equiv_manager                               m_eqv_manager;
+    // Pairs (t, s) of closed terms without metavariables such that is_def_eq(t, s) failed.
+    // The result cannot change since the environment is fixed.
+    expr_pair_cache                             m_failure_cache;
+    closed_term_cache_ptr                       m_shared_cache; // nullptr if there is no cache shared with other converters
 
     // The two auxiliary fields are set when the public methods whnf and is_def_eq are invoked.
     // The goal is to avoid to keep carrying them around.
@@ -36,9 +43,15 @@ protected:
     optional<expr> expand_macro(expr const & m);
     optional<expr> d_norm_ext(expr const & e, constraint_seq & cs);
     expr whnf_core(expr const & e);
+    expr whnf_core_closures(expr const & e);
     expr unfold_name_core(expr e, unsigned w);
     expr unfold_names(expr const & e, unsigned w);
     expr whnf_core(expr e, unsigned w);
+    /** \brief Return true if \c e is an application of a definition implemented by a normalizer extension,
+        and this converter can unfold the definition. \see normalizer_extension::is_builtin */
+    bool is_builtin_app(expr const & e) const;
+    /** \brief Tag used for the entries of the shared cache, opaque definitions of m_module_idx are transparent. */
+    unsigned get_shared_cache_tag() const { return m_module_idx ? *m_module_idx + 1 : 0; }
 
     expr whnf(expr const & e_prime, constraint_seq & cs);
 
@@ -73,7 +86,8 @@ protected:
     pair<bool, constraint_seq> is_def_eq(expr const & t, expr const & s);
 
 public:
-    default_converter(environment const & env, optional<module_idx> mod_idx, bool memoize = true);
+    default_converter(environment const & env, optional<module_idx> mod_idx, bool memoize = true,
+                      closed_term_cache_ptr const & shared_cache = closed_term_cache_ptr());
     default_converter(environment const & env, bool relax_main_opaque, bool memoize = true);
 
     virtual optional<declaration> is_delta(expr const & e) const;
@@ -85,6 +99,13 @@ public:
     virtual pair<bool, constraint_seq> is_def_eq(expr const & t, expr const & s, type_checker & c, delayed_justification & jst);
 };
 
+/** \brief Select the procedure used by the default converter for beta reduction in whnf_core.
+    If \c flag is true, then the head is reduced using closures, i.e., terms paired with pending substitutions,
+    and the substitutions are only applied to the resulting head and arguments. Otherwise, the bodies are
+    instantiated eagerly at every beta reduction step. The flag affects converters created after the call. */
+void set_closure_whnf(bool flag);
+bool get_closure_whnf();
+
 void initialize_default_converter();
 void finalize_default_converter();
 }
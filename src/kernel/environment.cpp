@@ -110,6 +110,10 @@ environment environment::add(declaration const & d) const {
     return environment(m_header, m_id, insert(m_declarations, n, d), m_global_levels, m_extensions);
 }
 
+certified_declaration certify_unchecked(environment const & env, declaration const & d) {
+    return certified_declaration(env.get_id(), d);
+}
+
 environment environment::add(certified_declaration const & d) const {
     if (!m_id.is_descendant(d.get_id()))
         throw_incompatible_environment(*this);
@@ -208,6 +212,15 @@ environment environment::update(unsigned id, std::shared_ptr<environment_extensi
     return environment(m_header, m_id, m_declarations, m_global_levels, new_exts);
 }
 
+environment environment::update(unsigned id, environment const & src) const {
+    if (!get_extension_manager().has_ext(id))
+        throw_invalid_extension(*this);
+    if (id < src.m_extensions->size())
+        return update(id, (*src.m_extensions)[id]);
+    else
+        return update(id, std::shared_ptr<environment_extension const>());
+}
+
 void environment::for_each_declaration(std::function<void(declaration const & d)> const & f) const {
     m_declarations.for_each([&](name const &, declaration const & d) { return f(d); });
 }
@@ -200,6 +200,9 @@ public:
     /** \brief Update the environment extension with the given id. */
     environment update(unsigned extid, std::shared_ptr<environment_extension const> const & ext) const;
 
+    /** \brief Update the environment extension with the given id using the value it has in \c src. */
+    environment update(unsigned extid, environment const & src) const;
+
     /**
         \brief Return a new environment, where its "history" has been truncated/forgotten.
         That is, <tt>is_descendant(e)</tt> will return false for any environment \c e that
@@ -225,6 +228,7 @@ class name_generator;
 */
 class certified_declaration {
     friend certified_declaration check(environment const & env, declaration const & d, name_generator const & g);
+    friend certified_declaration certify_unchecked(environment const & env, declaration const & d);
     environment_id m_id;
     declaration    m_declaration;
     certified_declaration(environment_id const & id, declaration const & d):m_id(id), m_declaration(d) {}
@@ -233,4 +237,12 @@ public:
     environment_id const & get_id() const { return m_id; }
     declaration const & get_declaration() const { return m_declaration; }
 };
+
+/** \brief Create a certified declaration for \c d without type checking it.
+
+    \remark This function is only used to import declarations that have already been type checked
+    in an equivalent environment (see import certificates in library/module.h).
+    It must not be used for any other purpose.
+*/
+certified_declaration certify_unchecked(environment const & env, declaration const & d);
 }
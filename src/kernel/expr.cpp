@@ -16,10 +16,12 @@ Author: Leonardo de Moura
 #include "util/object_serializer.h"
 #include "util/lru_cache.h"
 #include "util/memory_pool.h"
+#include "util/region.h"
 #include "kernel/expr.h"
 #include "kernel/expr_eq_fn.h"
 #include "kernel/free_vars.h"
 #include "kernel/for_each_fn.h"
+#include "kernel/kernel_stats.h"
 
 #ifndef LEAN_INITIAL_EXPR_CACHE_CAPACITY
 #define LEAN_INITIAL_EXPR_CACHE_CAPACITY 1024*16
@@ -50,6 +52,18 @@ unsigned hash_levels(levels const & ls) {
     return r;
 }
 
+/** \brief Return the 64-bit hash code \c h of the atomic data stored in an expression of kind \c k. */
+static uint64 mk_hash64(expr_kind k, uint64 h) {
+    return hash64(static_cast<uint64>(k) + 1, h);
+}
+
+static uint64 levels_hash64(levels const & ls) {
+    uint64 r = 23;
+    for (auto const & l : ls)
+        r = hash64(r, l.hash64());
+    return r;
+}
+
 LEAN_THREAD_VALUE(unsigned, g_hash_alloc_counter, 0);
 
 expr_cell::expr_cell(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv,
@@ -60,9 +74,12 @@ expr_cell::expr_cell(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv
     m_has_univ_mv(has_univ_mv),
     m_has_local(has_local),
     m_has_param_univ(has_param_univ),
+    m_region(0),
     m_hash(h),
+    m_hash_hi(0),
     m_tag(g),
     m_rc(0) {
+    inc_stat(g_expr_cell_stat[static_cast<unsigned>(k)]);
     // m_hash_alloc does not need to be a unique identifier.
     // We want diverse hash codes because given expr_cell * c1 and expr_cell * c2,
     // if c1 != c2, then there is high probability c1->m_hash_alloc != c2->m_hash_alloc.
@@ -109,17 +126,29 @@ bool is_meta(expr const & e) {
     return is_metavar(get_app_fn(e));
 }
 
+static_assert(LEAN_MAX_REGIONS <= (1u << 12), "LEAN_MAX_REGIONS does not fit in expr_cell::m_region");
+
+/** \brief Release the memory of a cell that has been destructed. \c r is the region where the cell was allocated. */
+static void recycle_cell(memory_pool & (*pool)(), void * c, unsigned r) {
+    if (r)
+        region_recycle(r);
+    else
+        pool().recycle(c);
+}
+
 // Expr variables
 DEF_THREAD_MEMORY_POOL(get_var_allocator, sizeof(expr_var));
 expr_var::expr_var(unsigned idx, tag g):
     expr_cell(expr_kind::Var, idx, false, false, false, false, g),
     m_vidx(idx) {
+    set_hash64(mk_hash64(expr_kind::Var, idx));
     if (idx == std::numeric_limits<unsigned>::max())
         throw exception("invalid free variable index, de Bruijn index is too big");
 }
 void expr_var::dealloc() {
+    unsigned r = m_region;
     this->~expr_var();
-    get_var_allocator().recycle(this);
+    recycle_cell(get_var_allocator, this, r);
 }
 
 // Expr constants
@@ -129,10 +158,12 @@ expr_const::expr_const(name const & n, levels const & ls, tag g):
               has_meta(ls), false, has_param(ls), g),
     m_name(n),
     m_levels(ls) {
+    set_hash64(::lean::hash64(mk_hash64(expr_kind::Constant, n.hash64()), levels_hash64(ls)));
 }
 void expr_const::dealloc() {
+    unsigned r = m_region;
     this->~expr_const();
-    get_const_allocator().recycle(this);
+    recycle_cell(get_const_allocator, this, r);
 }
 
 unsigned binder_info::hash() const {
@@ -146,11 +177,14 @@ expr_mlocal::expr_mlocal(bool is_meta, name const & n, expr const & t, tag g):
                    !is_meta || t.has_local(), t.has_param_univ(),
                    1, get_free_var_range(t), g),
     m_name(n),
-    m_type(t) {}
+    m_type(t) {
+    set_hash64(mk_hash64(kind(), n.hash64()));
+}
 void expr_mlocal::dealloc(buffer<expr_cell*> & todelete) {
     dec_ref(m_type, todelete);
+    unsigned r = m_region;
     this->~expr_mlocal();
-    get_mlocal_allocator().recycle(this);
+    recycle_cell(get_mlocal_allocator, this, r);
 }
 
 DEF_THREAD_MEMORY_POOL(get_local_allocator, sizeof(expr_local));
@@ -160,8 +194,9 @@ expr_local::expr_local(name const & n, name const & pp_name, expr const & t, bin
     m_bi(bi) {}
 void expr_local::dealloc(buffer<expr_cell*> & todelete) {
     dec_ref(m_type, todelete);
+    unsigned r = m_region;
     this->~expr_local();
-    get_local_allocator().recycle(this);
+    recycle_cell(get_local_allocator, this, r);
 }
 
 // Composite expressions
@@ -184,12 +219,14 @@ expr_app::expr_app(expr const & fn, expr const & arg, tag g):
                    g),
     m_fn(fn), m_arg(arg) {
     m_hash = ::lean::hash(m_hash, m_weight);
+    set_hash64(::lean::hash64(::lean::hash64(fn.hash64(), arg.hash64()), m_weight));
 }
 void expr_app::dealloc(buffer<expr_cell*> & todelete) {
     dec_ref(m_fn, todelete);
     dec_ref(m_arg, todelete);
+    unsigned r = m_region;
     this->~expr_app();
-    get_app_allocator().recycle(this);
+    recycle_cell(get_app_allocator, this, r);
 }
 
 static unsigned dec(unsigned k) { return k == 0 ? 0 : k - 1; }
@@ -217,13 +254,15 @@ expr_binding::expr_binding(expr_kind k, name const & n, expr const & t, expr con
     m_binder(n, t, i),
     m_body(b) {
     m_hash = ::lean::hash(m_hash, m_weight);
+    set_hash64(::lean::hash64(::lean::hash64(t.hash64(), b.hash64()), m_weight));
     lean_assert(k == expr_kind::Lambda || k == expr_kind::Pi);
 }
 void expr_binding::dealloc(buffer<expr_cell*> & todelete) {
     dec_ref(m_body, todelete);
     dec_ref(m_binder.m_type, todelete);
+    unsigned r = m_region;
     this->~expr_binding();
-    get_binding_allocator().recycle(this);
+    recycle_cell(get_binding_allocator, this, r);
 }
 
 // Expr Sort
@@ -231,11 +270,13 @@ DEF_THREAD_MEMORY_POOL(get_sort_allocator, sizeof(expr_sort));
 expr_sort::expr_sort(level const & l, tag g):
     expr_cell(expr_kind::Sort, ::lean::hash(l), false, has_meta(l), false, has_param(l), g),
     m_level(l) {
+    set_hash64(mk_hash64(expr_kind::Sort, l.hash64()));
 }
 expr_sort::~expr_sort() {}
 void expr_sort::dealloc() {
+    unsigned r = m_region;
     this->~expr_sort();
-    get_sort_allocator().recycle(this);
+    recycle_cell(get_sort_allocator, this, r);
 }
 
 // Macro definition
@@ -291,8 +332,12 @@ expr_macro::expr_macro(macro_definition const & m, unsigned num, expr const * ar
     m_definition(m),
     m_num_args(num) {
     m_args = new expr[num];
-    for (unsigned i = 0; i < m_num_args; i++)
+    uint64 h = mk_hash64(expr_kind::Macro, m.hash());
+    for (unsigned i = 0; i < m_num_args; i++) {
         m_args[i] = args[i];
+        h = ::lean::hash64(h, args[i].hash64());
+    }
+    set_hash64(h);
 }
 void expr_macro::dealloc(buffer<expr_cell*> & todelete) {
     for (unsigned i = 0; i < m_num_args; i++) dec_ref(m_args[i], todelete);
@@ -314,10 +359,14 @@ bool enable_expr_caching(bool f) {
     g_expr_cache_enabled = f;
     return r;
 }
+// Remark: cells allocated in regions are not cached, since the cache would keep the region alive.
 inline expr cache(expr const & e) {
-    if (g_expr_cache_enabled) {
-        if (auto r = get_expr_cache().insert(e))
+    if (g_expr_cache_enabled && !e.raw()->in_region()) {
+        inc_stat(g_expr_cache_stat);
+        if (auto r = get_expr_cache().insert(e)) {
+            inc_stat(g_expr_cache_hit_stat);
             return *r;
+        }
     }
     return e;
 }
@@ -326,29 +375,50 @@ inline expr cache(expr && e) { return e; }
 bool enable_expr_caching(bool) { return true; } // NOLINT
 #endif
 
+void set_region(expr_cell * c, unsigned r) {
+    c->m_region = r;
+}
+
+static memory_category g_expr_memory = 0;
+
+/** \brief Allocate a cell of type \c T in the current region of this thread (see util/region.h), or using \c pool. */
+template<typename T, typename... Args>
+static T * mk_cell(memory_pool & (*pool)(), Args &&... args) {
+    memory_scope scope(g_expr_memory);
+    if (regions_enabled()) {
+        if (unsigned r = get_region_id()) {
+            T * c = new (region_allocate(sizeof(T))) T(std::forward<Args>(args)...);
+            set_region(c, r);
+            return c;
+        }
+    }
+    return new (pool().allocate()) T(std::forward<Args>(args)...);
+}
+
 expr mk_var(unsigned idx, tag g) {
-    return cache(expr(new (get_var_allocator().allocate()) expr_var(idx, g)));
+    return cache(expr(mk_cell<expr_var>(get_var_allocator, idx, g)));
 }
 expr mk_constant(name const & n, levels const & ls, tag g) {
-    return cache(expr(new (get_const_allocator().allocate()) expr_const(n, ls, g)));
+    return cache(expr(mk_cell<expr_const>(get_const_allocator, n, ls, g)));
 }
 expr mk_macro(macro_definition const & m, unsigned num, expr const * args, tag g) {
+    memory_scope scope(g_expr_memory);
     return cache(expr(new expr_macro(m, num, args, g)));
 }
 expr mk_metavar(name const & n, expr const & t, tag g) {
-    return cache(expr(new (get_mlocal_allocator().allocate()) expr_mlocal(true, n, t, g)));
+    return cache(expr(mk_cell<expr_mlocal>(get_mlocal_allocator, true, n, t, g)));
 }
 expr mk_local(name const & n, name const & pp_n, expr const & t, binder_info const & bi, tag g) {
-    return cache(expr(new (get_local_allocator().allocate()) expr_local(n, pp_n, t, bi, g)));
+    return cache(expr(mk_cell<expr_local>(get_local_allocator, n, pp_n, t, bi, g)));
 }
 expr mk_app(expr const & f, expr const & a, tag g) {
-    return cache(expr(new (get_app_allocator().allocate()) expr_app(f, a, g)));
+    return cache(expr(mk_cell<expr_app>(get_app_allocator, f, a, g)));
 }
 expr mk_binding(expr_kind k, name const & n, expr const & t, expr const & e, binder_info const & i, tag g) {
-    return cache(expr(new (get_binding_allocator().allocate()) expr_binding(k, n, t, e, i, g)));
+    return cache(expr(mk_cell<expr_binding>(get_binding_allocator, k, n, t, e, i, g)));
 }
 expr mk_sort(level const & l, tag g) {
-    return cache(expr(new (get_sort_allocator().allocate()) expr_sort(l, g)));
+    return cache(expr(mk_cell<expr_sort>(get_sort_allocator, l, g)));
 }
 // =======================================
 
@@ -647,6 +717,7 @@ unsigned hash_bi(expr const & e) {
 }
 
 void initialize_expr() {
+    g_expr_memory  = register_memory_category("exprs");
     g_dummy        = new expr(mk_var(0));
     g_default_name = new name("a");
     g_Type1        = new expr(mk_sort(mk_level_one()));
@@ -58,26 +58,34 @@ protected:
     unsigned           m_has_univ_mv:1;    // term contains universe metavariables
     unsigned           m_has_local:1;      // term contains local constants
     unsigned           m_has_param_univ:1; // term constains parametric universe levels
+    unsigned           m_region:12;        // identifier of the region where the cell was allocated, 0 if none (see util/region.h)
     unsigned           m_hash;             // hash based on the structure of the expression (this is a good hash for structural equality)
+    unsigned           m_hash_hi;          // high 32 bits of the 64-bit structural hash (see hash64)
     unsigned           m_hash_alloc;       // hash based on 'time' of allocation (this is a good hash for pointer-based equality)
     atomic_uint        m_tag;
-    MK_LEAN_RC(); // Declare m_rc counter
+    MK_LEAN_BIASED_RC(expr_cell); // Declare m_rc counter
     void dealloc();
 
     optional<bool> is_arrow() const;
     void set_is_arrow(bool flag);
     friend bool is_arrow(expr const & e);
 
+    friend void set_region(expr_cell * c, unsigned r);
+    void set_hash64(uint64 h) { m_hash_hi = static_cast<unsigned>(h >> 32); }
+
      static void dec_ref(expr & c, buffer<expr_cell*> & todelete);
 public:
     expr_cell(expr_kind k, unsigned h, bool has_expr_mv, bool has_univ_mv, bool has_local, bool has_param_univ, tag g);
     expr_kind kind() const { return static_cast<expr_kind>(m_kind); }
     unsigned  hash() const { return m_hash; }
+    /** \brief 64-bit hash based on the structure of the expression. The low 32 bits are \c hash(). */
+    uint64    hash64() const { return (static_cast<uint64>(m_hash_hi) << 32) | m_hash; }
     unsigned  hash_alloc() const { return m_hash_alloc; }
     bool has_expr_metavar() const { return m_has_expr_mv; }
     bool has_univ_metavar() const { return m_has_univ_mv; }
     bool has_local() const { return m_has_local; }
     bool has_param_univ() const { return m_has_param_univ; }
+    bool in_region() const { return m_region != 0; }
     void set_tag(tag t);
     tag get_tag() const { return m_tag; }
 };
@@ -118,6 +126,7 @@ public:
 
     expr_kind kind() const { return m_ptr->kind(); }
     unsigned  hash() const { return m_ptr ? m_ptr->hash() : 23; }
+    uint64    hash64() const { return m_ptr ? m_ptr->hash64() : 23; }
     unsigned  hash_alloc() const { return m_ptr ? m_ptr->hash_alloc() : 23; }
     bool has_expr_metavar() const { return m_ptr->has_expr_metavar(); }
     bool has_univ_metavar() const { return m_ptr->has_univ_metavar(); }
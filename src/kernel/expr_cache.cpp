@@ -4,30 +4,48 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include "util/hash.h"
 #include "kernel/expr_cache.h"
 
 namespace lean {
 expr * expr_cache::find(expr const & e) {
-    unsigned i = e.hash() % m_capacity;
-    if (m_cache[i].m_expr && is_bi_equal(*m_cache[i].m_expr, e))
-        return &m_cache[i].m_result;
+    uint64 h = e.hash64();
+    auto same_key = [&](entry const & c) { return c.m_hash == h && is_bi_equal(*c.m_expr, e); };
+    if (entry * it = m_cache.find(e.hash(), same_key))
+        return &it->m_result;
     else
         return nullptr;
 }
 
 void expr_cache::insert(expr const & e, expr const & v) {
-    unsigned i = e.hash() % m_capacity;
-    if (!m_cache[i].m_expr)
-        m_used.push_back(i);
-    m_cache[i].m_expr   = e;
-    m_cache[i].m_result = v;
+    uint64 h = e.hash64();
+    auto same_key = [&](entry const & c) { return c.m_hash == h && is_bi_equal(*c.m_expr, e); };
+    entry & it = m_cache.insert(e.hash(), same_key);
+    it.m_expr   = e;
+    it.m_hash   = h;
+    it.m_result = v;
 }
 
 void expr_cache::clear() {
-    for (unsigned i : m_used) {
-        m_cache[i].m_expr   = none_expr();
-        m_cache[i].m_result = expr();
-    }
-    m_used.clear();
+    m_cache.clear();
+}
+
+unsigned expr_pair_cache::get_slot(expr const & e1, expr const & e2) const {
+    return hash(e1.hash(), e2.hash()) % m_capacity;
+}
+
+void expr_pair_cache::insert(expr const & e1, expr const & e2) {
+    if (m_cache.empty())
+        m_cache.resize(m_capacity);
+    entry & it = m_cache[get_slot(e1, e2)];
+    it.m_fst = e1;
+    it.m_snd = e2;
+}
+
+bool expr_pair_cache::contains(expr const & e1, expr const & e2) const {
+    if (m_cache.empty())
+        return false;
+    entry const & it = m_cache[get_slot(e1, e2)];
+    return it.m_fst && is_eqp(*it.m_fst, e1) && is_eqp(*it.m_snd, e2);
 }
 }
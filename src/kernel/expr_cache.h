@@ -6,26 +6,52 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <vector>
+#include "util/set_assoc_cache.h"
 #include "kernel/expr.h"
 
 namespace lean {
-/** \brief Cache for storing mappings from expressions to expressions.
+/** \brief Bounded cache for storing mappings from expressions to expressions.
+    Keys are compared using \c is_bi_equal. See \c set_assoc_cache.
 
-    \warning The insert(k, v) method overwrites andy entry (k1, v1) when
-    hash(k) == hash(k1)
+    \remark When the cache is full, insert(k, v) evicts the least recently used entry
+    of the set selected by hash(k).
 */
 class expr_cache {
     struct entry {
         optional<expr> m_expr;
+        uint64         m_hash; // 64-bit structural hash of m_expr, it is used to quickly discard different keys
         expr           m_result;
+        entry():m_hash(0) {}
+        bool is_empty() const { return !m_expr; }
+        void reset() { m_expr = none_expr(); m_result = expr(); }
     };
-    unsigned              m_capacity;
-    std::vector<entry>    m_cache;
-    std::vector<unsigned> m_used;
+    set_assoc_cache<entry> m_cache;
 public:
-    expr_cache(unsigned c):m_capacity(c), m_cache(c) {}
+    expr_cache(unsigned c, cache_stat_counters const * counters = nullptr):m_cache(c, counters) {}
     void insert(expr const & e, expr const & v);
     expr * find(expr const & e);
     void clear();
+    uint64 hits() const { return m_cache.hits(); }
+    uint64 misses() const { return m_cache.misses(); }
+    uint64 evictions() const { return m_cache.evictions(); }
+};
+
+/** \brief Bounded set of pairs of expressions. Pairs are compared using pointer equality.
+    The memory for the table is only allocated when the first pair is inserted.
+
+    \warning The insert(e1, e2) method overwrites any pair (e1', e2') stored in the same slot.
+*/
+class expr_pair_cache {
+    struct entry {
+        optional<expr> m_fst;
+        optional<expr> m_snd;
+    };
+    unsigned           m_capacity;
+    std::vector<entry> m_cache;
+    unsigned get_slot(expr const & e1, expr const & e2) const;
+public:
+    expr_pair_cache(unsigned c):m_capacity(c) {}
+    void insert(expr const & e1, expr const & e2);
+    bool contains(expr const & e1, expr const & e2) const;
 };
 }
@@ -9,8 +9,10 @@ Author: Leonardo de Moura
 #include "util/flet.h"
 #include "util/memory.h"
 #include "util/interrupt.h"
+#include "util/set_assoc_cache.h"
 #include "kernel/for_each_fn.h"
 #include "kernel/cache_stack.h"
+#include "kernel/kernel_stats.h"
 
 #ifndef LEAN_DEFAULT_FOR_EACH_CACHE_CAPACITY
 #define LEAN_DEFAULT_FOR_EACH_CACHE_CAPACITY 1024*8
@@ -22,30 +24,26 @@ struct for_each_cache {
         expr_cell const * m_cell;
         unsigned          m_offset;
         entry():m_cell(nullptr) {}
+        bool is_empty() const { return m_cell == nullptr; }
+        void reset() { m_cell = nullptr; }
     };
-    unsigned              m_capacity;
-    std::vector<entry>    m_cache;
-    std::vector<unsigned> m_used;
-    for_each_cache(unsigned c):m_capacity(c), m_cache(c) {}
+    set_assoc_cache<entry> m_cache;
+    for_each_cache(unsigned c):m_cache(c, &g_for_each_cache_stats) {}
 
     bool visited(expr const & e, unsigned offset) {
-        unsigned i = hash(e.hash_alloc(), offset) % m_capacity;
-        if (m_cache[i].m_cell == e.raw() && m_cache[i].m_offset == offset) {
+        unsigned h    = hash(e.hash_alloc(), offset);
+        auto same_key = [&](entry const & c) { return c.m_cell == e.raw() && c.m_offset == offset; };
+        if (m_cache.find(h, same_key)) {
             return true;
         } else {
-            if (m_cache[i].m_cell == nullptr)
-                m_used.push_back(i);
-            m_cache[i].m_cell   = e.raw();
-            m_cache[i].m_offset = offset;
+            entry & it  = m_cache.insert(h, same_key);
+            it.m_cell   = e.raw();
+            it.m_offset = offset;
             return false;
         }
     }
 
-    void clear() {
-        for (unsigned i : m_used)
-            m_cache[i].m_cell = nullptr;
-        m_used.clear();
-    }
+    void clear() { m_cache.clear(); }
 };
 
 MK_CACHE_STACK(for_each_cache, LEAN_DEFAULT_FOR_EACH_CACHE_CAPACITY)
@@ -117,6 +115,7 @@ public:
 };
 
 void for_each(expr const & e, std::function<bool(expr const &, unsigned)> && f) { // NOLINT
+    inc_stat(g_for_each_stat);
     return for_each_fn(f)(e);
 }
 }
@@ -823,6 +823,15 @@ bool inductive_normalizer_extension::supports(name const & feature) const {
     return feature == *g_inductive_extension;
 }
 
+optional<unsigned> inductive_normalizer_extension::get_major_idx(environment const & env, expr const & fn) const {
+    if (!is_constant(fn))
+        return optional<unsigned>();
+    if (auto it = get_extension(env).m_elim_info.find(const_name(fn)))
+        return optional<unsigned>(it->m_num_ACe + it->m_num_indices);
+    else
+        return optional<unsigned>();
+}
+
 /** \brief Return true if \c e is an introduction rule for an eliminator named \c elim */
 static inductive_env_ext::comp_rule const * is_intro_for(inductive_env_ext const & ext, name const & elim, expr const & e) {
     expr const & intro_fn  = get_app_fn(e);
@@ -19,6 +19,7 @@ public:
     virtual optional<pair<expr, constraint_seq>> operator()(expr const & e, extension_context & ctx) const;
     virtual optional<expr> may_reduce_later(expr const & e, extension_context & ctx) const;
     virtual bool supports(name const & feature) const;
+    virtual optional<unsigned> get_major_idx(environment const & env, expr const & fn) const;
 };
 
 /** \brief Introduction rule */
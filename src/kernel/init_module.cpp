@@ -12,9 +12,12 @@ Author: Leonardo de Moura
 #include "kernel/level.h"
 #include "kernel/declaration.h"
 #include "kernel/default_converter.h"
+#include "kernel/closed_term_cache.h"
+#include "kernel/kernel_stats.h"
 
 namespace lean {
 void initialize_kernel_module() {
+    initialize_kernel_stats();
     initialize_level();
     initialize_expr();
     initialize_declaration();
@@ -22,10 +25,12 @@ void initialize_kernel_module() {
     initialize_converter();
     initialize_type_checker();
     initialize_environment();
+    initialize_closed_term_cache();
     initialize_formatter();
 }
 void finalize_kernel_module() {
     finalize_formatter();
+    finalize_closed_term_cache();
     finalize_environment();
     finalize_type_checker();
     finalize_converter();
@@ -33,5 +38,6 @@ void finalize_kernel_module() {
     finalize_declaration();
     finalize_expr();
     finalize_level();
+    finalize_kernel_stats();
 }
 }
@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include "kernel/replace_fn.h"
 #include "kernel/declaration.h"
 #include "kernel/instantiate.h"
+#include "kernel/kernel_stats.h"
 
 #ifndef LEAN_INST_UNIV_CACHE_SIZE
 #define LEAN_INST_UNIV_CACHE_SIZE 1023
@@ -38,6 +39,7 @@ struct instantiate_easy_fn {
 expr instantiate(expr const & a, unsigned s, unsigned n, expr const * subst) {
     if (s >= get_free_var_range(a) || n == 0)
         return a;
+    inc_stat(g_instantiate_stat);
     if (s == 0)
         if (auto r = instantiate_easy_fn<false>(n, subst)(a, true))
             return *r;
@@ -70,6 +72,7 @@ expr instantiate(expr const & e, expr const & s) { return instantiate(e, 0, s);
 expr instantiate_rev(expr const & a, unsigned n, expr const * subst) {
     if (closed(a))
         return a;
+    inc_stat(g_instantiate_stat);
     if (auto r = instantiate_easy_fn<true>(n, subst)(a, true))
         return *r;
     return replace(a, [=](expr const & m, unsigned offset) -> optional<expr> {
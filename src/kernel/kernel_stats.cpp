@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "kernel/kernel_stats.h"
+
+namespace lean {
+stat_counter        g_expr_cell_stat[9];
+stat_counter        g_expr_cache_stat;
+stat_counter        g_expr_cache_hit_stat;
+stat_counter        g_instantiate_stat;
+stat_counter        g_abstract_stat;
+stat_counter        g_replace_stat;
+cache_stat_counters g_replace_cache_stats;
+stat_counter        g_for_each_stat;
+cache_stat_counters g_for_each_cache_stats;
+cache_stat_counters g_instantiate_metavars_cache_stats;
+stat_counter        g_whnf_core_stat;
+stat_counter        g_whnf_core_cache_hit_stat;
+stat_counter        g_whnf_core_shared_cache_hit_stat;
+stat_counter        g_whnf_stat;
+stat_counter        g_whnf_cache_hit_stat;
+stat_counter        g_whnf_shared_cache_hit_stat;
+stat_counter        g_is_def_eq_stat;
+stat_counter        g_is_def_eq_failure_cache_hit_stat;
+stat_counter        g_is_def_eq_eqp_stat;
+stat_counter        g_nbe_stat;
+stat_counter        g_nbe_success_stat;
+stat_counter        g_nbe_failure_cache_hit_stat;
+stat_histogram      g_delta_stat;
+stat_counter        g_infer_type_stat;
+stat_counter        g_infer_type_cache_hit_stat;
+stat_counter        g_infer_type_shared_cache_hit_stat;
+
+void initialize_kernel_stats() {
+    // Remark: the order must match the order of the expr_kind enumeration
+    static char const * expr_cell_descrs[9] = {
+        "expr cells (var)", "expr cells (sort)", "expr cells (constant)", "expr cells (metavar)",
+        "expr cells (local)", "expr cells (app)", "expr cells (lambda)", "expr cells (pi)", "expr cells (macro)"};
+    for (unsigned i = 0; i < 9; i++)
+        g_expr_cell_stat[i] = register_stat_counter(expr_cell_descrs[i]);
+    g_expr_cache_stat                  = register_stat_counter("expr cache lookups");
+    g_expr_cache_hit_stat              = register_stat_counter("expr cache hits");
+    g_instantiate_stat                 = register_stat_counter("instantiate");
+    g_abstract_stat                    = register_stat_counter("abstract");
+    g_replace_stat                     = register_stat_counter("replace");
+    g_replace_cache_stats              = register_cache_stat_counters("replace cache");
+    g_for_each_stat                    = register_stat_counter("for_each");
+    g_for_each_cache_stats             = register_cache_stat_counters("for_each cache");
+    g_instantiate_metavars_cache_stats = register_cache_stat_counters("instantiate_metavars cache");
+    g_whnf_core_stat                   = register_stat_counter("whnf_core");
+    g_whnf_core_cache_hit_stat         = register_stat_counter("whnf_core cache hits");
+    g_whnf_core_shared_cache_hit_stat  = register_stat_counter("whnf_core shared cache hits");
+    g_whnf_stat                        = register_stat_counter("whnf");
+    g_whnf_cache_hit_stat              = register_stat_counter("whnf cache hits");
+    g_whnf_shared_cache_hit_stat       = register_stat_counter("whnf shared cache hits");
+    g_is_def_eq_stat                   = register_stat_counter("is_def_eq");
+    g_is_def_eq_failure_cache_hit_stat = register_stat_counter("is_def_eq failure cache hits");
+    g_is_def_eq_eqp_stat               = register_stat_counter("is_def_eq pointer equality");
+    g_nbe_stat                         = register_stat_counter("nbe");
+    g_nbe_success_stat                 = register_stat_counter("nbe successes");
+    g_nbe_failure_cache_hit_stat       = register_stat_counter("nbe failure cache hits");
+    g_infer_type_stat                  = register_stat_counter("infer_type");
+    g_infer_type_cache_hit_stat        = register_stat_counter("infer_type cache hits");
+    g_infer_type_shared_cache_hit_stat = register_stat_counter("infer_type shared cache hits");
+    g_delta_stat                       = register_stat_histogram("delta unfoldings");
+}
+
+void finalize_kernel_stats() {
+}
+}
@@ -0,0 +1,42 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include "util/stats.h"
+
+namespace lean {
+/** \brief Counters used to collect statistics about the kernel. They are only updated when
+    the collection of statistics is enabled, \see enable_stats */
+extern stat_counter        g_expr_cell_stat[9];  // number of cells allocated for each kind of expression
+extern stat_counter        g_expr_cache_stat;
+extern stat_counter        g_expr_cache_hit_stat;
+extern stat_counter        g_instantiate_stat;
+extern stat_counter        g_abstract_stat;
+extern stat_counter        g_replace_stat;
+extern cache_stat_counters g_replace_cache_stats;
+extern stat_counter        g_for_each_stat;
+extern cache_stat_counters g_for_each_cache_stats;
+extern cache_stat_counters g_instantiate_metavars_cache_stats;
+extern stat_counter        g_whnf_core_stat;
+extern stat_counter        g_whnf_core_cache_hit_stat;
+extern stat_counter        g_whnf_core_shared_cache_hit_stat;
+extern stat_counter        g_whnf_stat;
+extern stat_counter        g_whnf_cache_hit_stat;
+extern stat_counter        g_whnf_shared_cache_hit_stat;
+extern stat_counter        g_is_def_eq_stat;
+extern stat_counter        g_is_def_eq_failure_cache_hit_stat;
+extern stat_counter        g_is_def_eq_eqp_stat;  // number of is_def_eq checks on pointer equal terms
+extern stat_counter        g_nbe_stat;
+extern stat_counter        g_nbe_success_stat;
+extern stat_counter        g_nbe_failure_cache_hit_stat;
+extern stat_histogram      g_delta_stat;  // number of times each constant was unfolded
+extern stat_counter        g_infer_type_stat;
+extern stat_counter        g_infer_type_cache_hit_stat;
+extern stat_counter        g_infer_type_shared_cache_hit_stat;
+
+void initialize_kernel_stats();
+void finalize_kernel_stats();
+}
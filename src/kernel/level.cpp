@@ -14,6 +14,7 @@ Author: Leonardo de Moura
 #include "util/debug.h"
 #include "util/hash.h"
 #include "util/interrupt.h"
+#include "util/memory.h"
 #include "kernel/level.h"
 #include "kernel/environment.h"
 
@@ -22,13 +23,19 @@ level_cell const & to_cell(level const & l) {
     return *l.m_ptr;
 }
 
+static memory_category g_level_memory = 0;
+
+static uint64 kind_hash64(level_kind k) { return static_cast<uint64>(k) + 1; }
+
 /** \brief Base class for representing universe level terms. */
 struct level_cell {
     void dealloc();
-    MK_LEAN_RC()
+    MK_LEAN_BIASED_RC(level_cell)
     level_kind m_kind;
     unsigned   m_hash;
-    level_cell(level_kind k, unsigned h):m_rc(0), m_kind(k), m_hash(h) {}
+    uint64     m_hash64; // 64-bit hash code, it is used to compute expr_cell::hash64
+    level_cell(level_kind k, unsigned h, uint64 h64):m_rc(0), m_kind(k), m_hash(h), m_hash64(h64) {}
+    static void * operator new(size_t sz) { memory_scope scope(g_level_memory); return ::operator new(sz); }
 };
 
 struct level_composite : public level_cell {
@@ -36,8 +43,8 @@ struct level_composite : public level_cell {
     unsigned   m_has_param:1;
     unsigned   m_has_global:1;
     unsigned   m_has_meta:1;
-    level_composite(level_kind k, unsigned h, unsigned d, bool has_param, bool has_global, bool has_meta):
-        level_cell(k, h), m_depth(d), m_has_param(has_param), m_has_global(has_global), m_has_meta(has_meta) {}
+    level_composite(level_kind k, unsigned h, uint64 h64, unsigned d, bool has_param, bool has_global, bool has_meta):
+        level_cell(k, h, h64), m_depth(d), m_has_param(has_param), m_has_global(has_global), m_has_meta(has_meta) {}
 };
 
 bool is_composite(level const & l) {
@@ -59,7 +66,7 @@ struct level_succ : public level_composite {
     level m_l;
     bool  m_explicit;
     level_succ(level const & l):
-        level_composite(level_kind::Succ, hash(hash(l), 17u), get_depth(l) + 1, has_param(l), has_global(l), has_meta(l)),
+        level_composite(level_kind::Succ, hash(hash(l), 17u), hash64(kind_hash64(level_kind::Succ), l.hash64()), get_depth(l) + 1, has_param(l), has_global(l), has_meta(l)),
         m_l(l),
         m_explicit(is_explicit(l)) {}
 };
@@ -73,6 +80,7 @@ struct level_max_core : public level_composite {
     level_max_core(bool imax, level const & l1, level const & l2):
         level_composite(imax ? level_kind::IMax : level_kind::Max,
                         hash(hash(l1), hash(l2)),
+                        hash64(hash64(kind_hash64(imax ? level_kind::IMax : level_kind::Max), l1.hash64()), l2.hash64()),
                         std::max(get_depth(l1), get_depth(l2)) + 1,
                         has_param(l1)  || has_param(l2),
                         has_global(l1) || has_global(l2),
@@ -95,7 +103,7 @@ level const & imax_rhs(level const & l) { lean_assert(is_imax(l)); return to_max
 struct level_param_core : public level_cell {
     name m_id;
     level_param_core(level_kind k, name const & id):
-        level_cell(k, hash(id.hash(), static_cast<unsigned>(k))),
+        level_cell(k, hash(id.hash(), static_cast<unsigned>(k)), hash64(kind_hash64(k), id.hash64())),
         m_id(id) {
         lean_assert(k == level_kind::Meta || k == level_kind::Param || k == level_kind::Global);
     }
@@ -267,6 +275,7 @@ level & level::operator=(level const & l) { LEAN_COPY_REF(l); }
 level & level::operator=(level&& l) { LEAN_MOVE_REF(l); }
 level_kind level::kind() const { return m_ptr->m_kind; }
 unsigned level::hash() const { return m_ptr->m_hash; }
+uint64 level::hash64() const { return m_ptr->m_hash64; }
 
 bool operator==(level const & l1, level const & l2) {
     if (kind(l1) != kind(l2)) return false;
@@ -715,7 +724,8 @@ levels param_names_to_levels(level_param_names const & ps) {
 }
 
 void initialize_level() {
-    g_level_zero = new level(new level_cell(level_kind::Zero, 7u));
+    g_level_memory = register_memory_category("levels");
+    g_level_zero = new level(new level_cell(level_kind::Zero, 7u, kind_hash64(level_kind::Zero)));
     g_level_one  = new level(mk_succ(mk_level_zero()));
 }
 
@@ -55,6 +55,8 @@ public:
 
     level_kind kind() const;
     unsigned hash() const;
+    /** \brief 64-bit hash code, \see name::hash64 */
+    uint64 hash64() const;
 
     level & operator=(level const & l);
     level & operator=(level&& l);
@@ -89,6 +91,7 @@ level mk_meta_univ(name const & n);
 pair<level, unsigned> to_offset(level l);
 
 inline unsigned hash(level const & l) { return l.hash(); }
+struct level_hash { unsigned operator()(level const & l) const { return l.hash(); } };
 inline level_kind kind(level const & l) { return l.kind(); }
 inline bool is_zero(level const & l)   { return kind(l) == level_kind::Zero; }
 inline bool is_param(level const & l)  { return kind(l) == level_kind::Param; }
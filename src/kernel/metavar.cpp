@@ -17,6 +17,7 @@ Author: Leonardo de Moura
 #include "kernel/cache_stack.h"
 #include "kernel/expr_cache.h"
 #include "kernel/abstract.h"
+#include "kernel/kernel_stats.h"
 
 #ifndef LEAN_INSTANTIATE_METAVARS_CACHE_CAPACITY
 #define LEAN_INSTANTIATE_METAVARS_CACHE_CAPACITY 1024*8
@@ -104,7 +105,9 @@ pair<level, justification> substitution::instantiate_metavars(level const & l, b
     return mk_pair(r, j);
 }
 
-typedef expr_cache instantiate_metavars_cache;
+struct instantiate_metavars_cache : public expr_cache {
+    instantiate_metavars_cache(unsigned c):expr_cache(c, &g_instantiate_metavars_cache_stats) {}
+};
 MK_CACHE_STACK(instantiate_metavars_cache, LEAN_INSTANTIATE_METAVARS_CACHE_CAPACITY)
 
 class instantiate_metavars_fn {
@@ -0,0 +1,383 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <memory>
+#include "util/interrupt.h"
+#include "util/flet.h"
+#include "util/list.h"
+#include "kernel/nbe_converter.h"
+#include "kernel/instantiate.h"
+#include "kernel/free_vars.h"
+#include "kernel/expr_maps.h"
+#include "kernel/type_checker.h"
+#include "kernel/kernel_stats.h"
+
+// Remark: the budget is small because the steps are wasted when the evaluator fails.
+#ifndef LEAN_NBE_MAX_STEPS
+#define LEAN_NBE_MAX_STEPS 16384
+#endif
+
+#ifndef LEAN_NBE_FAILURE_CACHE_CAPACITY
+#define LEAN_NBE_FAILURE_CACHE_CAPACITY 1024
+#endif
+
+namespace lean {
+static atomic<bool> g_nbe_converter(false);
+
+void set_nbe_converter(bool flag) { g_nbe_converter = flag; }
+bool get_nbe_converter() { return g_nbe_converter; }
+
+std::unique_ptr<converter> mk_kernel_converter(environment const & env, optional<module_idx> mod_idx, bool memoize,
+                                               closed_term_cache_ptr const & shared_cache) {
+    if (get_nbe_converter())
+        return std::unique_ptr<converter>(new nbe_converter(env, mod_idx, memoize, shared_cache));
+    else
+        return std::unique_ptr<converter>(new default_converter(env, mod_idx, memoize, shared_cache));
+}
+
+enum class nbe_value_kind { Thunk, Closure, Neutral };
+struct nbe_value_cell;
+typedef std::shared_ptr<nbe_value_cell> nbe_value;
+typedef list<nbe_value> nbe_env;
+
+/** \brief Values of the semantic domain.
+    - Thunk:   delayed evaluation of m_expr in m_env (i.e., an argument that was not used yet).
+    - Closure: lambda or Pi m_expr in m_env.
+    - Neutral: m_expr (local constant, sort, constant that cannot be unfolded, or macro) applied to m_args. */
+struct nbe_value_cell {
+    nbe_value_kind     m_kind;
+    expr               m_expr;
+    nbe_env            m_env;
+    nbe_env            m_args;     // arguments of a neutral value in reverse order
+    unsigned           m_num_args;
+    optional<unsigned> m_major;    // see normalizer_extension::get_major_idx, none if the value is stuck
+    nbe_value          m_forced;   // result of evaluating a thunk
+    optional<expr>     m_quote;    // cached result of quote
+    nbe_value_cell(nbe_value_kind k, expr const & e, nbe_env const & env):
+        m_kind(k), m_expr(e), m_env(env), m_num_args(0) {}
+};
+
+static nbe_value mk_thunk(expr const & e, nbe_env const & env) {
+    return std::make_shared<nbe_value_cell>(nbe_value_kind::Thunk, e, env);
+}
+
+static nbe_value mk_closure(expr const & e, nbe_env const & env) {
+    return std::make_shared<nbe_value_cell>(nbe_value_kind::Closure, e, env);
+}
+
+static nbe_value mk_neutral(expr const & e, optional<unsigned> const & major) {
+    nbe_value r = std::make_shared<nbe_value_cell>(nbe_value_kind::Neutral, e, nbe_env());
+    r->m_major  = major;
+    return r;
+}
+
+/** \brief Exception used to abort the evaluator. The caller falls back to the procedure used in \c default_converter. */
+struct nbe_give_up {};
+
+class nbe_fn {
+    nbe_converter &            m_conv;
+    environment const &        m_env;
+    unsigned                   m_steps;     // remaining budget, see LEAN_NBE_MAX_STEPS
+    expr_struct_map<nbe_value> m_constants; // cache for constants
+
+    void step() {
+        if (m_steps == 0)
+            throw nbe_give_up();
+        m_steps--;
+        check_system("normalization by evaluation");
+    }
+
+    /** \brief Apply the pending substitution \c env to \c e. */
+    expr materialize(expr const & e, nbe_env const & env) {
+        unsigned range = get_free_var_range(e);
+        if (range == 0 || is_nil(env))
+            return e;
+        buffer<expr> s;
+        for (nbe_value const & v : env) {
+            if (s.size() == range)
+                break;
+            s.push_back(quote(v));
+        }
+        return instantiate(e, s.size(), s.data());
+    }
+
+    /** \brief Convert \c v back into an expression. The bodies of closures are not normalized, and
+        thunks are not forced, i.e., this is a cheap operation used to build the terms passed to
+        normalizer extensions and macros. */
+    expr quote(nbe_value const & v) {
+        if (v->m_quote)
+            return *v->m_quote;
+        expr r;
+        if (v->m_kind == nbe_value_kind::Thunk && v->m_forced) {
+            r = quote(v->m_forced);
+        } else if (v->m_kind == nbe_value_kind::Neutral) {
+            buffer<expr> args;
+            for (nbe_value const & a : v->m_args)
+                args.push_back(quote(a));
+            r = mk_rev_app(v->m_expr, args);
+        } else {
+            r = materialize(v->m_expr, v->m_env);
+        }
+        v->m_quote = r;
+        return r;
+    }
+
+    nbe_value force(nbe_value const & v) {
+        if (v->m_kind != nbe_value_kind::Thunk)
+            return v;
+        if (!v->m_forced) {
+            v->m_forced = eval(v->m_expr, v->m_env);
+            v->m_env    = nbe_env(); // the environment is not needed anymore
+        }
+        return v->m_forced;
+    }
+
+    /** \brief Return the value of the definition \c e (if it can be unfolded). */
+    optional<nbe_value> unfold(expr const & e) {
+        optional<declaration> d = m_env.find(const_name(e));
+        if (d && d->is_definition() && !m_conv.is_opaque(*d) && length(const_levels(e)) == d->get_num_univ_params()) {
+            step();
+            return optional<nbe_value>(eval(instantiate_value_univ_params(*d, const_levels(e)), nbe_env()));
+        }
+        return optional<nbe_value>();
+    }
+
+    nbe_value eval_constant(expr const & e) {
+        auto it = m_constants.find(e);
+        if (it != m_constants.end())
+            return it->second;
+        nbe_value r;
+        normalizer_extension const & ext = m_env.norm_ext();
+        optional<nbe_value> v;
+        if (!ext.is_builtin(m_env, e) && (v = unfold(e)))
+            r = *v;
+        else
+            r = mk_neutral(e, ext.get_major_idx(m_env, e));
+        m_constants.insert(mk_pair(e, r));
+        return r;
+    }
+
+    nbe_value eval_macro(expr const & e, nbe_env const & env) {
+        expr m = materialize(e, env);
+        if (auto new_m = m_conv.expand_macro(m)) {
+            step();
+            return eval(*new_m, nbe_env());
+        } else {
+            return mk_neutral(m, optional<unsigned>());
+        }
+    }
+
+    /** \brief Create a value for the argument \c e of an application. */
+    nbe_value mk_arg(expr const & e, nbe_env const & env) {
+        switch (e.kind()) {
+        case expr_kind::Var: case expr_kind::Sort: case expr_kind::Local:
+        case expr_kind::Lambda: case expr_kind::Pi:
+            return eval(e, env);
+        default:
+            if (closed(e))
+                return mk_thunk(e, nbe_env());
+            else
+                return mk_thunk(e, env);
+        }
+    }
+
+    nbe_value eval(expr const & e, nbe_env const & env) {
+        switch (e.kind()) {
+        case expr_kind::Var: {
+            unsigned idx = var_idx(e);
+            for (nbe_value const & v : env) {
+                if (idx == 0)
+                    return v;
+                idx--;
+            }
+            throw nbe_give_up(); // loose bound variable
+        }
+        case expr_kind::Sort: case expr_kind::Local:
+            return mk_neutral(e, optional<unsigned>());
+        case expr_kind::Meta:
+            throw nbe_give_up();
+        case expr_kind::Constant:
+            return eval_constant(e);
+        case expr_kind::Macro:
+            return eval_macro(e, env);
+        case expr_kind::Lambda: case expr_kind::Pi:
+            return mk_closure(e, closed(e) ? nbe_env() : env);
+        case expr_kind::App: {
+            buffer<expr> args;
+            expr const & f = get_app_args(e, args);
+            nbe_value r = eval(f, env);
+            for (expr const & a : args)
+                r = apply(r, mk_arg(a, env));
+            return r;
+        }}
+        lean_unreachable(); // LCOV_EXCL_LINE
+    }
+
+    /** \brief Try to reduce the neutral value \c v using the normalizer extensions. */
+    nbe_value reduce_ext(nbe_value const & v) {
+        lean_assert(v->m_major && v->m_num_args > *v->m_major);
+        if (auto r = m_conv.norm_ext(quote(v))) {
+            if (!r->second) {
+                step();
+                return eval(r->first, nbe_env());
+            }
+        }
+        if (is_constant(v->m_expr) && m_env.norm_ext().is_builtin(m_env, v->m_expr)) {
+            // the extension failed to reduce the application, so we unfold the definition
+            if (auto f = unfold(v->m_expr)) {
+                buffer<nbe_value> args;
+                for (nbe_value const & a : v->m_args)
+                    args.push_back(a);
+                nbe_value r = *f;
+                unsigned i = args.size();
+                while (i > 0) {
+                    --i;
+                    r = apply(r, args[i]);
+                }
+                return r;
+            }
+        }
+        // arguments do not affect the major premise, so there is no point in trying again later
+        v->m_major = optional<unsigned>();
+        return v;
+    }
+
+    nbe_value apply(nbe_value f, nbe_value const & a) {
+        f = force(f);
+        if (f->m_kind == nbe_value_kind::Closure) {
+            if (!is_lambda(f->m_expr))
+                throw nbe_give_up(); // type incorrect
+            step();
+            return eval(binding_body(f->m_expr), cons(a, f->m_env));
+        }
+        nbe_value r = mk_neutral(f->m_expr, f->m_major);
+        r->m_args     = cons(a, f->m_args);
+        r->m_num_args = f->m_num_args + 1;
+        if (r->m_major && r->m_num_args > *r->m_major)
+            return reduce_ext(r);
+        return r;
+    }
+
+    /** \brief Return a fresh local constant for the binder of the closure \c v, and store its value in \c x. */
+    expr mk_local_for(nbe_value const & v, nbe_value & x) {
+        lean_assert(v->m_kind == nbe_value_kind::Closure);
+        expr const & b = v->m_expr;
+        expr l = mk_local(m_conv.mk_fresh_name(*m_conv.m_tc), binding_name(b),
+                          materialize(binding_domain(b), v->m_env), binding_info(b));
+        x = mk_neutral(l, optional<unsigned>());
+        return l;
+    }
+
+    nbe_value instantiate_body(nbe_value const & v, nbe_value const & x) {
+        step();
+        return eval(binding_body(v->m_expr), cons(x, v->m_env));
+    }
+
+    bool is_def_eq_levels(levels ls1, levels ls2) {
+        while (!is_nil(ls1) && !is_nil(ls2)) {
+            if (!is_equivalent(head(ls1), head(ls2)))
+                return false;
+            ls1 = tail(ls1);
+            ls2 = tail(ls2);
+        }
+        return is_nil(ls1) && is_nil(ls2);
+    }
+
+    bool is_def_eq_head(expr const & h1, expr const & h2) {
+        if (h1.kind() != h2.kind())
+            return false;
+        switch (h1.kind()) {
+        case expr_kind::Constant:
+            return const_name(h1) == const_name(h2) && is_def_eq_levels(const_levels(h1), const_levels(h2));
+        case expr_kind::Sort:
+            return is_equivalent(sort_level(h1), sort_level(h2));
+        case expr_kind::Local:
+            return mlocal_name(h1) == mlocal_name(h2);
+        default:
+            return h1 == h2;
+        }
+    }
+
+    bool is_def_eq(nbe_value v1, nbe_value v2) {
+        v1 = force(v1);
+        v2 = force(v2);
+        if (v1 == v2)
+            return true;
+        step();
+        if (v1->m_kind == nbe_value_kind::Closure && v2->m_kind == nbe_value_kind::Closure) {
+            if (v1->m_expr.kind() != v2->m_expr.kind())
+                return false;
+            if (!is_def_eq(eval(binding_domain(v1->m_expr), v1->m_env), eval(binding_domain(v2->m_expr), v2->m_env)))
+                return false;
+            nbe_value x;
+            mk_local_for(v1, x);
+            return is_def_eq(instantiate_body(v1, x), instantiate_body(v2, x));
+        } else if (v1->m_kind == nbe_value_kind::Neutral && v2->m_kind == nbe_value_kind::Neutral) {
+            if (v1->m_num_args != v2->m_num_args || !is_def_eq_head(v1->m_expr, v2->m_expr))
+                return false;
+            nbe_env args1 = v1->m_args;
+            nbe_env args2 = v2->m_args;
+            for (; !is_nil(args1); args1 = tail(args1), args2 = tail(args2)) {
+                if (!is_def_eq(head(args1), head(args2)))
+                    return false;
+            }
+            return true;
+        } else if (m_env.eta()) {
+            // eta: (fun x, f x) == f
+            if (v2->m_kind == nbe_value_kind::Closure)
+                std::swap(v1, v2);
+            if (!is_lambda(v1->m_expr))
+                return false;
+            nbe_value x;
+            mk_local_for(v1, x);
+            return is_def_eq(instantiate_body(v1, x), apply(v2, x));
+        } else {
+            return false;
+        }
+    }
+
+public:
+    nbe_fn(nbe_converter & conv):m_conv(conv), m_env(conv.m_env), m_steps(LEAN_NBE_MAX_STEPS) {}
+
+    /** \brief Return true if \c t and \c s have the same normal form. A false result is inconclusive. */
+    bool operator()(expr const & t, expr const & s) {
+        try {
+            return is_def_eq(eval(t, nbe_env()), eval(s, nbe_env()));
+        } catch (nbe_give_up &) {
+            return false;
+        } catch (exception &) {
+            // normalizer extensions and macros may fail on the terms produced by quote,
+            // let default_converter report the error (if any).
+            return false;
+        }
+    }
+};
+
+nbe_converter::nbe_converter(environment const & env, optional<module_idx> mod_idx, bool memoize,
+                             closed_term_cache_ptr const & shared_cache):
+    default_converter(env, mod_idx, memoize, shared_cache), m_nbe_failure_cache(LEAN_NBE_FAILURE_CACHE_CAPACITY) {}
+
+pair<bool, constraint_seq> nbe_converter::is_def_eq(expr const & t, expr const & s, type_checker & c,
+                                                    delayed_justification & jst) {
+    if (!is_eqp(t, s) && closed(t) && closed(s) && !has_metavar(t) && !has_metavar(s)) {
+        if (m_memoize && m_nbe_failure_cache.contains(t, s)) {
+            inc_stat(g_nbe_failure_cache_hit_stat);
+        } else {
+            flet<type_checker*>          set_tc(m_tc, &c);
+            flet<delayed_justification*> set_js(m_jst, &jst);
+            inc_stat(g_nbe_stat);
+            if (nbe_fn(*this)(t, s)) {
+                inc_stat(g_nbe_success_stat);
+                return to_bcs(true);
+            }
+            if (m_memoize)
+                m_nbe_failure_cache.insert(t, s);
+        }
+    }
+    return default_converter::is_def_eq(t, s, c, jst);
+}
+}
@@ -0,0 +1,44 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include "kernel/default_converter.h"
+
+namespace lean {
+class nbe_fn;
+/**
+   \brief Converter that uses normalization by evaluation for deciding definitional equality.
+
+   Terms are evaluated into a semantic domain where lambdas and Pis are closures, and stuck terms
+   are neutral values (a local constant, sort, opaque constant or macro applied to arguments). Arguments are
+   evaluated lazily. Applications of eliminators are reduced using the normalization extensions attached
+   to the environment (e.g., the computational rules of inductive datatypes) once their major premise
+   is available. Two values are compared by reading them back under binders.
+
+   The evaluator is only a fast path: when it fails to show that two terms are definitionally equal
+   (or exceeds its step budget), the procedure used by \c default_converter is used.
+   Thus, both converters accept the same declarations. The pairs for which the evaluator failed are
+   cached, and it is not tried again on them.
+*/
+class nbe_converter : public default_converter {
+    friend class nbe_fn;
+    // Pairs (t, s) of closed terms without metavariables such that the evaluator failed on them.
+    expr_pair_cache m_nbe_failure_cache;
+public:
+    nbe_converter(environment const & env, optional<module_idx> mod_idx, bool memoize = true,
+                  closed_term_cache_ptr const & shared_cache = closed_term_cache_ptr());
+
+    virtual pair<bool, constraint_seq> is_def_eq(expr const & t, expr const & s, type_checker & c, delayed_justification & jst);
+};
+
+/** \brief When \c flag is true, the type checkers created by \c check use \c nbe_converter instead of \c default_converter. */
+void set_nbe_converter(bool flag);
+bool get_nbe_converter();
+
+/** \brief Create the converter used by the type checkers created by \c check. \see set_nbe_converter */
+std::unique_ptr<converter> mk_kernel_converter(environment const & env, optional<module_idx> mod_idx, bool memoize,
+                                               closed_term_cache_ptr const & shared_cache);
+}
@@ -44,6 +44,17 @@ public:
     virtual bool supports(name const & feature) const {
         return m_ext1->supports(feature) || m_ext2->supports(feature);
     }
+
+    virtual optional<unsigned> get_major_idx(environment const & env, expr const & fn) const {
+        if (auto r = m_ext1->get_major_idx(env, fn))
+            return r;
+        else
+            return m_ext2->get_major_idx(env, fn);
+    }
+
+    virtual bool is_builtin(environment const & env, expr const & fn) const {
+        return m_ext1->is_builtin(env, fn) || m_ext2->is_builtin(env, fn);
+    }
 };
 
 std::unique_ptr<normalizer_extension> compose(std::unique_ptr<normalizer_extension> && ext1, std::unique_ptr<normalizer_extension> && ext2) {
@@ -8,6 +8,8 @@ Author: Leonardo de Moura
 #include "kernel/expr.h"
 
 namespace lean {
+class environment;
+
 /**
    \brief The Lean kernel can be instantiated with different normalization extensions.
    Each extension is part of the trusted code base. The extensions allow us to support
@@ -25,6 +27,14 @@ public:
     /** \brief Return true iff the extension supports a feature with the given name,
         this method is only used for sanity checking. */
     virtual bool supports(name const & feature) const = 0;
+    /** \brief Return the position of the argument that must be in weak head normal form before the extension
+        can reduce an application of \c fn (e.g., the major premise of an eliminator). Return none if the
+        extension does not reduce applications of \c fn. Evaluators use this method to decide when \c operator()
+        should be tried. */
+    virtual optional<unsigned> get_major_idx(environment const &, expr const &) const { return optional<unsigned>(); }
+    /** \brief Return true if the extension implements the definition \c fn, i.e., applications of \c fn must be
+        given to the extension before \c fn is unfolded. If the extension fails to reduce them, \c fn is unfolded. */
+    virtual bool is_builtin(environment const &, expr const &) const { return false; }
 };
 
 inline optional<pair<expr, constraint_seq>> none_ecs() { return optional<pair<expr, constraint_seq>>(); }
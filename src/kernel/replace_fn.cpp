@@ -6,8 +6,10 @@ Author: Leonardo de Moura
 */
 #include <vector>
 #include <memory>
+#include "util/set_assoc_cache.h"
 #include "kernel/replace_fn.h"
 #include "kernel/cache_stack.h"
+#include "kernel/kernel_stats.h"
 
 #ifndef LEAN_DEFAULT_REPLACE_CACHE_CAPACITY
 #define LEAN_DEFAULT_REPLACE_CACHE_CAPACITY 1024*8
@@ -24,36 +26,29 @@ struct replace_cache {
         unsigned    m_offset;
         expr        m_result;
         entry():m_cell(nullptr) {}
+        bool is_empty() const { return m_cell == nullptr; }
+        void reset() { m_cell = nullptr; m_result = expr(); }
     };
-    unsigned              m_capacity;
-    std::vector<entry>    m_cache;
-    std::vector<unsigned> m_used;
-    replace_cache(unsigned c):m_capacity(c), m_cache(c) {}
+    set_assoc_cache<entry> m_cache;
+    replace_cache(unsigned c):m_cache(c, &g_replace_cache_stats) {}
 
     expr * find(expr const & e, unsigned offset) {
-        unsigned i = hash(e.hash_alloc(), offset) % m_capacity;
-        if (m_cache[i].m_cell == e.raw() && m_cache[i].m_offset == offset)
-            return &m_cache[i].m_result;
+        auto same_key = [&](entry const & c) { return c.m_cell == e.raw() && c.m_offset == offset; };
+        if (entry * it = m_cache.find(hash(e.hash_alloc(), offset), same_key))
+            return &it->m_result;
         else
             return nullptr;
     }
 
     void insert(expr const & e, unsigned offset, expr const & v) {
-        unsigned i = hash(e.hash_alloc(), offset) % m_capacity;
-        if (m_cache[i].m_cell == nullptr)
-            m_used.push_back(i);
-        m_cache[i].m_cell   = e.raw();
-        m_cache[i].m_offset = offset;
-        m_cache[i].m_result = v;
+        auto same_key = [&](entry const & c) { return c.m_cell == e.raw() && c.m_offset == offset; };
+        entry & it   = m_cache.insert(hash(e.hash_alloc(), offset), same_key);
+        it.m_cell    = e.raw();
+        it.m_offset  = offset;
+        it.m_result  = v;
     }
 
-    void clear() {
-        for (unsigned i : m_used) {
-            m_cache[i].m_cell   = nullptr;
-            m_cache[i].m_result = expr();
-        }
-        m_used.clear();
-    }
+    void clear() { m_cache.clear(); }
 };
 
 MK_CACHE_STACK(replace_cache, LEAN_DEFAULT_REPLACE_CACHE_CAPACITY)
@@ -117,6 +112,7 @@ public:
 };
 
 expr replace(expr const & e, std::function<optional<expr>(expr const &, unsigned)> const & f, bool use_cache) {
+    inc_stat(g_replace_stat);
     return replace_rec_fn(f, use_cache)(e);
 }
 }
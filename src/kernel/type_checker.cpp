@@ -13,6 +13,7 @@ Author: Leonardo de Moura
 #include "util/scoped_map.h"
 #include "kernel/type_checker.h"
 #include "kernel/default_converter.h"
+#include "kernel/nbe_converter.h"
 #include "kernel/expr_maps.h"
 #include "kernel/instantiate.h"
 #include "kernel/free_vars.h"
@@ -21,6 +22,7 @@ Author: Leonardo de Moura
 #include "kernel/kernel_exception.h"
 #include "kernel/abstract.h"
 #include "kernel/replace_fn.h"
+#include "kernel/kernel_stats.h"
 
 namespace lean {
 expr replace_range(expr const & type, expr const & new_range) {
@@ -317,10 +319,32 @@ pair<expr, constraint_seq> type_checker::infer_type_core(expr const & e, bool in
     lean_assert(closed(e));
     check_system("type checker");
 
+    inc_stat(g_infer_type_stat);
     if (m_memoize) {
         auto it = m_infer_type_cache[infer_only].find(e);
-        if (it != m_infer_type_cache[infer_only].end())
+        if (it != m_infer_type_cache[infer_only].end()) {
+            inc_stat(g_infer_type_cache_hit_stat);
             return it->second;
+        }
+    }
+    // Remark: the result also depends on the opaque definitions treated as transparent by the converter (tag),
+    // and when e is checked, on the universe parameters in scope.
+    auto k = infer_only ? closed_term_cache::kind::InferType : closed_term_cache::kind::Check;
+    unsigned tag = 0;
+    level_param_names ps;
+    bool shared = m_shared_cache && closed_term_cache::is_cacheable(e);
+    if (shared) {
+        if (auto midx = m_conv->get_module_idx())
+            tag = *midx + 1;
+        if (!infer_only && m_params)
+            ps = *m_params;
+        if (auto t = m_shared_cache->find(k, m_env, e, tag, ps)) {
+            inc_stat(g_infer_type_shared_cache_hit_stat);
+            auto r = to_ecs(*t);
+            if (m_memoize)
+                m_infer_type_cache[infer_only].insert(mk_pair(e, r));
+            return r;
+        }
     }
 
     pair<expr, constraint_seq> r;
@@ -341,6 +365,9 @@ pair<expr, constraint_seq> type_checker::infer_type_core(expr const & e, bool in
 
     if (m_memoize)
         m_infer_type_cache[infer_only].insert(mk_pair(e, r));
+    // Remark: results containing constraints are not shared.
+    if (shared && !r.second)
+        m_shared_cache->insert(k, m_env, e, r.first, tag, ps);
 
     return r;
 }
@@ -416,9 +443,10 @@ bool type_checker::is_opaque(expr const & c) const {
         return true;
 }
 
-type_checker::type_checker(environment const & env, name_generator const & g, std::unique_ptr<converter> && conv, bool memoize):
+type_checker::type_checker(environment const & env, name_generator const & g, std::unique_ptr<converter> && conv, bool memoize,
+                           closed_term_cache_ptr const & shared_cache):
     m_env(env), m_gen(g), m_conv(std::move(conv)), m_tc_ctx(*this),
-    m_memoize(memoize), m_params(nullptr) {
+    m_memoize(memoize), m_shared_cache(shared_cache), m_params(nullptr) {
 }
 
 type_checker::type_checker(environment const & env, name_generator const & g, bool memoize):
@@ -479,14 +507,15 @@ certified_declaration check(environment const & env, declaration const & d, name
     check_name(env, d.get_name());
     check_duplicated_params(env, d);
     bool memoize = true;
-    type_checker checker1(env, g, std::unique_ptr<converter>(new default_converter(env, optional<module_idx>(), memoize)));
+    closed_term_cache_ptr const & cache = get_closed_term_cache(env);
+    type_checker checker1(env, g, mk_kernel_converter(env, optional<module_idx>(), memoize, cache), memoize, cache);
     expr sort = checker1.check(d.get_type(), d.get_univ_params()).first;
     checker1.ensure_sort(sort, d.get_type());
     if (d.is_definition()) {
         optional<module_idx> midx;
         if (d.is_opaque())
             midx = optional<module_idx>(d.get_module_idx());
-        type_checker checker2(env, g, std::unique_ptr<converter>(new default_converter(env, midx, memoize)));
+        type_checker checker2(env, g, mk_kernel_converter(env, midx, memoize, cache), memoize, cache);
         expr val_type = checker2.check(d.get_value(), d.get_univ_params()).first;
         if (!checker2.is_def_eq(val_type, d.get_type()).first) {
             throw_kernel_exception(env, d.get_value(), [=](formatter const & fmt) {
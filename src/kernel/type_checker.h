@@ -16,6 +16,7 @@ Author: Leonardo de Moura
 #include "kernel/justification.h"
 #include "kernel/converter.h"
 #include "kernel/expr_maps.h"
+#include "kernel/closed_term_cache.h"
 
 namespace lean {
 /** \brief Return the "arity" of the given type. The arity is the number of nested pi-expressions. */
@@ -93,6 +94,7 @@ class type_checker {
     cache                      m_infer_type_cache[2];
     type_checker_context       m_tc_ctx;
     bool                       m_memoize;
+    closed_term_cache_ptr      m_shared_cache; // nullptr if there is no cache shared with other type checkers
     // temp flag
     level_param_names const *  m_params;
 
@@ -119,8 +121,11 @@ public:
        type checker are based on the given name generator.
 
        memoize: if true, then inferred types are memoized/cached
+       shared_cache: if not nullptr, then the types of closed terms are also stored in this cache,
+       and shared with other type checkers. It must only be used with the default_converter.
     */
-    type_checker(environment const & env, name_generator const & g, std::unique_ptr<converter> && conv, bool memoize = true);
+    type_checker(environment const & env, name_generator const & g, std::unique_ptr<converter> && conv, bool memoize = true,
+                 closed_term_cache_ptr const & shared_cache = closed_term_cache_ptr());
     type_checker(environment const & env, name_generator const & g, bool memoize = true);
     type_checker(environment const & env);
     ~type_checker();
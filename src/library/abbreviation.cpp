@@ -56,6 +56,7 @@ struct abbrev_config {
     static void add_entry(environment const & env, io_state const &, state & s, entry const & e) {
         s.add(env, e.first, e.second);
     }
+    static bool add_entry_reads_env() { return true; }
     static name const & get_class_name() {
         return *g_class_name;
     }
@@ -105,6 +105,7 @@ struct class_config {
             break;
         }
     }
+    static bool add_entry_reads_env() { return false; }
     static name const & get_class_name() {
         return *g_class_name;
     }
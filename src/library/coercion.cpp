@@ -330,6 +330,7 @@ struct coercion_config {
     static void add_entry(environment const & env, io_state const & ios, state & s, entry const & e) {
         s = add_coercion(env, ios, s, e.first, e.second);
     }
+    static bool add_entry_reads_env() { return true; }
     static name const & get_class_name() {
         return *g_class_name;
     }
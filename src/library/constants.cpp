@@ -13,6 +13,8 @@ name const * g_bool_ff = nullptr;
 name const * g_bool_tt = nullptr;
 name const * g_char = nullptr;
 name const * g_char_mk = nullptr;
+name const * g_decidable_inl = nullptr;
+name const * g_decidable_inr = nullptr;
 name const * g_dite = nullptr;
 name const * g_eq = nullptr;
 name const * g_eq_elim_inv_inv = nullptr;
@@ -34,8 +36,20 @@ name const * g_lift = nullptr;
 name const * g_lift_down = nullptr;
 name const * g_lift_up = nullptr;
 name const * g_nat = nullptr;
+name const * g_nat_add = nullptr;
+name const * g_nat_decidable_le = nullptr;
+name const * g_nat_divide = nullptr;
+name const * g_nat_has_decidable_eq = nullptr;
+name const * g_nat_le = nullptr;
+name const * g_nat_lt_irrefl = nullptr;
+name const * g_nat_lt_of_lt_of_eq = nullptr;
+name const * g_nat_lt_of_lt_of_le = nullptr;
+name const * g_nat_modulo = nullptr;
+name const * g_nat_mul = nullptr;
 name const * g_nat_of_num = nullptr;
 name const * g_nat_succ = nullptr;
+name const * g_nat_sub = nullptr;
+name const * g_nat_sub_le = nullptr;
 name const * g_nat_zero = nullptr;
 name const * g_not = nullptr;
 name const * g_num = nullptr;
@@ -126,6 +140,8 @@ void initialize_constants() {
     g_bool_tt = new name{"bool", "tt"};
     g_char = new name{"char"};
     g_char_mk = new name{"char", "mk"};
+    g_decidable_inl = new name{"decidable", "inl"};
+    g_decidable_inr = new name{"decidable", "inr"};
     g_dite = new name{"dite"};
     g_eq = new name{"eq"};
     g_eq_elim_inv_inv = new name{"eq", "elim_inv_inv"};
@@ -147,8 +163,20 @@ void initialize_constants() {
     g_lift_down = new name{"lift", "down"};
     g_lift_up = new name{"lift", "up"};
     g_nat = new name{"nat"};
+    g_nat_add = new name{"nat", "add"};
+    g_nat_decidable_le = new name{"nat", "decidable_le"};
+    g_nat_divide = new name{"nat", "divide"};
+    g_nat_has_decidable_eq = new name{"nat", "has_decidable_eq"};
+    g_nat_le = new name{"nat", "le"};
+    g_nat_lt_irrefl = new name{"nat", "lt", "irrefl"};
+    g_nat_lt_of_lt_of_eq = new name{"nat", "lt_of_lt_of_eq"};
+    g_nat_lt_of_lt_of_le = new name{"nat", "lt_of_lt_of_le"};
+    g_nat_modulo = new name{"nat", "modulo"};
+    g_nat_mul = new name{"nat", "mul"};
     g_nat_of_num = new name{"nat", "of_num"};
     g_nat_succ = new name{"nat", "succ"};
+    g_nat_sub = new name{"nat", "sub"};
+    g_nat_sub_le = new name{"nat", "sub_le"};
     g_nat_zero = new name{"nat", "zero"};
     g_not = new name{"not"};
     g_num = new name{"num"};
@@ -240,6 +268,8 @@ void finalize_constants() {
     delete g_bool_tt;
     delete g_char;
     delete g_char_mk;
+    delete g_decidable_inl;
+    delete g_decidable_inr;
     delete g_dite;
     delete g_eq;
     delete g_eq_elim_inv_inv;
@@ -261,8 +291,20 @@ void finalize_constants() {
     delete g_lift_down;
     delete g_lift_up;
     delete g_nat;
+    delete g_nat_add;
+    delete g_nat_decidable_le;
+    delete g_nat_divide;
+    delete g_nat_has_decidable_eq;
+    delete g_nat_le;
+    delete g_nat_lt_irrefl;
+    delete g_nat_lt_of_lt_of_eq;
+    delete g_nat_lt_of_lt_of_le;
+    delete g_nat_modulo;
+    delete g_nat_mul;
     delete g_nat_of_num;
     delete g_nat_succ;
+    delete g_nat_sub;
+    delete g_nat_sub_le;
     delete g_nat_zero;
     delete g_not;
     delete g_num;
@@ -353,6 +395,8 @@ name const & get_bool_ff_name() { return *g_bool_ff; }
 name const & get_bool_tt_name() { return *g_bool_tt; }
 name const & get_char_name() { return *g_char; }
 name const & get_char_mk_name() { return *g_char_mk; }
+name const & get_decidable_inl_name() { return *g_decidable_inl; }
+name const & get_decidable_inr_name() { return *g_decidable_inr; }
 name const & get_dite_name() { return *g_dite; }
 name const & get_eq_name() { return *g_eq; }
 name const & get_eq_elim_inv_inv_name() { return *g_eq_elim_inv_inv; }
@@ -374,8 +418,20 @@ name const & get_lift_name() { return *g_lift; }
 name const & get_lift_down_name() { return *g_lift_down; }
 name const & get_lift_up_name() { return *g_lift_up; }
 name const & get_nat_name() { return *g_nat; }
+name const & get_nat_add_name() { return *g_nat_add; }
+name const & get_nat_decidable_le_name() { return *g_nat_decidable_le; }
+name const & get_nat_divide_name() { return *g_nat_divide; }
+name const & get_nat_has_decidable_eq_name() { return *g_nat_has_decidable_eq; }
+name const & get_nat_le_name() { return *g_nat_le; }
+name const & get_nat_lt_irrefl_name() { return *g_nat_lt_irrefl; }
+name const & get_nat_lt_of_lt_of_eq_name() { return *g_nat_lt_of_lt_of_eq; }
+name const & get_nat_lt_of_lt_of_le_name() { return *g_nat_lt_of_lt_of_le; }
+name const & get_nat_modulo_name() { return *g_nat_modulo; }
+name const & get_nat_mul_name() { return *g_nat_mul; }
 name const & get_nat_of_num_name() { return *g_nat_of_num; }
 name const & get_nat_succ_name() { return *g_nat_succ; }
+name const & get_nat_sub_name() { return *g_nat_sub; }
+name const & get_nat_sub_le_name() { return *g_nat_sub_le; }
 name const & get_nat_zero_name() { return *g_nat_zero; }
 name const & get_not_name() { return *g_not; }
 name const & get_num_name() { return *g_num; }
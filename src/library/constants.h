@@ -15,6 +15,8 @@ name const & get_bool_ff_name();
 name const & get_bool_tt_name();
 name const & get_char_name();
 name const & get_char_mk_name();
+name const & get_decidable_inl_name();
+name const & get_decidable_inr_name();
 name const & get_dite_name();
 name const & get_eq_name();
 name const & get_eq_elim_inv_inv_name();
@@ -36,8 +38,20 @@ name const & get_lift_name();
 name const & get_lift_down_name();
 name const & get_lift_up_name();
 name const & get_nat_name();
+name const & get_nat_add_name();
+name const & get_nat_decidable_le_name();
+name const & get_nat_divide_name();
+name const & get_nat_has_decidable_eq_name();
+name const & get_nat_le_name();
+name const & get_nat_lt_irrefl_name();
+name const & get_nat_lt_of_lt_of_eq_name();
+name const & get_nat_lt_of_lt_of_le_name();
+name const & get_nat_modulo_name();
+name const & get_nat_mul_name();
 name const & get_nat_of_num_name();
 name const & get_nat_succ_name();
+name const & get_nat_sub_name();
+name const & get_nat_sub_le_name();
 name const & get_nat_zero_name();
 name const & get_not_name();
 name const & get_num_name();
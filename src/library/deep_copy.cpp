@@ -4,7 +4,9 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <unordered_map>
 #include "util/buffer.h"
+#include "util/region.h"
 #include "kernel/expr.h"
 #include "kernel/replace_fn.h"
 
@@ -34,4 +36,58 @@ expr deep_copy(expr const & e) {
                 return none_expr();
         });
 }
+
+class copy_out_of_region_fn {
+    std::unordered_map<expr_cell *, expr> m_cache; // shared subterms that have already been copied
+
+    expr copy_core(expr const & e) {
+        expr r;
+        switch (e.kind()) {
+        case expr_kind::Var: case expr_kind::Constant: case expr_kind::Sort:
+            r = e;
+            break;
+        case expr_kind::Meta: case expr_kind::Local:
+            r = update_mlocal(e, visit(mlocal_type(e)));
+            break;
+        case expr_kind::App:
+            r = update_app(e, visit(app_fn(e)), visit(app_arg(e)));
+            break;
+        case expr_kind::Lambda: case expr_kind::Pi:
+            r = update_binding(e, visit(binding_domain(e)), visit(binding_body(e)));
+            break;
+        case expr_kind::Macro: {
+            buffer<expr> new_args;
+            for (unsigned i = 0; i < macro_num_args(e); i++)
+                new_args.push_back(visit(macro_arg(e, i)));
+            r = update_macro(e, new_args.size(), new_args.data());
+            break;
+        }}
+        if (r.raw()->in_region())
+            r = copy_tag(e, copy(r));
+        return r;
+    }
+
+    expr visit(expr const & e) {
+        if (!is_shared(e))
+            return copy_core(e);
+        auto it = m_cache.find(e.raw());
+        if (it != m_cache.end())
+            return it->second;
+        expr r = copy_core(e);
+        m_cache.insert(mk_pair(e.raw(), r));
+        return r;
+    }
+
+public:
+    expr operator()(expr const & e) {
+        no_region_scope scope;
+        return visit(e);
+    }
+};
+
+expr copy_out_of_region(expr const & e) {
+    if (!regions_enabled())
+        return e;
+    return copy_out_of_region_fn()(e);
+}
 }
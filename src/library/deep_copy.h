@@ -16,4 +16,12 @@ expr copy(expr const & e);
     argument, but does not share any memory cell with it.
 */
 expr deep_copy(expr const & e);
+
+/**
+    \brief Return an expression that is equal to the given argument, but does not contain
+    cells allocated in regions (see util/region.h). The result is used to keep the objects
+    that must survive (e.g., the type and value of a declaration) without keeping the region alive.
+    It is the identity function if regions are disabled.
+*/
+expr copy_out_of_region(expr const & e);
 }
@@ -0,0 +1,184 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+#include "library/import_profile.h"
+
+namespace lean {
+/** \brief Maximum number of declarations displayed in the "slowest declarations" section of the table. */
+static unsigned const g_max_displayed_checks = 20;
+
+void module_profile::add_check(name const & n, double secs) {
+    lock_guard<mutex> lock(m_check_mutex);
+    m_checks.emplace_back(n, secs);
+    m_check_secs += secs;
+}
+
+import_profile::import_profile(std::vector<module_profile_ptr> const & modules, double total_secs, double delayed_secs):
+    m_modules(modules), m_total_secs(total_secs), m_delayed_secs(delayed_secs) {
+    std::sort(m_modules.begin(), m_modules.end(), [](module_profile_ptr const & m1, module_profile_ptr const & m2) {
+            return m1->m_module_idx < m2->m_module_idx;
+        });
+}
+
+std::vector<module_profile_ptr> import_profile::get_critical_path(double & secs) const {
+    // Remark: the module index of a module is greater than the index of the modules it imports.
+    // So, m_modules is a topological order of the import DAG.
+    std::unordered_map<unsigned, unsigned> pos; // module index -> position in m_modules
+    for (unsigned i = 0; i < m_modules.size(); i++)
+        pos[m_modules[i]->m_module_idx] = i;
+    std::vector<double>   path_secs(m_modules.size(), 0.0); // length of the longest chain ending at i
+    std::vector<unsigned> prev(m_modules.size(), m_modules.size());
+    unsigned last = m_modules.size();
+    secs = 0.0;
+    for (unsigned i = 0; i < m_modules.size(); i++) {
+        for (unsigned midx : m_modules[i]->m_imports) {
+            auto it = pos.find(midx);
+            if (it != pos.end() && path_secs[it->second] > path_secs[i]) {
+                path_secs[i] = path_secs[it->second];
+                prev[i]      = it->second;
+            }
+        }
+        path_secs[i] += m_modules[i]->m_import_secs;
+        if (last == m_modules.size() || path_secs[i] > secs) {
+            secs = path_secs[i];
+            last = i;
+        }
+    }
+    std::vector<module_profile_ptr> r;
+    for (unsigned i = last; i < m_modules.size(); i = prev[i])
+        r.push_back(m_modules[i]);
+    std::reverse(r.begin(), r.end());
+    return r;
+}
+
+void import_profile::display(std::ostream & out) const {
+    std::vector<module_profile_ptr> modules(m_modules);
+    std::sort(modules.begin(), modules.end(), [](module_profile_ptr const & m1, module_profile_ptr const & m2) {
+            return m1->m_import_secs > m2->m_import_secs;
+        });
+    std::map<std::string, double> reader_secs;
+    std::vector<pair<name, double>> checks;
+    uint64 total_bytes = 0;
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision     = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "import profile, " << m_modules.size() << " module(s), " << m_total_secs << " secs\n";
+    out << "      bytes   read(s) decode(s)  check(s)  decls reader(s) delayed(s) import(s)  module\n";
+    for (module_profile_ptr const & m : modules) {
+        double readers = 0.0;
+        for (auto const & p : m->m_reader_secs) {
+            readers += p.second;
+            reader_secs[p.first] += p.second;
+        }
+        total_bytes += m->m_bytes;
+        checks.insert(checks.end(), m->m_checks.begin(), m->m_checks.end());
+        out << std::setw(11) << m->m_bytes << std::setw(10) << m->m_read_secs << std::setw(10) << m->m_decode_secs
+            << std::setw(10) << m->m_check_secs << std::setw(7) << m->m_checks.size() << std::setw(10) << readers
+            << std::setw(11) << m->m_delayed_secs << std::setw(10) << m->m_import_secs << "  " << m->m_fname << "\n";
+    }
+    out << "total bytes read: " << total_bytes << "\n";
+    out << "delayed updates: " << m_delayed_secs << " secs\n";
+    if (!reader_secs.empty()) {
+        out << "extension readers:\n";
+        for (auto const & p : reader_secs)
+            out << std::setw(10) << p.second << "  " << p.first << "\n";
+    }
+    if (!checks.empty()) {
+        std::sort(checks.begin(), checks.end(), [](pair<name, double> const & c1, pair<name, double> const & c2) {
+                return c1.second > c2.second;
+            });
+        if (checks.size() > g_max_displayed_checks)
+            checks.resize(g_max_displayed_checks);
+        out << "slowest declarations (kernel check):\n";
+        for (auto const & c : checks)
+            out << std::setw(10) << c.second << "  " << c.first << "\n";
+    }
+    double cp_secs;
+    std::vector<module_profile_ptr> cp = get_critical_path(cp_secs);
+    out << "critical path: " << cp_secs << " secs, " << cp.size() << " module(s)\n";
+    for (module_profile_ptr const & m : cp)
+        out << std::setw(10) << m->m_import_secs << "  " << m->m_fname << "\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/** \brief Helper class for printing JSON strings. */
+struct json_string {
+    std::string const & m_str;
+    json_string(std::string const & s):m_str(s) {}
+};
+
+static std::ostream & operator<<(std::ostream & out, json_string const & s) {
+    out << '"';
+    for (char c : s.m_str) {
+        switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<unsigned>(c)
+                    << std::dec << std::setfill(' ');
+            else
+                out << c;
+        }
+    }
+    return out << '"';
+}
+
+void import_profile::display_json(std::ostream & out) const {
+    std::unordered_map<unsigned, std::string const *> fnames; // module index -> file name
+    for (module_profile_ptr const & m : m_modules)
+        fnames[m->m_module_idx] = &m->m_fname;
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision     = out.precision();
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"total_secs\": " << m_total_secs << ",\n  \"delayed_secs\": " << m_delayed_secs << ",\n";
+    double cp_secs;
+    std::vector<module_profile_ptr> cp = get_critical_path(cp_secs);
+    out << "  \"critical_path\": {\"secs\": " << cp_secs << ", \"modules\": [";
+    for (unsigned i = 0; i < cp.size(); i++)
+        out << (i == 0 ? "" : ", ") << json_string(cp[i]->m_fname);
+    out << "]},\n  \"modules\": [";
+    for (unsigned i = 0; i < m_modules.size(); i++) {
+        module_profile const & m = *m_modules[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"file\": " << json_string(m.m_fname) << ", \"idx\": " << m.m_module_idx
+            << ", \"bytes\": " << m.m_bytes << ", \"read_secs\": " << m.m_read_secs
+            << ", \"decode_secs\": " << m.m_decode_secs << ", \"check_secs\": " << m.m_check_secs
+            << ", \"delayed_secs\": " << m.m_delayed_secs << ", \"import_secs\": " << m.m_import_secs << ",\n";
+        out << "     \"imports\": [";
+        bool first = true;
+        for (unsigned midx : m.m_imports) {
+            auto it = fnames.find(midx);
+            if (it != fnames.end()) {
+                out << (first ? "" : ", ") << json_string(*it->second);
+                first = false;
+            }
+        }
+        out << "],\n     \"readers\": {";
+        first = true;
+        for (auto const & p : m.m_reader_secs) {
+            out << (first ? "" : ", ") << json_string(p.first) << ": " << p.second;
+            first = false;
+        }
+        out << "},\n     \"checks\": [";
+        for (unsigned j = 0; j < m.m_checks.size(); j++)
+            out << (j == 0 ? "" : ", ") << "{\"name\": " << json_string(m.m_checks[j].first.to_string())
+                << ", \"secs\": " << m.m_checks[j].second << "}";
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+}
@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+#include "util/int64.h"
+#include "util/pair.h"
+#include "util/name.h"
+#include "util/thread.h"
+
+namespace lean {
+/** \brief Low tech stopwatch used for profiling. */
+class profile_timer {
+    typedef std::chrono::steady_clock clock_type;
+    clock_type::time_point m_start;
+public:
+    profile_timer():m_start(clock_type::now()) {}
+    /** \brief Return the number of seconds since this object was created. */
+    double elapsed() const { return std::chrono::duration<double>(clock_type::now() - m_start).count(); }
+};
+
+/** \brief Profiling data collected for a module imported by \c import_modules.
+    \see set_import_profile */
+struct module_profile {
+    std::string                             m_fname;
+    unsigned                                m_module_idx;
+    uint64                                  m_bytes;        // number of bytes read, i.e., size of the .olean file
+    double                                  m_read_secs;    // time spent reading the file and verifying checksums
+    double                                  m_decode_secs;  // time spent decompressing and decoding declarations
+    double                                  m_import_secs;  // duration of the import task (includes decode, check and readers)
+    double                                  m_delayed_secs; // time spent in delayed updates
+    std::unordered_map<std::string, double> m_reader_secs;  // time spent in extension readers grouped by key
+    std::vector<unsigned>                   m_imports;      // module indices of the imported modules
+    mutex                                   m_check_mutex;  // declarations may be checked by asynchronous tasks
+    double                                  m_check_secs;   // sum of the times in m_checks
+    std::vector<pair<name, double>>         m_checks;       // time spent in the kernel type checker for each declaration
+    module_profile(std::string const & fname):
+        m_fname(fname), m_module_idx(0), m_bytes(0), m_read_secs(0.0), m_decode_secs(0.0), m_import_secs(0.0),
+        m_delayed_secs(0.0), m_check_secs(0.0) {}
+    void add_check(name const & n, double secs);
+};
+typedef std::shared_ptr<module_profile> module_profile_ptr;
+
+/** \brief Profiling report for a call to \c import_modules. */
+class import_profile {
+    std::vector<module_profile_ptr> m_modules; // sorted by module index
+    double                          m_total_secs;
+    double                          m_delayed_secs;
+public:
+    /** \brief Create a report for the given modules.
+        \c total_secs is the duration of the import, and \c delayed_secs the time spent processing delayed updates. */
+    import_profile(std::vector<module_profile_ptr> const & modules, double total_secs, double delayed_secs);
+
+    /** \brief Return the longest chain of modules in the import DAG, where the weight of a
+        module is the duration of its import task. The first module in the result imports no module
+        in the chain. The length of the chain is stored in \c secs. */
+    std::vector<module_profile_ptr> get_critical_path(double & secs) const;
+
+    /** \brief Display the report as a table. */
+    void display(std::ostream & out) const;
+    /** \brief Display the report in JSON format. */
+    void display_json(std::ostream & out) const;
+};
+}
@@ -12,6 +12,7 @@ Author: Leonardo de Moura
 #include "library/choice.h"
 #include "library/class.h"
 #include "library/string.h"
+#include "library/nat_value.h"
 #include "library/num.h"
 #include "library/resolve_macro.h"
 #include "library/annotation.h"
@@ -53,6 +54,7 @@ void initialize_library_module() {
     initialize_choice();
     initialize_num();
     initialize_string();
+    initialize_nat_value();
     initialize_resolve_macro();
     initialize_annotation();
     initialize_explicit();
@@ -92,6 +94,7 @@ void finalize_library_module() {
     finalize_explicit();
     finalize_annotation();
     finalize_resolve_macro();
+    finalize_nat_value();
     finalize_string();
     finalize_num();
     finalize_choice();
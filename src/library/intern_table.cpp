@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "library/intern_table.h"
+
+#ifndef LEAN_INTERN_TABLE_SHARDS
+#define LEAN_INTERN_TABLE_SHARDS 64
+#endif
+
+namespace lean {
+intern_table::intern_table():m_shards(new shard[LEAN_INTERN_TABLE_SHARDS]) {}
+
+intern_table::shard & intern_table::get_shard(unsigned h) {
+    // The low bits of h are used by the hash set buckets.
+    return m_shards[(h >> 8) % LEAN_INTERN_TABLE_SHARDS];
+}
+
+expr intern_table::intern(expr const & e) {
+    shard & s = get_shard(e.hash());
+    lock_guard<mutex> lock(s.m_mutex);
+    return *s.m_exprs.insert(e).first;
+}
+
+level intern_table::intern(level const & l) {
+    shard & s = get_shard(hash(l));
+    lock_guard<mutex> lock(s.m_mutex);
+    return *s.m_levels.insert(l).first;
+}
+
+unsigned intern_table::get_num_exprs() {
+    unsigned r = 0;
+    for (unsigned i = 0; i < LEAN_INTERN_TABLE_SHARDS; i++) {
+        lock_guard<mutex> lock(m_shards[i].m_mutex);
+        r += m_shards[i].m_exprs.size();
+    }
+    return r;
+}
+
+unsigned intern_table::get_num_levels() {
+    unsigned r = 0;
+    for (unsigned i = 0; i < LEAN_INTERN_TABLE_SHARDS; i++) {
+        lock_guard<mutex> lock(m_shards[i].m_mutex);
+        r += m_shards[i].m_levels.size();
+    }
+    return r;
+}
+
+LEAN_THREAD_PTR(intern_table, g_intern_table);
+
+intern_table * get_intern_table() {
+    return g_intern_table;
+}
+
+scoped_intern_table::scoped_intern_table(intern_table * t):m_old(g_intern_table) {
+    g_intern_table = t;
+}
+
+scoped_intern_table::~scoped_intern_table() {
+    g_intern_table = m_old;
+}
+}
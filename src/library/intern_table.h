@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include <unordered_set>
+#include "util/thread.h"
+#include "kernel/expr.h"
+
+namespace lean {
+/**
+   \brief Concurrent table for sharing structurally equal expressions and universe levels (aka hash-consing).
+
+   The deserializers (see kernel_serializer.h) use the table associated with the current thread
+   (see scoped_intern_table). The table used by import_modules is shared by all imported modules.
+   So, structurally equal terms occurring in different modules are represented by the same cell.
+
+   The table is split in shards. Each shard is protected by its own mutex.
+*/
+class intern_table {
+    struct shard {
+        mutex                                                  m_mutex;
+        std::unordered_set<expr, expr_hash, is_bi_equal_proc> m_exprs;
+        std::unordered_set<level, level_hash>                  m_levels;
+    };
+    std::unique_ptr<shard[]> m_shards;
+    shard & get_shard(unsigned h);
+public:
+    intern_table();
+    /** \brief Return an expression structurally equal to \c e stored in the table.
+        If there is none, then \c e is stored and returned.
+        \pre The children of \c e have already been interned. */
+    expr intern(expr const & e);
+    /** \brief Similar to intern(expr const &), but for universe levels. */
+    level intern(level const & l);
+    /** \brief Return the number of expressions stored in the table. */
+    unsigned get_num_exprs();
+    /** \brief Return the number of universe levels stored in the table. */
+    unsigned get_num_levels();
+};
+typedef std::shared_ptr<intern_table> intern_table_ptr;
+
+/** \brief Return the intern table associated with the current thread, nullptr if there is none. */
+intern_table * get_intern_table();
+
+/** \brief Auxiliary object for setting the intern table associated with the current thread. */
+class scoped_intern_table {
+    intern_table * m_old;
+public:
+    scoped_intern_table(intern_table * t);
+    ~scoped_intern_table();
+};
+}
@@ -5,20 +5,35 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <string>
+#include <vector>
 #include "util/object_serializer.h"
 #include "kernel/expr.h"
 #include "kernel/declaration.h"
 #include "library/annotation.h"
 #include "library/max_sharing.h"
 #include "library/kernel_serializer.h"
+#include "library/intern_table.h"
 
 // Procedures for serializing and deserializing kernel objects (levels, exprs, declarations)
 namespace lean {
 // Universe level serialization
 class level_serializer : public object_serializer<level, level::ptr_hash, level::ptr_eq> {
     typedef object_serializer<level, level::ptr_hash, level::ptr_eq> super;
+    shared_level_table const * m_shared;
 public:
+    level_serializer():m_shared(nullptr) {}
+    void set_shared(shared_level_table const & t) {
+        set_num_shared(t.size());
+        m_shared = &t;
+    }
     void write(level const & l) {
+        if (m_shared) {
+            auto it = m_shared->find(l);
+            if (it != m_shared->end()) {
+                write_ref(it->second);
+                return;
+            }
+        }
         super::write(l, [&]() {
                 serializer & s = get_owner();
                 auto k = kind(l);
@@ -38,32 +53,39 @@ public:
 
 class level_deserializer : public object_deserializer<level> {
     typedef object_deserializer<level> super;
+
+    level read_node() {
+        deserializer & d = get_owner();
+        auto k = static_cast<level_kind>(d.read_char());
+        switch (k) {
+        case level_kind::Zero:
+            return mk_level_zero();
+        case level_kind::Param:
+            return mk_param_univ(read_name(d));
+        case level_kind::Global:
+            return mk_global_univ(read_name(d));
+        case level_kind::Meta:
+            return mk_meta_univ(read_name(d));
+        case level_kind::Max: {
+            level lhs = read();
+            return mk_max(lhs, read());
+        }
+        case level_kind::IMax: {
+            level lhs = read();
+            return mk_imax(lhs, read());
+        }
+        case level_kind::Succ:
+            return mk_succ(read());
+        }
+        throw corrupted_stream_exception();
+    }
 public:
     level read() {
-        return super::read([&]() -> level {
-                deserializer & d = get_owner();
-                auto k = static_cast<level_kind>(d.read_char());
-                switch (k) {
-                case level_kind::Zero:
-                    return mk_level_zero();
-                case level_kind::Param:
-                    return mk_param_univ(read_name(d));
-                case level_kind::Global:
-                    return mk_global_univ(read_name(d));
-                case level_kind::Meta:
-                    return mk_meta_univ(read_name(d));
-                case level_kind::Max: {
-                    level lhs = read();
-                    return mk_max(lhs, read());
-                }
-                case level_kind::IMax: {
-                    level lhs = read();
-                    return mk_imax(lhs, read());
-                }
-                case level_kind::Succ:
-                    return mk_succ(read());
-                }
-                throw corrupted_stream_exception();
+        return super::read([&]() {
+                level r = read_node();
+                if (intern_table * t = get_intern_table())
+                    return t->intern(r);
+                return r;
             });
     }
 };
@@ -90,6 +112,14 @@ serializer & operator<<(serializer & s, level const & n) {
 
 level read_level(deserializer & d) { return d.get_extension<level_deserializer>(g_level_sd->m_d_extid).read(); }
 
+void set_shared_levels(serializer & s, shared_level_table const & t) {
+    s.get_extension<level_serializer>(g_level_sd->m_s_extid).set_shared(t);
+}
+
+void set_shared_levels(deserializer & d, std::vector<level> const & t) {
+    d.get_extension<level_deserializer>(g_level_sd->m_d_extid).set_shared(t);
+}
+
 serializer & operator<<(serializer & s, levels const & ls) { return write_list<level>(s, ls); }
 
 levels read_levels(deserializer & d) { return read_list<level>(d, read_level); }
@@ -205,6 +235,45 @@ public:
 
 class expr_deserializer : public object_deserializer<expr> {
     typedef object_deserializer<expr> super;
+
+    expr read_node(char c) {
+        deserializer & d = get_owner();
+        auto k = static_cast<expr_kind>(c);
+        switch (k) {
+        case expr_kind::Var:
+            return mk_var(d.read_unsigned());
+        case expr_kind::Constant: {
+            auto n = read_name(d);
+            return mk_constant(n, read_levels(d));
+        }
+        case expr_kind::Sort:
+            return mk_sort(read_level(d));
+        case expr_kind::Macro: {
+            unsigned n = d.read_unsigned();
+            buffer<expr> args;
+            for (unsigned i = 0; i < n; i++) {
+                args.push_back(read());
+            }
+            return read_macro_definition(d, args.size(), args.data());
+        }
+        case expr_kind::App: {
+            expr f = read();
+            return mk_app(f, read());
+        }
+        case expr_kind::Lambda: case expr_kind::Pi:
+            return read_binding(k);
+        case expr_kind::Meta: {
+            name n = read_name(d);
+            return mk_metavar(n, read());
+        }
+        case expr_kind::Local: {
+            name n         = read_name(d);
+            name pp_n      = read_name(d);
+            binder_info bi = read_binder_info(d);
+            return mk_local(n, pp_n, read(), bi);
+        }}
+        throw corrupted_stream_exception(); // LCOV_EXCL_LINE
+    }
 public:
     expr read_binding(expr_kind k) {
         deserializer & d   = get_owner();
@@ -216,42 +285,10 @@ public:
 
     expr read() {
         return super::read_core([&](char c) {
-                deserializer & d = get_owner();
-                auto k = static_cast<expr_kind>(c);
-                switch (k) {
-                case expr_kind::Var:
-                    return mk_var(d.read_unsigned());
-                case expr_kind::Constant: {
-                    auto n = read_name(d);
-                    return mk_constant(n, read_levels(d));
-                }
-                case expr_kind::Sort:
-                    return mk_sort(read_level(d));
-                case expr_kind::Macro: {
-                    unsigned n = d.read_unsigned();
-                    buffer<expr> args;
-                    for (unsigned i = 0; i < n; i++) {
-                        args.push_back(read());
-                    }
-                    return read_macro_definition(d, args.size(), args.data());
-                }
-                case expr_kind::App: {
-                    expr f = read();
-                    return mk_app(f, read());
-                }
-                case expr_kind::Lambda: case expr_kind::Pi:
-                    return read_binding(k);
-                case expr_kind::Meta: {
-                    name n = read_name(d);
-                    return mk_metavar(n, read());
-                }
-                case expr_kind::Local: {
-                    name n         = read_name(d);
-                    name pp_n      = read_name(d);
-                    binder_info bi = read_binder_info(d);
-                    return mk_local(n, pp_n, read(), bi);
-                }}
-                throw corrupted_stream_exception(); // LCOV_EXCL_LINE
+                expr r = read_node(c);
+                if (intern_table * t = get_intern_table())
+                    return t->intern(r);
+                return r;
             });
     }
 };
@@ -6,6 +6,8 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include "util/serializer.h"
 #include "kernel/declaration.h"
 #include "kernel/inductive/inductive.h"
@@ -15,6 +17,11 @@ serializer & operator<<(serializer & s, level const & l);
 level read_level(deserializer & d);
 inline deserializer & operator>>(deserializer & d, level & l) { l = read_level(d); return d; }
 
+/** \brief Universe levels shared by several streams, and their positions. \see set_shared_names */
+typedef std::unordered_map<level, unsigned, level_hash> shared_level_table;
+void set_shared_levels(serializer & s, shared_level_table const & t);
+void set_shared_levels(deserializer & d, std::vector<level> const & t);
+
 serializer & operator<<(serializer & s, levels const & ls);
 levels read_levels(deserializer & d);
 
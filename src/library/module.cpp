@@ -9,8 +9,11 @@ Author: Leonardo de Moura
 #include <utility>
 #include <string>
 #include <sstream>
+#include <cstdio>
+#include <iterator>
 #include <fstream>
 #include <algorithm>
+#include <limits>
 #include <sys/stat.h>
 #include "util/hash.h"
 #include "util/thread.h"
@@ -19,13 +22,26 @@ Author: Leonardo de Moura
 #include "util/buffer.h"
 #include "util/interrupt.h"
 #include "util/name_map.h"
+#include "util/pair.h"
+#include "util/mapped_file.h"
+#include "util/memory.h"
+#include "util/lz_codec.h"
+#include "util/task_scheduler.h"
+#include "util/sexpr/option_declarations.h"
+#include "kernel/for_each_fn.h"
 #include "kernel/type_checker.h"
 #include "library/module.h"
 #include "library/sorry.h"
 #include "library/kernel_serializer.h"
+#include "library/intern_table.h"
+#include "library/import_profile.h"
 #include "library/unfold_macros.h"
 #include "version.h"
 
+#ifndef LEAN_DEFAULT_IMPORT_STATS
+#define LEAN_DEFAULT_IMPORT_STATS false
+#endif
+
 #ifndef LEAN_ASYNCH_IMPORT_THEOREM
 #define LEAN_ASYNCH_IMPORT_THEOREM false
 #endif
@@ -35,7 +51,15 @@ corrupted_file_exception::corrupted_file_exception(std::string const & fname):
     exception(sstream() << "failed to import '" << fname << "', file is corrupted, please regenerate the file from sources") {
 }
 
-typedef pair<std::string, std::function<void(serializer &)>> writer;
+/** \brief Object to be stored in the .olean file. Declarations are stored in the declaration table,
+    the other objects are written using \c m_fn. */
+struct writer {
+    std::string                       m_key;
+    std::function<void(serializer &)> m_fn;
+    optional<declaration>             m_decl;
+    writer(std::string const & k, std::function<void(serializer &)> const & fn):m_key(k), m_fn(fn) {}
+    writer(std::string const & k, declaration const & d):m_key(k), m_decl(d) {}
+};
 
 struct module_ext : public environment_extension {
     list<module_name> m_direct_imports;
@@ -54,6 +78,7 @@ struct module_ext_reg {
 };
 
 static module_ext_reg * g_ext = nullptr;
+static memory_category g_olean_memory = 0;
 
 static module_ext const & get_extension(environment const & env) {
     return static_cast<module_ext const &>(env.get_extension(g_ext->m_ext_id));
@@ -114,7 +139,192 @@ module_name read_module_name(deserializer & d) {
     }
 }
 
-void export_module(std::ostream & out, environment const & env) {
+/** \brief Version of the .olean file format, it must be incremented whenever the format is modified.
+
+    Format 2: the object code is preceded by a table of contents containing the offset of each object,
+    and the declaration table. For each declaration, the table stores its name, kind, and the
+    location of its type and value. Types and values are serialized independently of each other
+    (i.e., they do not share serializer tables), and can be decoded on demand.
+
+    Format 3: theorem values are stored in a separate section after the object code.
+    The section has its own checksum, and it is not read when proofs are not needed.
+
+    Format 4: checksums are 64-bit hash codes (see hash64_stream).
+
+    Format 5: the object code and proofs sections may be compressed (see lz_compress_blocks).
+    The kind of compression is stored after the list of imported modules.
+    For compressed files, the checksums in the header are the hash codes of the uncompressed data,
+    and each compressed block has its own checksum.
+
+    Format 6: the table of contents does not contain the offset of each object anymore,
+    objects are always read sequentially.
+
+    Format 7: the names and universe levels used by the declarations are stored once, in a table
+    that follows the declaration table. Types and values refer to them by position.
+*/
+static unsigned g_olean_format = 7;
+
+/** \brief Kinds of compression for .olean sections. */
+enum class olean_compression { None = 0, LZ = 1 };
+
+/** \brief Entry of the declaration table stored in .olean files. */
+struct olean_decl {
+    char              m_kind;  // same encoding used by operator<<(serializer &, declaration const &)
+    name              m_name;
+    level_param_names m_params;
+    unsigned          m_weight;
+    // The declaration contains macros that must be unfolded when trust_lvl < m_min_trust_lvl
+    unsigned          m_min_trust_lvl;
+    // location of type and value in the declaration data, theorem values are stored in the proofs section
+    unsigned          m_type_offset;
+    unsigned          m_type_size;
+    unsigned          m_value_offset;
+    unsigned          m_value_size;
+    olean_decl():m_kind(0), m_weight(0), m_min_trust_lvl(0), m_type_offset(0), m_type_size(0),
+                 m_value_offset(0), m_value_size(0) {}
+    bool has_value() const { return (m_kind & 1) != 0; }
+    bool is_opaque() const { return (m_kind & 2) != 0; }
+    bool use_conv_opt() const { return (m_kind & 4) != 0; }
+    bool is_th_ax() const { return (m_kind & 8) != 0; }
+    bool is_theorem() const { return has_value() && is_th_ax(); }
+};
+
+serializer & operator<<(serializer & s, olean_decl const & d) {
+    s << d.m_kind << d.m_name << d.m_params << d.m_weight << d.m_min_trust_lvl
+      << d.m_type_offset << d.m_type_size << d.m_value_offset << d.m_value_size;
+    return s;
+}
+
+olean_decl read_olean_decl(deserializer & d) {
+    olean_decl r;
+    r.m_kind   = d.read_char();
+    r.m_name   = read_name(d);
+    r.m_params = read_level_params(d);
+    d >> r.m_weight >> r.m_min_trust_lvl >> r.m_type_offset >> r.m_type_size >> r.m_value_offset >> r.m_value_size;
+    return r;
+}
+
+/** \brief Return the minimal trust level such that \c e does not contain untrusted macros.
+    \see unfold_untrusted_macros */
+static unsigned get_min_trust_lvl(expr const & e) {
+    unsigned r = 0;
+    for_each(e, [&](expr const & e, unsigned) {
+            if (is_macro(e))
+                r = std::max(r, macro_def(e).trust_level() + 1);
+            return true;
+        });
+    return r;
+}
+
+/** \brief Names and universe levels used by the declarations of a module.
+    Each type and value is serialized independently of the others, so without this table, a name
+    would be stored again in every declaration that uses it. \see write_expr_block */
+class olean_shared_table {
+    shared_name_table  m_names;
+    shared_level_table m_levels;
+    std::vector<name>  m_name_seq;  // names in the order of their positions
+    std::vector<level> m_level_seq; // levels in the order of their positions
+
+    void add(name const & n) {
+        if (m_names.insert(mk_pair(n, m_name_seq.size())).second)
+            m_name_seq.push_back(n);
+    }
+
+    void add(level const & l) {
+        if (m_levels.insert(mk_pair(l, m_level_seq.size())).second)
+            m_level_seq.push_back(l);
+    }
+
+    void collect(expr const & e) {
+        for_each(e, [&](expr const & e, unsigned) {
+                switch (e.kind()) {
+                case expr_kind::Constant:
+                    add(const_name(e));
+                    for (level const & l : const_levels(e))
+                        add(l);
+                    break;
+                case expr_kind::Sort:
+                    add(sort_level(e));
+                    break;
+                case expr_kind::Lambda: case expr_kind::Pi:
+                    add(binding_name(e));
+                    break;
+                default:
+                    break;
+                }
+                return true;
+            });
+    }
+
+public:
+    void collect(declaration const & d) {
+        collect(d.get_type());
+        if (d.is_definition())
+            collect(d.get_value());
+    }
+
+    void write(serializer & s) const {
+        s << static_cast<unsigned>(m_name_seq.size());
+        for (name const & n : m_name_seq)
+            s << n;
+        s << static_cast<unsigned>(m_level_seq.size());
+        for (level const & l : m_level_seq)
+            s << l;
+    }
+
+    /** \brief Make \c s write the names and levels in this table as references to their positions. */
+    void use_in(serializer & s) const {
+        set_shared_names(s, m_names);
+        set_shared_levels(s, m_levels);
+    }
+};
+
+/** \brief Read the names and levels written by olean_shared_table::write. */
+static void read_olean_shared_table(deserializer & d, std::vector<name> & names, std::vector<level> & levels) {
+    unsigned num_names = d.read_unsigned();
+    for (unsigned i = 0; i < num_names; i++)
+        names.push_back(read_name(d));
+    unsigned num_levels = d.read_unsigned();
+    for (unsigned i = 0; i < num_levels; i++)
+        levels.push_back(read_level(d));
+}
+
+/** \brief Serialize \c e at the end of \c data using a new serializer. */
+static void write_expr_block(std::vector<char> & data, expr const & e, olean_shared_table const & t,
+                             unsigned & offset, unsigned & size) {
+    offset = data.size();
+    serializer s(data);
+    t.use_in(s);
+    s << e;
+    size = data.size() - offset;
+}
+
+static olean_decl mk_olean_decl(declaration const & d, olean_shared_table const & t,
+                                std::vector<char> & data, std::vector<char> & proofs) {
+    olean_decl r;
+    if (d.is_definition()) {
+        r.m_kind |= 1;
+        if (d.is_opaque())
+            r.m_kind |= 2;
+        if (d.use_conv_opt())
+            r.m_kind |= 4;
+    }
+    if (d.is_theorem() || d.is_axiom())
+        r.m_kind |= 8;
+    r.m_name          = d.get_name();
+    r.m_params        = d.get_univ_params();
+    r.m_min_trust_lvl = get_min_trust_lvl(d.get_type());
+    write_expr_block(data, d.get_type(), t, r.m_type_offset, r.m_type_size);
+    if (d.is_definition()) {
+        if (!d.is_theorem())
+            r.m_weight = d.get_weight();
+        r.m_min_trust_lvl = std::max(r.m_min_trust_lvl, get_min_trust_lvl(d.get_value()));
+        write_expr_block(d.is_theorem() ? proofs : data, d.get_value(), t, r.m_value_offset, r.m_value_size);
+    }
+    return r;
+}
+
+void export_module(std::ostream & out, environment const & env, bool compress) {
     module_ext const & ext = get_extension(env);
     buffer<module_name> imports;
     buffer<writer const *> writers;
@@ -124,39 +334,316 @@ void export_module(std::ostream & out, environment const & env) {
         writers.push_back(&w);
     std::reverse(writers.begin(), writers.end());
 
-    std::ostringstream out1(std::ios_base::binary);
-    serializer s1(out1);
+    std::vector<char> code;
+    std::vector<char> decl_data;
+    std::vector<char> proofs;
+    buffer<olean_decl> decls;
+    olean_shared_table shared;
+    for (auto p : writers) {
+        if (p->m_decl)
+            shared.collect(*p->m_decl);
+    }
+    serializer s1(code);
 
     // store objects
     for (auto p : writers) {
-        s1 << p->first;
-        p->second(s1);
+        s1 << p->m_key;
+        if (p->m_decl) {
+            s1 << decls.size();
+            decls.push_back(mk_olean_decl(*p->m_decl, shared, decl_data, proofs));
+        } else {
+            p->m_fn(s1);
+        }
     }
     s1 << g_olean_end_file;
 
-    serializer s2(out);
-    std::string r = out1.str();
-    unsigned h    = hash(r.size(), [&](unsigned i) { return r[i]; });
-    s2 << g_olean_header << LEAN_VERSION_MAJOR << LEAN_VERSION_MINOR << LEAN_VERSION_PATCH;
-    s2 << h;
+    // table of contents, shared names and levels, object code and declaration data
+    std::vector<char> shared_data;
+    serializer s_shared(shared_data);
+    shared.write(s_shared);
+    std::vector<char> body;
+    serializer s2(body);
+    s2 << decls.size();
+    for (olean_decl const & d : decls)
+        s2 << d;
+    s2.write_unsigned(shared_data.size());
+    s2.write_block(shared_data.data(), shared_data.size());
+    s2.write_unsigned(code.size());
+    s2.write_block(code.data(), code.size());
+    s2.write_unsigned(decl_data.size());
+    s2.write_block(decl_data.data(), decl_data.size());
+
+    serializer s3(out);
+    uint64 h      = hash64(body.data(), body.size());
+    s3 << g_olean_header << LEAN_VERSION_MAJOR << LEAN_VERSION_MINOR << LEAN_VERSION_PATCH;
+    s3 << g_olean_format << h;
     // store imported files
-    s2 << imports.size();
+    s3 << imports.size();
     for (auto m : imports)
-        s2 << m;
-    // store object code
-    s2.write_unsigned(r.size());
-    for (unsigned i = 0; i < r.size(); i++)
-        s2.write_char(r[i]);
+        s3 << m;
+    uint64 proofs_h = hash64(proofs.data(), proofs.size());
+    if (compress) {
+        s3 << static_cast<unsigned>(olean_compression::LZ);
+        std::vector<char> tmp;
+        lz_compress_blocks(body.data(), body.size(), tmp);
+        body.swap(tmp);
+        tmp.clear();
+        lz_compress_blocks(proofs.data(), proofs.size(), tmp);
+        proofs.swap(tmp);
+    } else {
+        s3 << static_cast<unsigned>(olean_compression::None);
+    }
+    // store table of contents and object code
+    s3.write_unsigned(body.size());
+    s3.write_block(body.data(), body.size());
+    // store proofs
+    s3 << proofs_h;
+    s3.write_unsigned(proofs.size());
+    s3.write_block(proofs.data(), proofs.size());
 }
 
-typedef std::unordered_map<std::string, module_object_reader> object_readers;
+/** \brief Decoder for the declarations stored in an .olean file. */
+class olean_decl_decoder : public declaration_decoder {
+    std::shared_ptr<void const>  m_owner;  // keep the data alive (e.g., the mapped file)
+    std::string                  m_fname;  // used to report corrupted files
+    // Table used to share terms with other modules. It is only used while the modules are being imported.
+    // Declarations decoded after the import finishes are not interned, the table would keep alive all terms ever decoded.
+    std::weak_ptr<intern_table>  m_intern_table;
+    char const *                 m_data;   // declaration data, it is a subrange of the data owned by m_owner
+    unsigned                     m_data_size;
+    char const *                 m_proofs; // proofs section, it is nullptr if proofs were not loaded
+    unsigned                     m_proofs_size;
+    std::vector<olean_decl>      m_decls;
+    // Names and levels shared by all declarations, \see olean_shared_table.
+    // The table is only read when the first declaration is decoded, the import does not wait for it.
+    char const *                 m_shared;
+    unsigned                     m_shared_size;
+    mutable mutex                m_shared_mutex;
+    mutable atomic_bool          m_shared_read;
+    mutable std::vector<name>    m_names;
+    mutable std::vector<level>   m_levels;
+
+    void read_shared() const {
+        lock_guard<mutex> lock(m_shared_mutex);
+        if (m_shared_read.load(memory_order_acquire))
+            return;
+        deserializer d(m_shared, m_shared + m_shared_size);
+        read_olean_shared_table(d, m_names, m_levels);
+        m_shared_read.store(true, memory_order_release);
+    }
+
+    /** \brief Decode the expression stored at the given subrange of \c data.
+        \remark Lazy declarations are decoded after the import finishes, so corrupted data is
+        reported using corrupted_file_exception. */
+    expr decode(char const * data, unsigned data_size, unsigned offset, unsigned size) const {
+        try {
+            if (offset > data_size || size > data_size - offset)
+                throw corrupted_stream_exception();
+            intern_table_ptr t = m_intern_table.lock();
+            scoped_intern_table scope(t.get());
+            if (!m_shared_read.load(memory_order_acquire))
+                read_shared();
+            deserializer d(data + offset, data + offset + size);
+            set_shared_names(d, m_names);
+            set_shared_levels(d, m_levels);
+            return read_expr(d);
+        } catch (corrupted_stream_exception &) {
+            throw corrupted_file_exception(m_fname);
+        }
+    }
+
+public:
+    olean_decl_decoder(std::shared_ptr<void const> const & owner, std::string const & fname, intern_table_ptr const & t,
+                       char const * data, unsigned data_size,
+                       char const * proofs, unsigned proofs_size, std::vector<olean_decl> && decls,
+                       char const * shared, unsigned shared_size):
+        m_owner(owner), m_fname(fname), m_intern_table(t), m_data(data), m_data_size(data_size), m_proofs(proofs), m_proofs_size(proofs_size),
+        m_decls(std::move(decls)), m_shared(shared), m_shared_size(shared_size), m_shared_read(false) {}
+    unsigned size() const { return m_decls.size(); }
+    olean_decl const & get_entry(unsigned idx) const { return m_decls[idx]; }
+    virtual expr decode_type(unsigned idx) const {
+        olean_decl const & d = m_decls[idx];
+        return decode(m_data, m_data_size, d.m_type_offset, d.m_type_size);
+    }
+    virtual expr decode_value(unsigned idx) const {
+        olean_decl const & d = m_decls[idx];
+        if (d.is_theorem()) {
+            if (!m_proofs)
+                throw exception(sstream() << "proof of theorem '" << d.m_name << "' was not loaded");
+            return decode(m_proofs, m_proofs_size, d.m_value_offset, d.m_value_size);
+        }
+        return decode(m_data, m_data_size, d.m_value_offset, d.m_value_size);
+    }
+};
+typedef std::shared_ptr<olean_decl_decoder const> olean_decl_decoder_ptr;
+
+/** \brief Create the declaration stored at position \c idx of the declaration table.
+    Its type and value are only decoded when they are accessed.
+    If \c keep_proof is false, then theorems are converted into axioms. */
+static declaration mk_lazy_declaration(olean_decl_decoder_ptr const & dec, unsigned idx, module_idx midx, bool keep_proof) {
+    olean_decl const & d = dec->get_entry(idx);
+    if (d.has_value() && (keep_proof || !d.is_th_ax())) {
+        if (d.is_th_ax())
+            return mk_lazy_theorem(d.m_name, d.m_params, midx, dec, idx);
+        else
+            return mk_lazy_definition(d.m_name, d.m_params, d.is_opaque(), d.m_weight, midx, d.use_conv_opt(), dec, idx);
+    } else if (d.is_th_ax()) {
+        return mk_lazy_axiom(d.m_name, d.m_params, dec, idx);
+    } else {
+        return mk_lazy_constant_assumption(d.m_name, d.m_params, dec, idx);
+    }
+}
+
+/** \brief Create the declaration described by \c d using the given (already decoded) type and value.
+    If \c v is none, then theorems are converted into axioms. */
+static declaration mk_declaration(olean_decl const & d, expr const & t, optional<expr> const & v, module_idx midx) {
+    if (d.has_value() && v) {
+        if (d.is_th_ax())
+            return mk_theorem(d.m_name, d.m_params, t, *v, midx);
+        else
+            return mk_definition(d.m_name, d.m_params, t, *v, d.is_opaque(), d.m_weight, midx, d.use_conv_opt());
+    } else if (d.is_th_ax()) {
+        return mk_axiom(d.m_name, d.m_params, t);
+    } else {
+        return mk_constant_assumption(d.m_name, d.m_params, t);
+    }
+}
+
+/** \brief Job that is split in chunks that can be processed by different threads. */
+class chunk_job {
+    unsigned                          m_num_chunks;
+    atomic<unsigned>                  m_next_chunk;
+    mutex                             m_mutex;
+    condition_variable                m_cv;
+    unsigned                          m_num_done; // number of chunks processed, protected by m_mutex
+    std::unique_ptr<throwable>        m_ex;       // exception thrown when processing a chunk, protected by m_mutex
+protected:
+    virtual void process_chunk(unsigned c) = 0;
+    void set_num_chunks(unsigned n) { m_num_chunks = n; }
+public:
+    chunk_job():m_num_chunks(0), m_next_chunk(0), m_num_done(0) {}
+    virtual ~chunk_job() {}
+
+    unsigned get_num_chunks() const { return m_num_chunks; }
+
+    /** \brief Process chunks until all of them have been claimed. It can be invoked by many threads. */
+    void run() {
+        while (true) {
+            unsigned c = atomic_fetch_add_explicit(&m_next_chunk, 1u, memory_order_relaxed);
+            if (c >= m_num_chunks)
+                return;
+            std::unique_ptr<throwable> ex;
+            try {
+                check_interrupted();
+                process_chunk(c);
+            } catch (throwable & e) {
+                ex.reset(e.clone());
+            } catch (...) {
+                ex.reset(new exception("failed to import module for unknown reasons"));
+            }
+            lock_guard<mutex> lk(m_mutex);
+            if (ex && !m_ex)
+                m_ex.swap(ex);
+            m_num_done++;
+            if (m_num_done == m_num_chunks)
+                m_cv.notify_all();
+        }
+    }
+
+    /** \brief Wait for all chunks to be processed. */
+    void wait() {
+        unique_lock<mutex> lk(m_mutex);
+        while (m_num_done < m_num_chunks)
+            m_cv.wait(lk);
+        if (m_ex)
+            m_ex->rethrow();
+    }
+};
+typedef std::shared_ptr<chunk_job> chunk_job_ptr;
+
+/** \brief Approximate size (in bytes) of the chunks of declarations decoded by a single thread. */
+static unsigned g_decode_chunk_size = 64 * 1024;
+
+/** \brief Decode the type and value of the declarations that are not created lazily.
+    The declarations are split in chunks that can be decoded by different threads.
+    Remark: the type and value of each declaration are stored independently, and can be decoded in any order. */
+class decode_decls_job : public chunk_job {
+    olean_decl_decoder_ptr            m_decoder;
+    std::vector<unsigned>             m_idxs;   // declarations to be decoded
+    std::vector<unsigned>             m_chunks; // chunk i contains the declarations m_idxs[m_chunks[i] ... m_chunks[i+1]-1]
+    std::vector<expr>                 m_types;
+    std::vector<optional<expr>>       m_values;
+    std::vector<bool>                 m_decode_value;
+
+    virtual void process_chunk(unsigned c) {
+        for (unsigned i = m_chunks[c]; i < m_chunks[c+1]; i++) {
+            check_interrupted();
+            unsigned idx = m_idxs[i];
+            m_types[idx] = m_decoder->decode_type(idx);
+            if (m_decode_value[idx])
+                m_values[idx] = m_decoder->decode_value(idx);
+        }
+    }
+
+public:
+    decode_decls_job(olean_decl_decoder_ptr const & dec):
+        m_decoder(dec), m_types(dec->size()), m_values(dec->size()), m_decode_value(dec->size(), false) {}
+
+    /** \brief Mark declaration \c idx to be decoded eagerly. */
+    void add(unsigned idx, bool decode_value) {
+        m_idxs.push_back(idx);
+        m_decode_value[idx] = decode_value;
+    }
+
+    /** \brief Split the declarations marked by \c add in chunks. */
+    void mk_chunks() {
+        m_chunks.push_back(0);
+        unsigned sz = 0;
+        for (unsigned i = 0; i < m_idxs.size(); i++) {
+            olean_decl const & d = m_decoder->get_entry(m_idxs[i]);
+            sz += d.m_type_size;
+            if (m_decode_value[m_idxs[i]])
+                sz += d.m_value_size;
+            if (sz >= g_decode_chunk_size) {
+                m_chunks.push_back(i+1);
+                sz = 0;
+            }
+        }
+        if (m_chunks.back() != m_idxs.size())
+            m_chunks.push_back(m_idxs.size());
+        set_num_chunks(m_chunks.size() - 1);
+    }
+
+    expr const & get_type(unsigned idx) const { return m_types[idx]; }
+    optional<expr> const & get_value(unsigned idx) const { return m_values[idx]; }
+};
+typedef std::shared_ptr<decode_decls_job> decode_decls_job_ptr;
+
+/** \brief Verify and decompress the blocks of compressed .olean sections, each chunk is a block. */
+class decompress_job : public chunk_job {
+    std::string           m_fname;
+    std::vector<lz_block> m_blocks;
+    char *                m_out;
+    virtual void process_chunk(unsigned c) {
+        if (!lz_decompress_block(m_blocks[c], m_out))
+            throw exception(sstream() << "file '" << m_fname << "' has been corrupted, checksum mismatch");
+    }
+public:
+    decompress_job(std::string const & fname, std::vector<lz_block> const & blocks, char * out):
+        m_fname(fname), m_blocks(blocks), m_out(out) {
+        set_num_chunks(m_blocks.size());
+    }
+};
+
+
+typedef std::unordered_map<std::string, pair<module_object_reader, optional<unsigned>>> object_readers;
 static object_readers * g_object_readers = nullptr;
 static object_readers & get_object_readers() { return *g_object_readers; }
 
-void register_module_object_reader(std::string const & k, module_object_reader r) {
+void register_module_object_reader(std::string const & k, module_object_reader r, optional<unsigned> const & ext_id) {
     object_readers & readers = get_object_readers();
     lean_assert(readers.find(k) == readers.end());
-    readers[k] = r;
+    readers[k] = mk_pair(r, ext_id);
 }
 
 static std::string * g_glvl_key = nullptr;
@@ -170,6 +657,12 @@ environment add(environment const & env, std::string const & k, std::function<vo
     return update(env, ext);
 }
 
+static environment add_decl_writer(environment const & env, declaration const & d) {
+    module_ext ext = get_extension(env);
+    ext.m_writers  = cons(writer(*g_decl_key, d), ext.m_writers);
+    return update(env, ext);
+}
+
 environment add_universe(environment const & env, name const & l) {
     environment new_env = env.add_universe(l);
     return add(new_env, *g_glvl_key, [=](serializer & s) { s << l; });
@@ -189,13 +682,13 @@ environment add(environment const & env, certified_declaration const & d) {
     environment new_env = env.add(d);
     declaration _d = d.get_declaration();
     new_env = update_module_defs(new_env, _d);
-    return add(new_env, *g_decl_key, [=](serializer & s) { s << _d; });
+    return add_decl_writer(new_env, _d);
 }
 
 environment add(environment const & env, declaration const & d) {
     environment new_env = env.add(d);
     new_env = update_module_defs(new_env, d);
-    return add(new_env, *g_decl_key, [=](serializer & s) { s << d; });
+    return add_decl_writer(new_env, d);
 }
 
 bool is_definition(environment const & env, name const & n) {
@@ -228,28 +721,115 @@ environment add_inductive(environment const & env, name const & ind_name, level_
 }
 } // end of namespace module
 
+static import_cert_mode g_cert_mode = import_cert_mode::Ignore;
+static std::string *    g_cert_dir  = nullptr;
+
+void set_import_cert_store(std::string const & dir, import_cert_mode m) {
+    *g_cert_dir = dir;
+    g_cert_mode = m;
+}
+
+static std::string get_cert_file_name(std::string const & key) {
+    std::ostringstream out;
+    out << std::hex << hash64(key.c_str(), key.size()) << ".cert";
+    return path_append(g_cert_dir->c_str(), out.str().c_str());
+}
+
+/** \brief Return true if the certificate store contains a certificate for \c key. */
+static bool has_import_cert(std::string const & key) {
+    std::ifstream in(get_cert_file_name(key), std::ifstream::binary);
+    if (!in.good())
+        return false;
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return contents == key;
+}
+
+/** \brief Store a certificate for \c key. Errors are ignored since the store is just a cache. */
+static void save_import_cert(std::string const & key) {
+    std::string fname = get_cert_file_name(key);
+    std::string tmp   = fname + ".tmp";
+    {
+        std::ofstream out(tmp, std::ofstream::binary);
+        out << key;
+        if (!out.good()) {
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+#if defined(LEAN_WINDOWS)
+    std::remove(fname.c_str());
+#endif
+    if (std::rename(tmp.c_str(), fname.c_str()) != 0)
+        std::remove(tmp.c_str());
+}
+
+static std::string * g_import_profile = nullptr;
+
+void set_import_profile(std::string const & fname) {
+    *g_import_profile = fname;
+}
+
+static name * g_import_stats = nullptr;
+
+static bool get_import_stats(options const & opts) {
+    return opts.get_bool(*g_import_stats, LEAN_DEFAULT_IMPORT_STATS);
+}
+
+/** \brief Return the number of threads used for importing modules.
+    Remark: multiple threads are used even if declarations are not type checked. Independent modules,
+    the decompression of .olean files, the decoding of declarations, and the delayed updates of
+    different environment extensions are still processed concurrently. */
+#if defined(LEAN_MULTI_THREAD)
+static unsigned get_num_import_threads(unsigned num_threads) {
+    return std::max(num_threads, 1u);
+}
+#else
+static unsigned get_num_import_threads(unsigned) {
+    return 1;
+}
+#endif
+
+/** \brief Priority of the tasks that help processing the chunks of a job.
+    The thread that created the job is waiting for them. */
+static unsigned const g_chunk_task_priority   = std::numeric_limits<unsigned>::max();
+/** \brief Priority of the tasks that are not needed for importing other modules (e.g., type checking theorems). */
+static unsigned const g_default_task_priority = 0;
+
 struct import_modules_fn {
-    typedef std::tuple<module_idx, unsigned, delayed_update_fn> delayed_update;
+    typedef std::tuple<module_idx, unsigned, delayed_update_fn, optional<unsigned>> delayed_update;
     shared_environment             m_senv;
     unsigned                       m_num_threads;
     bool                           m_keep_proofs;
     io_state                       m_ios;
-    mutex                          m_asynch_mutex;
-    condition_variable             m_asynch_cv;
-    std::vector<asynch_update_fn>  m_asynch_tasks;
+    task_scheduler                 m_scheduler;
     mutex                          m_delayed_mutex;
     std::vector<delayed_update>    m_delayed_tasks;
+    std::vector<double>            m_delayed_secs; // time spent in each delayed update (only if profiling is enabled)
     atomic<unsigned>               m_next_module_idx;
     atomic<unsigned>               m_import_counter; // number of modules to be processed
-    atomic<bool>                   m_all_modules_imported;
+    // Terms are shared by all imported modules. The table is deleted when the import finishes.
+    intern_table_ptr               m_intern_table;
+    bool                           m_profile; // true if import profiling is enabled, see set_import_profile
 
     struct module_info {
         std::string                               m_fname;
         atomic<unsigned>                          m_counter; // number of dependencies to be processed
         unsigned                                  m_module_idx;
         std::vector<std::shared_ptr<module_info>> m_dependents;
-        std::vector<char>                         m_obj_code;
-        module_info():m_counter(0), m_module_idx(0) {}
+        std::shared_ptr<void const>               m_owner; // owner of the file contents (i.e., the mapped file)
+        char const *                              m_body; // table of contents and object code, it is a subrange of the file
+        unsigned                                  m_body_size;
+        char const *                              m_proofs; // nullptr if proofs are not needed
+        unsigned                                  m_proofs_size;
+        bool                                      m_compressed; // true if m_body and m_proofs are compressed
+        uint64                                    m_body_hash; // hash stored in the file, it is used as part of the certificate key
+        uint64                                    m_proofs_hash;
+        std::string                               m_cert_key; // empty if module cannot be certified
+        bool                                      m_certified; // true if a valid certificate was found
+        unsigned                                  m_priority; // 0 if it has not been computed yet, see get_priority
+        module_profile_ptr                        m_profile; // nullptr if profiling is disabled
+        module_info():m_counter(0), m_module_idx(0), m_body(nullptr), m_body_size(0), m_proofs(nullptr), m_proofs_size(0),
+                      m_compressed(false), m_body_hash(0), m_proofs_hash(0), m_certified(false), m_priority(0) {}
     };
     typedef std::shared_ptr<module_info> module_info_ptr;
     name_map<module_info_ptr> m_module_info;
@@ -257,20 +837,34 @@ struct import_modules_fn {
     name_set                  m_imported; // contains all imported files, even ones from previous calls
 
     import_modules_fn(environment const & env, unsigned num_threads, bool keep_proofs, io_state const & ios):
-        m_senv(env), m_num_threads(num_threads), m_keep_proofs(keep_proofs), m_ios(ios),
-        m_next_module_idx(1), m_import_counter(0), m_all_modules_imported(false) {
+        m_senv(env), m_num_threads(get_num_import_threads(num_threads)), m_keep_proofs(keep_proofs), m_ios(ios),
+        m_scheduler(m_num_threads), m_next_module_idx(1), m_import_counter(0),
+        m_intern_table(std::make_shared<intern_table>()), m_profile(!g_import_profile->empty()) {
         module_ext const & ext = get_extension(env);
         m_imported = ext.m_imported;
-        if (m_num_threads == 0)
-            m_num_threads = 1;
-#if !defined(LEAN_MULTI_THREAD)
-        if (m_num_threads > 1)
-            m_num_threads = 1;
-#endif
-        if (env.trust_lvl() > LEAN_BELIEVER_TRUST_LEVEL) {
-            // it doesn't payoff to use multiple threads if we will not type check anything
-            m_num_threads = 1;
-        }
+    }
+
+    /** \brief Return true if theorem values must be loaded, i.e., they are kept or type checked. */
+    bool proofs_needed(bool certified) const {
+        return m_keep_proofs || (!certified && m_senv.env().trust_lvl() <= LEAN_BELIEVER_TRUST_LEVEL);
+    }
+
+    /** \brief Return true if the declarations of imported modules must be type checked, and
+        the certificate store should be used. */
+    bool use_certs() const {
+        return g_cert_mode != import_cert_mode::Ignore && m_senv.env().trust_lvl() <= LEAN_BELIEVER_TRUST_LEVEL;
+    }
+
+    std::string mk_cert_key(uint64 body_hash, uint64 proofs_hash, buffer<module_info_ptr> const & imports) const {
+        environment const & env = m_senv.env();
+        std::ostringstream out;
+        out << "lean " << LEAN_VERSION_MAJOR << "." << LEAN_VERSION_MINOR << "." << LEAN_VERSION_PATCH
+            << " format " << g_olean_format << " trust " << env.trust_lvl()
+            << " kernel " << env.prop_proof_irrel() << env.eta() << env.impredicative()
+            << " module " << body_hash << " " << proofs_hash;
+        for (module_info_ptr const & i : imports)
+            out << " import " << hash64(i->m_cert_key.c_str(), i->m_cert_key.size());
+        return out.str();
     }
 
     module_info_ptr load_module_file(std::string const & base, module_name const & mname) {
@@ -284,69 +878,129 @@ struct import_modules_fn {
             throw exception(sstream() << "circular dependency detected at '" << fname << "'");
         m_visited.insert(fname);
         m_imported.insert(fname);
-        std::ifstream in(fname, std::ifstream::binary);
-        if (!in.good())
-            throw exception(sstream() << "failed to open file '" << fname << "'");
+        module_profile_ptr prof = m_profile ? std::make_shared<module_profile>(fname) : nullptr;
+        profile_timer timer;
+        double imports_secs = 0.0; // time spent loading the imported modules, it is not included in the profile
+        std::shared_ptr<mapped_file> file = std::make_shared<mapped_file>(fname);
+        std::shared_ptr<void const> owner = file;
+        char const * begin = file->begin();
+        char const * end   = file->end();
+        if (prof)
+            prof->m_bytes = end - begin;
         try {
-            deserializer d1(in);
+            deserializer d1(begin, end);
             std::string header;
             d1 >> header;
             if (header != g_olean_header)
                 throw exception(sstream() << "file '" << fname << "' does not seem to be a valid object Lean file, invalid header");
-            unsigned major, minor, patch, claimed_hash;
-            d1 >> major >> minor >> patch >> claimed_hash;
+            unsigned major, minor, patch, format;
+            uint64 claimed_hash;
+            d1 >> major >> minor >> patch >> format;
             // Enforce version?
+            if (format != g_olean_format)
+                throw exception(sstream() << "file '" << fname << "' was produced using an incompatible version of Lean, "
+                                << "please regenerate the file from sources");
+            d1 >> claimed_hash;
 
             unsigned num_imports  = d1.read_unsigned();
             buffer<module_name> imports;
             for (unsigned i = 0; i < num_imports; i++)
                 imports.push_back(read_module_name(d1));
 
-            unsigned code_size    = d1.read_unsigned();
-            std::vector<char> code(code_size);
-            for (unsigned i = 0; i < code_size; i++)
-                code[i] = d1.read_char();
+            unsigned compression  = d1.read_unsigned();
+            if (compression != static_cast<unsigned>(olean_compression::None) &&
+                compression != static_cast<unsigned>(olean_compression::LZ))
+                throw corrupted_stream_exception();
+            bool compressed       = compression == static_cast<unsigned>(olean_compression::LZ);
+
+            // The object code is verified in place, it is not copied.
+            // Compressed sections are verified after they are decompressed, see decompress.
+            unsigned body_size    = d1.read_unsigned();
+            char const * body     = d1.read_block(body_size);
 
-            unsigned computed_hash = hash(code_size, [&](unsigned i) { return code[i]; });
-            if (claimed_hash != computed_hash)
+            if (!compressed && claimed_hash != hash64(body, body_size))
                 throw exception(sstream() << "file '" << fname << "' has been corrupted, checksum mismatch");
 
+            uint64 proofs_claimed_hash = d1.read_uint64();
+            unsigned proofs_size  = d1.read_unsigned();
+            char const * proofs   = d1.read_block(proofs_size);
+
             module_info_ptr r = std::make_shared<module_info>();
             r->m_fname        = fname;
             r->m_counter      = 0;
             r->m_module_idx   = g_null_module_idx;
             m_import_counter++;
             std::string new_base = dirname(fname.c_str());
-            std::swap(r->m_obj_code, code);
-            bool has_dependency = false;
+            r->m_owner         = owner;
+            r->m_body          = body;
+            r->m_body_size     = body_size;
+            r->m_compressed    = compressed;
+            r->m_body_hash     = claimed_hash;
+            r->m_proofs_hash   = proofs_claimed_hash;
+            r->m_profile       = prof;
+            bool certifiable    = use_certs();
+            buffer<module_info_ptr> import_infos;
             for (auto i : imports) {
-                if (auto d = load_module_file(new_base, i)) {
+                profile_timer imports_timer;
+                auto d = load_module_file(new_base, i);
+                imports_secs += imports_timer.elapsed();
+                if (d) {
                     r->m_counter++;
                     d->m_dependents.push_back(r);
-                    has_dependency = true;
+                    import_infos.push_back(d);
+                    if (prof)
+                        prof->m_imports.push_back(d->m_module_idx);
+                    if (d->m_cert_key.empty())
+                        certifiable = false;
+                } else {
+                    // module was imported in a previous call
+                    certifiable = false;
                 }
             }
+            if (certifiable) {
+                r->m_cert_key  = mk_cert_key(claimed_hash, proofs_claimed_hash, import_infos);
+                r->m_certified = has_import_cert(r->m_cert_key);
+            }
+
+            // The proofs section is only read (and verified) if proofs are needed.
+            if (proofs_needed(r->m_certified)) {
+                if (!compressed && proofs_claimed_hash != hash64(proofs, proofs_size))
+                    throw exception(sstream() << "file '" << fname << "' has been corrupted, checksum mismatch");
+                r->m_proofs      = proofs;
+                r->m_proofs_size = proofs_size;
+            }
             m_module_info.insert(fname, r);
             r->m_module_idx = m_next_module_idx++;
-
-            if (!has_dependency)
-                add_import_module_task(r);
+            if (prof) {
+                prof->m_module_idx = r->m_module_idx;
+                prof->m_read_secs  = timer.elapsed() - imports_secs;
+            }
             return r;
         } catch (corrupted_stream_exception&) {
             throw corrupted_file_exception(fname);
         }
     }
 
-    void add_asynch_task(asynch_update_fn const & f) {
-        {
-            lock_guard<mutex> l(m_asynch_mutex);
-            m_asynch_tasks.push_back(f);
+    void add_asynch_task(asynch_update_fn const & f, unsigned priority = g_default_task_priority) {
+        m_scheduler.add([=]() { f(m_senv); }, priority);
+    }
+
+    /** \brief Return the priority of the task for importing \c r.
+        Modules at the beginning of long chains of dependent modules (i.e., in the critical path) are imported first.
+        Ties are broken using the number of modules that directly depend on \c r.
+        \remark The priority of the tasks that are not needed for importing modules is g_default_task_priority. */
+    unsigned get_priority(module_info_ptr const & r) {
+        if (r->m_priority == 0) {
+            unsigned height = 0; // length of the longest chain of modules depending on r
+            for (module_info_ptr const & d : r->m_dependents)
+                height = std::max(height, get_priority(d) >> 8);
+            r->m_priority = ((height + 1) << 8) | std::min<unsigned>(r->m_dependents.size(), 255);
         }
-        m_asynch_cv.notify_one();
+        return r->m_priority;
     }
 
     void add_import_module_task(module_info_ptr const & r) {
-        add_asynch_task([=](shared_environment &) { import_module(r); });
+        add_asynch_task([=](shared_environment &) { import_module(r); }, get_priority(r));
     }
 
     declaration theorem2axiom(declaration const & decl) {
@@ -354,35 +1008,95 @@ struct import_modules_fn {
         return mk_axiom(decl.get_name(), decl.get_univ_params(), decl.get_type());
     }
 
-    void import_decl(deserializer & d, module_idx midx) {
-        declaration decl = read_declaration(d, midx);
-        lean_assert(!decl.is_definition() || decl.get_module_idx() == midx);
+    /** \brief Return true if the declaration \c d is created lazily, i.e., its type and value
+        are only decoded when they are needed. */
+    bool is_lazy(olean_decl const & d, bool certified) const {
+        unsigned trust_lvl = m_senv.env().trust_lvl();
+        // The declaration will not be type checked, and it does not contain untrusted macros.
+        return d.m_min_trust_lvl <= trust_lvl && (trust_lvl > LEAN_BELIEVER_TRUST_LEVEL || certified);
+    }
+
+    /** \brief Process the given job. The import threads help processing its chunks. */
+    void run_job(chunk_job_ptr const & job) {
+        if (m_num_threads > 1) {
+            for (unsigned i = 1; i < std::min(job->get_num_chunks(), m_num_threads); i++)
+                m_scheduler.add([=]() { job->run(); }, g_chunk_task_priority);
+        }
+        job->run();
+        job->wait();
+    }
+
+    /** \brief Create a job for decoding the declarations that are not created lazily,
+        and decode them. If the module is big, the job is split in chunks. */
+    decode_decls_job_ptr decode_decls(olean_decl_decoder_ptr const & dec, bool certified) {
+        auto job = std::make_shared<decode_decls_job>(dec);
+        // Theorem values are only needed if they are kept or type checked
+        bool keep_proof = proofs_needed(certified);
+        for (unsigned idx = 0; idx < dec->size(); idx++) {
+            olean_decl const & d = dec->get_entry(idx);
+            if (!is_lazy(d, certified))
+                job->add(idx, d.has_value() && (keep_proof || !d.is_th_ax()));
+        }
+        job->mk_chunks();
+        run_job(job);
+        return job;
+    }
+
+    /** \brief Type check \c d. If \c prof is not nullptr, the time spent in the kernel is recorded. */
+    certified_declaration check_decl(module_profile_ptr const & prof, environment const & env, declaration const & d) {
+        if (!prof)
+            return check(env, d);
+        profile_timer timer;
+        certified_declaration r = check(env, d);
+        prof->add_check(d.get_name(), timer.elapsed());
+        return r;
+    }
+
+    void import_decl(olean_decl_decoder_ptr const & dec, decode_decls_job const & job, unsigned idx, module_idx midx,
+                     bool certified, module_profile_ptr const & prof) {
+        if (idx >= dec->size())
+            throw corrupted_stream_exception();
+        olean_decl const & entry = dec->get_entry(idx);
         environment env  = m_senv.env();
-        decl = unfold_untrusted_macros(env, decl);
-        if (decl.get_name() == get_sorry_name() && has_sorry(env))
+        if (entry.m_name == get_sorry_name() && has_sorry(env))
+            return;
+        if (is_lazy(entry, certified)) {
+            declaration decl = mk_lazy_declaration(dec, idx, midx, m_keep_proofs);
+            if (env.trust_lvl() > LEAN_BELIEVER_TRUST_LEVEL)
+                m_senv.add(decl);
+            else // The declaration has been type checked before (see import certificates).
+                m_senv.add(certify_unchecked(env, decl));
             return;
+        }
+        declaration decl = mk_declaration(entry, job.get_type(idx), job.get_value(idx), midx);
+        lean_assert(!decl.is_definition() || decl.get_module_idx() == midx);
+        decl = unfold_untrusted_macros(env, decl);
         if (env.trust_lvl() > LEAN_BELIEVER_TRUST_LEVEL) {
             if (!m_keep_proofs && decl.is_theorem())
                 m_senv.add(theorem2axiom(decl));
             else
                 m_senv.add(decl);
+        } else if (certified) {
+            if (!m_keep_proofs && decl.is_theorem())
+                decl = theorem2axiom(decl);
+            m_senv.add(certify_unchecked(env, decl));
         } else if (LEAN_ASYNCH_IMPORT_THEOREM && decl.is_theorem()) {
             // First, we add the theorem as an axiom, and create an asychronous task for
             // checking the actual theorem, and replace the axiom with the actual theorem.
-            certified_declaration tmp_c = check(env, theorem2axiom(decl));
+            certified_declaration tmp_c = check_decl(prof, env, theorem2axiom(decl));
             m_senv.add(tmp_c);
             add_asynch_task([=](shared_environment & m_senv) {
-                    certified_declaration c = check(env, decl);
+                    certified_declaration c = check_decl(prof, env, decl);
                     if (m_keep_proofs)
                         m_senv.replace(c);
                 });
         } else {
             if (!m_keep_proofs && decl.is_theorem()) {
                 // check theorem, but add an axiom
-                check(env, decl);
-                m_senv.add(check(env, theorem2axiom(decl)));
+                check_decl(prof, env, decl);
+                m_senv.add(check_decl(prof, env, theorem2axiom(decl)));
             } else {
-                certified_declaration c = check(env, decl);
+                certified_declaration c = check_decl(prof, env, decl);
                 m_senv.add(c);
             }
         }
@@ -393,17 +1107,80 @@ struct import_modules_fn {
         m_senv.update([=](environment const & env) { return env.add_universe(l); });
     }
 
+    /** \brief Decompress the body and proofs sections of \c r, and store the result in \c data. */
+    void decompress(module_info_ptr const & r, std::vector<char> & data) {
+        try {
+            std::vector<lz_block> blocks, proofs_blocks;
+            unsigned body_size   = lz_read_blocks(r->m_body, r->m_body_size, blocks);
+            unsigned proofs_size = 0;
+            if (r->m_proofs) {
+                proofs_size = lz_read_blocks(r->m_proofs, r->m_proofs_size, proofs_blocks);
+                for (lz_block & b : proofs_blocks) {
+                    b.m_raw_offset += body_size;
+                    blocks.push_back(b);
+                }
+            }
+            {
+                memory_scope mscope(g_olean_memory);
+                data.resize(body_size + proofs_size);
+            }
+            run_job(std::make_shared<decompress_job>(r->m_fname, blocks, data.data()));
+            // The block checksums only protect the compressed data. The hashes stored in the file
+            // are used to build certificate keys, so they must match the decompressed sections.
+            if (r->m_body_hash != hash64(data.data(), body_size) ||
+                (r->m_proofs && r->m_proofs_hash != hash64(data.data() + body_size, proofs_size)))
+                throw exception(sstream() << "file '" << r->m_fname << "' has been corrupted, checksum mismatch");
+            r->m_body      = data.data();
+            r->m_body_size = body_size;
+            if (r->m_proofs) {
+                r->m_proofs      = data.data() + body_size;
+                r->m_proofs_size = proofs_size;
+            }
+        } catch (corrupted_stream_exception &) {
+            throw corrupted_file_exception(r->m_fname);
+        }
+    }
+
     void import_module(module_info_ptr const & r) {
-        std::string s(r->m_obj_code.data(), r->m_obj_code.size());
-        std::istringstream in(s, std::ios_base::binary);
-        deserializer d(in);
+        scoped_intern_table scope(m_intern_table.get());
+        module_profile_ptr const & prof = r->m_profile;
+        profile_timer timer;
+        std::shared_ptr<void const> owner = r->m_owner;
+        if (r->m_compressed) {
+            auto data = std::make_shared<std::vector<char>>();
+            decompress(r, *data);
+            owner = data;
+        }
+        // read table of contents
+        deserializer d0(r->m_body, r->m_body + r->m_body_size);
+        unsigned num_decls     = d0.read_unsigned();
+        std::vector<olean_decl> decls;
+        decls.reserve(num_decls);
+        for (unsigned i = 0; i < num_decls; i++)
+            decls.push_back(read_olean_decl(d0));
+        unsigned shared_size   = d0.read_unsigned();
+        char const * shared    = d0.read_block(shared_size);
+        unsigned code_size     = d0.read_unsigned();
+        char const * code      = d0.read_block(code_size);
+        unsigned decl_data_size = d0.read_unsigned();
+        char const * decl_data = d0.read_block(decl_data_size);
+        auto dec = std::make_shared<olean_decl_decoder const>(owner, r->m_fname, m_intern_table,
+                                                              decl_data, decl_data_size,
+                                                              r->m_proofs, r->m_proofs_size, std::move(decls),
+                                                              shared, shared_size);
+        decode_decls_job_ptr job = decode_decls(dec, r->m_certified);
+        if (prof)
+            prof->m_decode_secs = timer.elapsed();
+
+        deserializer d(code, code + code_size);
         unsigned obj_counter = 0;
         std::function<void(asynch_update_fn const &)> add_asynch_update([&](asynch_update_fn const & f) {
                 add_asynch_task(f);
             });
+        optional<unsigned> ext_id; // extension modified by the delayed updates of the current reader
         std::function<void(delayed_update_fn const &)> add_delayed_update([&](delayed_update_fn const & f) {
                 lock_guard<mutex> lk(m_delayed_mutex);
-                m_delayed_tasks.push_back(std::make_tuple(r->m_module_idx, obj_counter, f));
+                m_delayed_tasks.push_back(std::make_tuple(r->m_module_idx, obj_counter, f, ext_id));
             });
         while (true) {
             check_interrupted();
@@ -412,7 +1189,7 @@ struct import_modules_fn {
             if (k == g_olean_end_file) {
                 break;
             } else if (k == *g_decl_key) {
-                import_decl(d, r->m_module_idx);
+                import_decl(dec, *job, d.read_unsigned(), r->m_module_idx, r->m_certified, prof);
             } else if (k == *g_glvl_key) {
                 import_universe(d);
             } else {
@@ -420,14 +1197,30 @@ struct import_modules_fn {
                 auto it = readers.find(k);
                 if (it == readers.end())
                     throw exception(sstream() << "file '" << r->m_fname << "' has been corrupted, unknown object");
-                it->second(d, r->m_module_idx, m_senv, add_asynch_update, add_delayed_update);
+                ext_id = it->second.second;
+                if (prof) {
+                    profile_timer reader_timer;
+                    it->second.first(d, r->m_module_idx, m_senv, add_asynch_update, add_delayed_update);
+                    prof->m_reader_secs[k] += reader_timer.elapsed();
+                } else {
+                    it->second.first(d, r->m_module_idx, m_senv, add_asynch_update, add_delayed_update);
+                }
             }
             obj_counter++;
         }
+        // The object code is not needed anymore.
+        // Remark: lazy declarations keep the data alive using dec.
+        r->m_body        = nullptr;
+        r->m_body_size   = 0;
+        r->m_proofs      = nullptr;
+        r->m_proofs_size = 0;
+        r->m_owner.reset();
+        if (prof)
+            prof->m_import_secs = timer.elapsed();
         if (atomic_fetch_sub_explicit(&m_import_counter, 1u, memory_order_release) == 1u) {
             atomic_thread_fence(memory_order_acquire);
-            m_all_modules_imported = true;
-            m_asynch_cv.notify_all();
+            // Remark: pending tasks (e.g., type checking theorems) are still executed.
+            m_scheduler.done();
         }
         // Module was successfully imported, we should notify descendents.
         for (module_info_ptr const & d : r->m_dependents) {
@@ -439,61 +1232,76 @@ struct import_modules_fn {
         }
     }
 
-    optional<asynch_update_fn> next_task() {
-        while (true) {
-            check_interrupted();
-            unique_lock<mutex> lk(m_asynch_mutex);
-            if (!m_asynch_tasks.empty()) {
-                asynch_update_fn r = m_asynch_tasks.back();
-                m_asynch_tasks.pop_back();
-                return optional<asynch_update_fn>(r);
-            } else if (m_all_modules_imported) {
-                return optional<asynch_update_fn>();
-            } else {
-                m_asynch_cv.wait(lk);
-            }
+    void process_asynch_tasks() {
+        if (m_import_counter == 0)
+            return;
+        m_module_info.for_each([&](name const &, module_info_ptr const & r) {
+                if (r->m_counter == 0)
+                    add_import_module_task(r);
+            });
+        m_scheduler.run();
+        if (get_import_stats(m_ios.get_options())) {
+            std::ostream & out = m_ios.get_diagnostic_channel().get_stream();
+            out << "import statistics, " << m_module_info.size() << " module(s)\n";
+            m_scheduler.display_stats(out);
+            if (closed_term_cache_ptr const & c = get_closed_term_cache(m_senv.env()))
+                c->display_stats(out);
         }
     }
 
-    void process_asynch_tasks() {
-        if (m_asynch_tasks.empty())
-            return;
-        std::vector<std::unique_ptr<interruptible_thread>> extra_threads;
-        std::vector<std::unique_ptr<throwable>> thread_exceptions(m_num_threads - 1);
-        atomic<int> failed_thread_idx(-1); // >= 0 if error
-        for (unsigned i = 0; i < m_num_threads - 1; i++) {
-            extra_threads.push_back(std::unique_ptr<interruptible_thread>(new interruptible_thread([=, &thread_exceptions, &failed_thread_idx]() {
-                            try {
-                                while (auto t = next_task()) {
-                                    (*t)(m_senv);
-                                }
-                                m_asynch_cv.notify_all();
-                            } catch (throwable & ex) {
-                                thread_exceptions[i].reset(ex.clone());
-                                failed_thread_idx = i;
-                            } catch (...) {
-                                thread_exceptions[i].reset(new exception("module import thread failed for unknown reasons"));
-                                failed_thread_idx = i;
-                            }
-                        })));
+    /** \brief Execute the delayed updates <tt>m_delayed_tasks[begin, end)</tt> starting at \c env.
+        All of them are associated with an environment extension. The updates associated with the
+        same extension are executed sequentially (in the given order), and the ones associated with
+        different extensions are executed concurrently. */
+    environment process_delayed_tasks(environment const & env, unsigned begin, unsigned end) {
+        std::vector<unsigned> ext_ids;
+        std::vector<std::vector<unsigned>> groups; // positions in m_delayed_tasks
+        for (unsigned i = begin; i < end; i++) {
+            unsigned ext_id = *std::get<3>(m_delayed_tasks[i]);
+            auto it = std::find(ext_ids.begin(), ext_ids.end(), ext_id);
+            if (it == ext_ids.end()) {
+                ext_ids.push_back(ext_id);
+                groups.emplace_back();
+                it = ext_ids.end() - 1;
+            }
+            groups[it - ext_ids.begin()].push_back(i);
         }
-        try {
-            while (auto t = next_task()) {
-                (*t)(m_senv);
-                int idx = failed_thread_idx;
-                if (idx >= 0)
-                    thread_exceptions[idx]->rethrow();
+        std::vector<environment> results(groups.size(), env);
+        auto run_group = [&](unsigned i) {
+            io_state ios(m_ios);
+            for (unsigned j : groups[i])
+                results[i] = apply_delayed_task(j, results[i], ios);
+        };
+        if (groups.size() > 1 && m_num_threads > 1) {
+            // The import threads are not needed for importing modules anymore.
+            m_scheduler.reset();
+            atomic<unsigned> pending(groups.size());
+            for (unsigned i = 0; i < groups.size(); i++) {
+                // larger groups first
+                m_scheduler.add([&, i]() {
+                        run_group(i);
+                        if (--pending == 0)
+                            m_scheduler.done();
+                    }, groups[i].size());
             }
-            m_asynch_cv.notify_all();
-            for (auto & th : extra_threads)
-                th->join();
-        } catch (...) {
-            for (auto & th : extra_threads)
-                th->request_interrupt();
-            for (auto & th : extra_threads)
-                th->join();
-            throw;
+            m_scheduler.run();
+        } else {
+            for (unsigned i = 0; i < groups.size(); i++)
+                run_group(i);
         }
+        environment r = env;
+        for (unsigned i = 0; i < groups.size(); i++)
+            r = r.update(ext_ids[i], results[i]);
+        return r;
+    }
+
+    environment apply_delayed_task(unsigned i, environment const & env, io_state const & ios) {
+        if (!m_profile)
+            return std::get<2>(m_delayed_tasks[i])(env, ios);
+        profile_timer timer;
+        environment r = std::get<2>(m_delayed_tasks[i])(env, ios);
+        m_delayed_secs[i] = timer.elapsed();
+        return r;
     }
 
     environment process_delayed_tasks() {
@@ -507,10 +1315,20 @@ struct import_modules_fn {
                       else
                           return std::get<1>(u1) < std::get<1>(u2);
                   });
-        for (auto const & d : m_delayed_tasks) {
-            env = std::get<2>(d)(env, m_ios);
+        if (m_profile)
+            m_delayed_secs.resize(m_delayed_tasks.size(), 0.0);
+        // Maximal sequences of updates associated with extensions are processed concurrently.
+        // The updates that are not associated with an extension are barriers.
+        unsigned begin = 0;
+        for (unsigned i = 0; i < m_delayed_tasks.size(); i++) {
+            delayed_update const & d = m_delayed_tasks[i];
+            if (!std::get<3>(d)) {
+                env   = process_delayed_tasks(env, begin, i);
+                env   = apply_delayed_task(i, env, m_ios);
+                begin = i + 1;
+            }
         }
-        return env;
+        return process_delayed_tasks(env, begin, m_delayed_tasks.size());
     }
 
     void store_direct_imports(std::string const & base, unsigned num_modules, module_name const * modules) {
@@ -532,12 +1350,44 @@ struct import_modules_fn {
             });
     }
 
+    /** \brief Display the profiling report, and store it in the file provided to set_import_profile. */
+    void display_profile(double total_secs, double delayed_secs) {
+        std::unordered_map<unsigned, module_profile_ptr> profiles; // module index -> profile
+        std::vector<module_profile_ptr> modules;
+        m_module_info.for_each([&](name const &, module_info_ptr const & r) {
+                profiles[r->m_module_idx] = r->m_profile;
+                modules.push_back(r->m_profile);
+            });
+        for (unsigned i = 0; i < m_delayed_tasks.size(); i++) {
+            auto it = profiles.find(std::get<0>(m_delayed_tasks[i]));
+            if (it != profiles.end())
+                it->second->m_delayed_secs += m_delayed_secs[i];
+        }
+        import_profile p(modules, total_secs, delayed_secs);
+        p.display(m_ios.get_diagnostic_channel().get_stream());
+        std::ofstream out(*g_import_profile);
+        p.display_json(out);
+        if (!out)
+            throw exception(sstream() << "failed to write import profile to file '" << *g_import_profile << "'");
+    }
+
     environment operator()(std::string const & base, unsigned num_modules, module_name const * modules) {
+        profile_timer timer;
         store_direct_imports(base, num_modules, modules);
         for (unsigned i = 0; i < num_modules; i++)
             load_module_file(base, modules[i]);
         process_asynch_tasks();
+        profile_timer delayed_timer;
         environment env = process_delayed_tasks();
+        if (m_profile)
+            display_profile(timer.elapsed(), delayed_timer.elapsed());
+        if (g_cert_mode == import_cert_mode::Populate) {
+            // All imported declarations have been successfully type checked.
+            m_module_info.for_each([&](name const &, module_info_ptr const & r) {
+                    if (!r->m_certified && !r->m_cert_key.empty())
+                        save_import_cert(r->m_cert_key);
+                });
+        }
         module_ext ext = get_extension(env);
         ext.m_imported = m_imported;
         return update(env, ext);
@@ -555,15 +1405,24 @@ environment import_module(environment const & env, std::string const & base, mod
 }
 
 void initialize_module() {
+    g_olean_memory   = register_memory_category("olean buffers");
     g_ext            = new module_ext_reg();
     g_object_readers = new object_readers();
     g_glvl_key       = new std::string("glvl");
     g_decl_key       = new std::string("decl");
     g_inductive      = new std::string("ind");
+    g_cert_dir       = new std::string();
+    g_import_profile = new std::string();
+    g_import_stats   = new name{"import", "stats"};
+    register_bool_option(*g_import_stats, LEAN_DEFAULT_IMPORT_STATS,
+                         "(import) display per-thread statistics at the end of an import");
     register_module_object_reader(*g_inductive, module::inductive_reader);
 }
 
 void finalize_module() {
+    delete g_import_stats;
+    delete g_import_profile;
+    delete g_cert_dir;
     delete g_inductive;
     delete g_decl_key;
     delete g_glvl_key;
@@ -43,6 +43,29 @@ environment import_modules(environment const & env, std::string const & base, un
 environment import_module(environment const & env, std::string const & base, module_name const & module,
                           unsigned num_threads, bool keep_proofs, io_state const & ios);
 
+/** \brief Modes for the import certificate store.
+
+    When a module is imported with trust level <= LEAN_BELIEVER_TRUST_LEVEL, all its declarations are type checked.
+    The certificate store is a directory containing one certificate for each module that has been successfully
+    checked. A certificate is keyed by the module content hash, the kernel configuration, and the certificates
+    of the imported modules. When a valid certificate is found, the module declarations are added to the
+    environment without being type checked again.
+
+    - Ignore:   the store is not used.
+    - Use:      valid certificates are used, but new certificates are not stored.
+    - Populate: valid certificates are used, and certificates are stored for modules that were type checked.
+*/
+enum class import_cert_mode { Ignore, Use, Populate };
+/** \brief Set the certificate store used by \c import_modules. The directory \c dir must exist. */
+void set_import_cert_store(std::string const & dir, import_cert_mode m);
+
+/** \brief Profile \c import_modules. For each imported module, it records the number of bytes read,
+    the time spent reading/verifying, decoding, type checking each declaration, executing extension readers
+    (grouped by key) and delayed updates. At the end of an import, the report (including the critical path
+    of the import DAG) is displayed in the diagnostic channel, and stored in JSON format in the file \c fname.
+    The profiler is disabled if \c fname is empty. */
+void set_import_profile(std::string const & fname);
+
 /** \brief Return the direct imports of the main module in the given environment. */
 list<module_name> get_direct_imports(environment const & env);
 
@@ -50,8 +73,9 @@ list<module_name> get_direct_imports(environment const & env);
     been modified in the file system. */
 bool direct_imports_have_changed(environment const & env);
 
-/** \brief Store/Export module using \c env to the output stream \c out. */
-void export_module(std::ostream & out, environment const & env);
+/** \brief Store/Export module using \c env to the output stream \c out.
+    If \c compress is true, then the object code and proofs are compressed. */
+void export_module(std::ostream & out, environment const & env, bool compress = false);
 
 /** \brief An asynchronous update. It goes into a task queue, and can be executed by a different execution thread. */
 typedef std::function<void(shared_environment & env)> asynch_update_fn;
@@ -75,8 +99,15 @@ typedef void (*module_object_reader)(deserializer & d, module_idx midx, shared_e
 
 /** \brief Register a module object reader. The key \c k is used to identify the class of objects
     that can be read by the given reader.
+
+    If \c ext_id is provided, then the delayed updates created by \c r only modify the environment
+    extension \c ext_id, and they do not read any other part of the environment.
+    Delayed updates associated with different extensions are executed concurrently starting at the same
+    environment, and the delayed updates associated with the same extension are still executed based on the import order.
+    Delayed updates that are not associated with an extension are executed after all preceding ones.
 */
-void register_module_object_reader(std::string const & k, module_object_reader r);
+void register_module_object_reader(std::string const & k, module_object_reader r,
+                                   optional<unsigned> const & ext_id = optional<unsigned>());
 
 namespace module {
 /** \brief Add a function that should be invoked when the environment is exported.
@@ -0,0 +1,280 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <string>
+#include "kernel/inductive/inductive.h"
+#include "library/kernel_serializer.h"
+#include "library/nat_value.h"
+#include "library/num.h"
+#include "library/constants.h"
+
+namespace lean {
+static name * g_nat_value_macro         = nullptr;
+static std::string * g_nat_value_opcode = nullptr;
+static expr * g_nat                     = nullptr;
+static expr * g_nat_zero                = nullptr;
+static expr * g_nat_succ                = nullptr;
+static expr * g_nat_of_num              = nullptr;
+static expr * g_nat_op_type             = nullptr; // nat -> nat -> nat
+
+/** \brief Macro for encoding natural number literals. */
+class nat_value_macro : public macro_definition_cell {
+    mpz m_value;
+public:
+    nat_value_macro(mpz const & v):m_value(v) {}
+    virtual bool lt(macro_definition_cell const & d) const {
+        return m_value < static_cast<nat_value_macro const &>(d).m_value;
+    }
+    virtual name get_name() const { return *g_nat_value_macro; }
+    virtual pair<expr, constraint_seq> get_type(expr const &, extension_context &) const {
+        return mk_pair(*g_nat, constraint_seq());
+    }
+    virtual optional<expr> expand(expr const &, extension_context &) const {
+        if (m_value.is_zero())
+            return some_expr(*g_nat_zero);
+        else
+            return some_expr(mk_app(*g_nat_succ, mk_nat_value(m_value - 1)));
+    }
+    virtual unsigned trust_level() const { return 0; }
+    virtual bool operator==(macro_definition_cell const & other) const {
+        nat_value_macro const * other_ptr = dynamic_cast<nat_value_macro const *>(&other);
+        return other_ptr && m_value == other_ptr->m_value;
+    }
+    virtual void display(std::ostream & out) const { out << m_value; }
+    virtual format pp(formatter const &) const { return format(m_value); }
+    virtual bool is_atomic_pp(bool, bool) const { return true; }
+    virtual unsigned hash() const { return m_value.hash(); }
+    virtual void write(serializer & s) const { s << *g_nat_value_opcode << m_value; }
+    mpz const & get_value() const { return m_value; }
+};
+
+expr mk_nat_value(mpz const & v) {
+    lean_assert(v.is_nonneg());
+    return mk_macro(macro_definition(new nat_value_macro(v)));
+}
+
+bool is_nat_value(expr const & e) {
+    return is_macro(e) && dynamic_cast<nat_value_macro const *>(macro_def(e).raw()) != nullptr;
+}
+
+mpz const & get_nat_value_value(expr const & e) {
+    lean_assert(is_nat_value(e));
+    return static_cast<nat_value_macro const *>(macro_def(e).raw())->get_value();
+}
+
+optional<mpz> to_nat_value(expr const & e) {
+    if (is_nat_value(e)) {
+        return some(get_nat_value_value(e));
+    } else if (e == *g_nat_zero) {
+        return some(mpz(0));
+    } else if (is_app(e) && app_fn(e) == *g_nat_succ) {
+        if (auto v = to_nat_value(app_arg(e)))
+            return some(*v + 1);
+    } else if (is_app(e) && app_fn(e) == *g_nat_of_num) {
+        return to_num(app_arg(e));
+    }
+    return optional<mpz>();
+}
+
+expr nat_value_to_numeral(expr const & e) {
+    return mk_app(*g_nat_of_num, from_num(get_nat_value_value(e)));
+}
+
+/** \brief Operations implemented by the extension. */
+enum class nat_op { Add, Mul, Sub, Div, Mod, DecEq, DecLe };
+
+class nat_normalizer_extension : public normalizer_extension {
+    static optional<nat_op> get_op(name const & n) {
+        if (n == get_nat_add_name())             return optional<nat_op>(nat_op::Add);
+        if (n == get_nat_mul_name())             return optional<nat_op>(nat_op::Mul);
+        if (n == get_nat_sub_name())             return optional<nat_op>(nat_op::Sub);
+        if (n == get_nat_divide_name())          return optional<nat_op>(nat_op::Div);
+        if (n == get_nat_modulo_name())          return optional<nat_op>(nat_op::Mod);
+        if (n == get_nat_has_decidable_eq_name()) return optional<nat_op>(nat_op::DecEq);
+        if (n == get_nat_decidable_le_name())    return optional<nat_op>(nat_op::DecLe);
+        return optional<nat_op>();
+    }
+
+    /** \brief Return true iff \c n is a definition imported from another module.
+        The extension does not check the bodies of the operations, so it must not be used for definitions of
+        the current module: a prelude file could define <tt>nat.add</tt> with a different body, and the kernel would
+        accept both the result computed by the extension and the one obtained by unfolding the definition.
+        Imported modules are trusted at the trust levels where the extension is used (\see mk_environment). */
+    static bool is_imported_definition(environment const & env, name const & n) {
+        auto d = env.find(n);
+        return d && d->is_definition() && d->get_module_idx() != g_main_module_idx;
+    }
+
+    static bool is_imported_definition(environment const & env, name const & n, expr const & type) {
+        auto d = env.find(n);
+        return d && d->is_definition() && d->get_module_idx() != g_main_module_idx && d->get_type() == type;
+    }
+
+    static bool has_nat_decls(environment const & env) {
+        return
+            inductive::is_intro_rule(env, get_nat_zero_name()) == optional<name>(get_nat_name()) &&
+            inductive::is_intro_rule(env, get_nat_succ_name()) == optional<name>(get_nat_name());
+    }
+
+    /** \brief Return true iff the declarations used to build the proofs for the decidable instances are available. */
+    static bool has_nat_lemmas(environment const & env) {
+        return
+            env.find(get_decidable_inl_name()) && env.find(get_decidable_inr_name()) &&
+            env.find(get_eq_refl_name()) && env.find(get_eq_symm_name()) && is_imported_definition(env, get_nat_le_name()) &&
+            env.find(get_nat_sub_le_name()) && env.find(get_nat_lt_irrefl_name()) &&
+            env.find(get_nat_lt_of_lt_of_eq_name()) && env.find(get_nat_lt_of_lt_of_le_name());
+    }
+
+    static optional<nat_op> get_op(environment const & env, expr const & fn) {
+        if (!is_constant(fn))
+            return optional<nat_op>();
+        optional<nat_op> op = get_op(const_name(fn));
+        if (!op || !has_nat_decls(env))
+            return optional<nat_op>();
+        switch (*op) {
+        case nat_op::Add: case nat_op::Mul: case nat_op::Sub: case nat_op::Div: case nat_op::Mod:
+            if (!is_imported_definition(env, const_name(fn), *g_nat_op_type))
+                return optional<nat_op>();
+            break;
+        case nat_op::DecEq: case nat_op::DecLe:
+            if (!is_imported_definition(env, const_name(fn)) || !has_nat_lemmas(env))
+                return optional<nat_op>();
+            break;
+        }
+        return op;
+    }
+
+    static optional<mpz> whnf_value(expr const & e, extension_context & ctx) {
+        if (auto v = to_nat_value(e))
+            return v;
+        auto r = ctx.whnf(e);
+        if (r.second)
+            return optional<mpz>(); // we do not produce constraints
+        return to_nat_value(r.first);
+    }
+
+    static level get_nat_level(environment const & env) {
+        expr const & type = env.get(get_nat_name()).get_type();
+        return is_sort(type) ? sort_level(type) : mk_level_one();
+    }
+
+    static expr mk_eq(level const & l, expr const & a, expr const & b) {
+        return mk_app(mk_constant(get_eq_name(), {l}), *g_nat, a, b);
+    }
+
+    /** \brief Return a proof of <tt>a < b</tt>, it is <tt>nat.sub_le (b-1) (b-1-a) : (b-1) - (b-1-a) <= b-1</tt> */
+    static expr mk_lt_proof(mpz const & a, mpz const & b) {
+        lean_assert(a < b);
+        mpz b1 = b - 1;
+        return mk_app(mk_constant(get_nat_sub_le_name()), mk_nat_value(b1), mk_nat_value(b1 - a));
+    }
+
+    /** \brief Return a proof of <tt>false</tt> using <tt>a < b</tt> and <tt>b = a</tt> (the hypothesis \c h). */
+    static expr mk_lt_irrefl(expr const & a, expr const & b, expr const & lt_pr, expr const & h) {
+        expr r = mk_app({mk_constant(get_nat_lt_of_lt_of_eq_name()), a, b, a, lt_pr, h});
+        return mk_app(mk_constant(get_nat_lt_irrefl_name()), a, r);
+    }
+
+    static expr mk_dec_eq(environment const & env, mpz const & v1, mpz const & v2) {
+        level l = get_nat_level(env);
+        expr a  = mk_nat_value(v1);
+        expr b  = mk_nat_value(v2);
+        expr p  = mk_eq(l, a, b);
+        if (v1 == v2)
+            return mk_app(mk_constant(get_decidable_inl_name()), p, mk_app(mk_constant(get_eq_refl_name(), {l}), *g_nat, a));
+        expr h = mk_var(0);
+        expr pr;
+        if (v2 < v1)
+            pr = mk_lt_irrefl(b, a, mk_lt_proof(v2, v1), h);
+        else
+            pr = mk_lt_irrefl(a, b, mk_lt_proof(v1, v2), mk_app({mk_constant(get_eq_symm_name(), {l}), *g_nat, a, b, h}));
+        return mk_app(mk_constant(get_decidable_inr_name()), p, mk_lambda("h", p, pr));
+    }
+
+    static expr mk_dec_le(mpz const & v1, mpz const & v2) {
+        expr a  = mk_nat_value(v1);
+        expr b  = mk_nat_value(v2);
+        expr p  = mk_app(mk_constant(get_nat_le_name()), a, b);
+        if (v1 <= v2)
+            return mk_app(mk_constant(get_decidable_inl_name()), p,
+                          mk_app(mk_constant(get_nat_sub_le_name()), b, mk_nat_value(v2 - v1)));
+        // b < a and a <= b imply b < b
+        expr h  = mk_var(0);
+        expr r  = mk_app({mk_constant(get_nat_lt_of_lt_of_le_name()), b, a, b, mk_lt_proof(v2, v1), h});
+        expr pr = mk_app(mk_constant(get_nat_lt_irrefl_name()), b, r);
+        return mk_app(mk_constant(get_decidable_inr_name()), p, mk_lambda("h", p, pr));
+    }
+
+public:
+    virtual optional<pair<expr, constraint_seq>> operator()(expr const & e, extension_context & ctx) const {
+        if (!is_app(e) || !is_app(app_fn(e)))
+            return none_ecs();
+        // terms containing metavariables are unfolded, \see default_converter::is_def_eq_core
+        if (has_expr_metavar(e))
+            return none_ecs();
+        expr const & fn = app_fn(app_fn(e));
+        environment const & env = ctx.env();
+        optional<nat_op> op = get_op(env, fn);
+        if (!op)
+            return none_ecs();
+        optional<mpz> v1 = whnf_value(app_arg(app_fn(e)), ctx);
+        if (!v1)
+            return none_ecs();
+        optional<mpz> v2 = whnf_value(app_arg(e), ctx);
+        if (!v2)
+            return none_ecs();
+        switch (*op) {
+        case nat_op::Add:   return some_ecs(mk_nat_value(*v1 + *v2), constraint_seq());
+        case nat_op::Mul:   return some_ecs(mk_nat_value(*v1 * *v2), constraint_seq());
+        case nat_op::Sub:   return some_ecs(mk_nat_value(*v1 >= *v2 ? *v1 - *v2 : mpz(0)), constraint_seq());
+        case nat_op::Div:   return some_ecs(mk_nat_value(v2->is_zero() ? mpz(0) : *v1 / *v2), constraint_seq());
+        case nat_op::Mod:   return some_ecs(mk_nat_value(v2->is_zero() ? *v1 : *v1 % *v2), constraint_seq());
+        case nat_op::DecEq: return some_ecs(mk_dec_eq(env, *v1, *v2), constraint_seq());
+        case nat_op::DecLe: return some_ecs(mk_dec_le(*v1, *v2), constraint_seq());
+        }
+        lean_unreachable(); // LCOV_EXCL_LINE
+    }
+    virtual optional<expr> may_reduce_later(expr const &, extension_context &) const { return none_expr(); }
+    virtual bool supports(name const &) const { return false; }
+    virtual optional<unsigned> get_major_idx(environment const & env, expr const & fn) const {
+        // all operations are binary, and both arguments must be literals
+        return get_op(env, fn) ? optional<unsigned>(1) : optional<unsigned>();
+    }
+    virtual bool is_builtin(environment const & env, expr const & fn) const { return static_cast<bool>(get_op(env, fn)); }
+};
+
+std::unique_ptr<normalizer_extension> mk_nat_normalizer_extension() {
+    return std::unique_ptr<normalizer_extension>(new nat_normalizer_extension());
+}
+
+void initialize_nat_value() {
+    g_nat_value_macro  = new name("nat_value_macro");
+    g_nat_value_opcode = new std::string("NatV");
+    g_nat              = new expr(Const(get_nat_name()));
+    g_nat_zero         = new expr(Const(get_nat_zero_name()));
+    g_nat_succ         = new expr(Const(get_nat_succ_name()));
+    g_nat_of_num       = new expr(Const(get_nat_of_num_name()));
+    g_nat_op_type      = new expr(*g_nat >> (*g_nat >> *g_nat));
+    register_macro_deserializer(*g_nat_value_opcode,
+                                [](deserializer & d, unsigned num, expr const *) {
+                                    if (num != 0)
+                                        throw corrupted_stream_exception();
+                                    mpz v;
+                                    d >> v;
+                                    return mk_nat_value(v);
+                                });
+}
+
+void finalize_nat_value() {
+    delete g_nat_op_type;
+    delete g_nat_of_num;
+    delete g_nat_succ;
+    delete g_nat_zero;
+    delete g_nat;
+    delete g_nat_value_opcode;
+    delete g_nat_value_macro;
+}
+}
@@ -0,0 +1,48 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include "util/numerics/mpz.h"
+#include "kernel/environment.h"
+#include "kernel/normalizer_extension.h"
+
+namespace lean {
+/** \brief Create a natural number literal with value \c v. It is a macro that stores the value
+    using arbitrary precision arithmetic, and expands into <tt>nat.succ m</tt> (or <tt>nat.zero</tt>), where
+    \c m is the literal for <tt>v - 1</tt>. Thus, the weak head normal form of a literal is an introduction rule.
+    \pre v >= 0 */
+expr mk_nat_value(mpz const & v);
+bool is_nat_value(expr const & e);
+mpz const & get_nat_value_value(expr const & e);
+
+/** \brief If \c e is a natural number literal, <tt>nat.zero</tt>, <tt>nat.succ n</tt> where \c n is a natural
+    number, or the numeral <tt>nat.of_num n</tt>, then return its value. */
+optional<mpz> to_nat_value(expr const & e);
+
+/** \brief Return the binary numeral <tt>nat.of_num n</tt> equivalent to the natural number literal \c e.
+    The size of the result is logarithmic in the value of \c e, while the fully expanded
+    <tt>nat.succ</tt> chain is linear.
+    \pre is_nat_value(e) */
+expr nat_value_to_numeral(expr const & e);
+
+/**
+   \brief Create a normalizer extension that reduces the following applications when the arguments are
+   natural number literals (after weak head normalization):
+       nat.add, nat.mul, nat.sub, nat.divide, nat.modulo, nat.has_decidable_eq and nat.decidable_le
+
+   The extension is part of the trusted code base, it assumes these definitions have their standard meaning.
+   Only the names and types of the definitions are checked, and they must have been imported from other modules:
+   definitions of the current module are type checked, but their bodies could be anything.
+   Thus, it must only be used in environments where the trust level is at least LEAN_BELIEVER_TRUST_LEVEL
+   (i.e., imported modules are trusted, \see mk_environment).
+   The arithmetic is performed using GMP, and the result is a natural number literal.
+*/
+std::unique_ptr<normalizer_extension> mk_nat_normalizer_extension();
+
+void initialize_nat_value();
+void finalize_nat_value();
+}
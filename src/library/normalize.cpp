@@ -43,6 +43,7 @@ struct unfold_c_hint_config {
         else
             s.erase(e.m_decl_name);
     }
+    static bool add_entry_reads_env() { return false; }
     static name const & get_class_name() {
         return *g_unfold_c_hint_name;
     }
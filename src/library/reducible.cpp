@@ -41,6 +41,7 @@ struct reducible_config {
     static void add_entry(environment const &, io_state const &, state & s, entry const & e) {
         s.add(e);
     }
+    static bool add_entry_reads_env() { return false; }
     static name const & get_class_name() {
          return *g_class_name;
     }
@@ -261,7 +261,7 @@ void initialize_scoped_ext() {
     g_exts = new scoped_exts();
     g_ext  = new scope_mng_ext_reg();
     g_new_namespace_key = new std::string("nspace");
-    register_module_object_reader(*g_new_namespace_key, namespace_reader);
+    register_module_object_reader(*g_new_namespace_key, namespace_reader, optional<unsigned>(g_ext->m_ext_id));
 }
 
 void finalize_scoped_ext() {
@@ -178,8 +178,11 @@ public:
         unsigned m_ext_id;
         reg() {
             register_scoped_ext(get_class_name(), using_namespace_fn, export_namespace_fn, push_fn, pop_fn);
-            register_module_object_reader(get_serialization_key(), reader);
             m_ext_id = environment::register_extension(std::make_shared<scoped_ext>());
+            // When importing modules, the delayed updates of different extensions are executed concurrently
+            // starting at the same environment. So, it is only safe if add_entry does not read the environment.
+            register_module_object_reader(get_serialization_key(), reader,
+                                          Config::add_entry_reads_env() ? optional<unsigned>() : optional<unsigned>(m_ext_id));
         }
     };
 
@@ -6,18 +6,26 @@ Author: Leonardo de Moura
 */
 #include "kernel/inductive/inductive.h"
 #include "library/inductive_unifier_plugin.h"
+#include "library/nat_value.h"
 
 namespace lean {
 using inductive::inductive_normalizer_extension;
 
-/** \brief Create standard Lean environment */
+/** \brief Create standard Lean environment.
+    The natural number extension (\see mk_nat_normalizer_extension) trusts the imported definitions of the
+    arithmetic operations by name, so it is only used when \c trust_lvl is at least LEAN_BELIEVER_TRUST_LEVEL.
+    Otherwise, the kernel reduces natural number literals by unfolding the definitions in the environment.
+    When \c trust_lvl is 0, literals are replaced with binary numerals before being sent to the kernel. */
 environment mk_environment(unsigned trust_lvl) {
+    std::unique_ptr<normalizer_extension> ext(new inductive_normalizer_extension());
+    if (trust_lvl >= LEAN_BELIEVER_TRUST_LEVEL)
+        ext = compose(std::move(ext), mk_nat_normalizer_extension());
     environment env = environment(trust_lvl,
                                   true /* Type.{0} is proof irrelevant */,
                                   true /* Eta */,
                                   true /* Type.{0} is impredicative */,
-                                  /* builtin support for inductive */
-                                  std::unique_ptr<normalizer_extension>(new inductive_normalizer_extension()));
+                                  /* builtin support for inductive and natural numbers */
+                                  std::move(ext));
     return set_unifier_plugin(env, mk_inductive_unifier_plugin());
 }
 }
@@ -13,6 +13,7 @@ Author: Leonardo de Moura
 #include "library/unfold_macros.h"
 #include "library/replace_visitor.h"
 #include "library/generic_exception.h"
+#include "library/nat_value.h"
 
 namespace lean {
 class unfold_untrusted_macros_fn {
@@ -34,7 +35,10 @@ class unfold_untrusted_macros_fn {
         auto def = macro_def(e);
         expr r = update_macro(e, new_args.size(), new_args.data());
         if (def.trust_level() >= m_trust_lvl) {
-            if (optional<expr> new_r = m_tc.expand_macro(r)) {
+            if (is_nat_value(r)) {
+                // the expansion of a literal contains a literal, use a numeral to avoid a linear chain of nat.succ
+                return nat_value_to_numeral(r);
+            } else if (optional<expr> new_r = m_tc.expand_macro(r)) {
                 return *new_r;
             } else {
                 throw_generic_exception("failed to expand macro", e);
@@ -14,6 +14,7 @@ Author: Leonardo de Moura
 #include "util/lazy_list_fn.h"
 #include "util/sstream.h"
 #include "util/lbool.h"
+#include "util/memory.h"
 #include "util/flet.h"
 #include "util/sexpr/option_declarations.h"
 #include "kernel/for_each_fn.h"
@@ -2324,12 +2325,16 @@ struct unifier_fn {
     }
 };
 
+static memory_category g_unifier_memory = 0;
+
 unify_result_seq unify(std::shared_ptr<unifier_fn> u) {
+    memory_scope scope(g_unifier_memory);
     if (!u->more_solutions()) {
         u->failure(); // make sure exception is thrown if u->m_use_exception is true
         return unify_result_seq();
     } else {
         return mk_lazy_list<pair<substitution, constraints>>([=]() {
+                memory_scope scope(g_unifier_memory);
                 auto s = u->next();
                 if (s)
                     return some(mk_pair(*s, unify(u)));
@@ -2341,11 +2346,13 @@ unify_result_seq unify(std::shared_ptr<unifier_fn> u) {
 
 unify_result_seq unify(environment const & env,  unsigned num_cs, constraint const * cs, name_generator const & ngen,
                        substitution const & s, unifier_config const & cfg) {
+    memory_scope scope(g_unifier_memory);
     return unify(std::make_shared<unifier_fn>(env, num_cs, cs, ngen, s, cfg));
 }
 
 unify_result_seq unify(environment const & env, expr const & lhs, expr const & rhs, name_generator const & ngen,
                        bool relax, substitution const & s, unifier_config const & cfg) {
+    memory_scope scope(g_unifier_memory);
     substitution new_s = s;
     expr _lhs = new_s.instantiate(lhs);
     expr _rhs = new_s.instantiate(rhs);
@@ -2515,6 +2522,7 @@ void open_unifier(lua_State * L) {
 }
 
 void initialize_unifier() {
+    g_unifier_memory            = register_memory_category("unifier");
     g_unifier_max_steps         = new name{"unifier", "max_steps"};
     g_unifier_computation       = new name{"unifier", "computation"};
     g_unifier_expensive_classes = new name{"unifier", "expensive_classes"};
@@ -8,8 +8,11 @@ Author: Leonardo de Moura
 #include <fstream>
 #include <signal.h>
 #include <cstdlib>
+#include <cstdio>
 #include <getopt.h>
 #include <string>
+#include <memory>
+#include <algorithm>
 #include "util/stackinfo.h"
 #include "util/macros.h"
 #include "util/debug.h"
@@ -20,11 +23,17 @@ Author: Leonardo de Moura
 #include "util/thread.h"
 #include "util/thread_script_state.h"
 #include "util/lean_path.h"
+#include "util/stats.h"
+#include "util/memory_pool.h"
+#include "util/region.h"
 #include "util/sexpr/options.h"
 #include "util/sexpr/option_declarations.h"
 #include "kernel/environment.h"
 #include "kernel/kernel_exception.h"
 #include "kernel/formatter.h"
+#include "kernel/closed_term_cache.h"
+#include "kernel/default_converter.h"
+#include "kernel/nbe_converter.h"
 #include "library/standard_kernel.h"
 #include "library/hott_kernel.h"
 #include "library/module.h"
@@ -95,6 +104,9 @@ static void display_help(std::ostream & out) {
     std::cout << "  --githash         display the git commit hash number used to build this binary\n";
     std::cout << "  --path            display the path used for finding Lean libraries and extensions\n";
     std::cout << "  --output=file -o  save the final environment in binary format in the given file\n";
+    std::cout << "  --compress        compress the file produced by --output\n";
+    std::cout << "  --profile-import=file display a per-module profile of the imported modules,\n";
+    std::cout << "                    and store it in JSON format in the given file\n";
     std::cout << "  --cpp=file -C     save the final environment as a C++ array\n";
     std::cout << "  --luahook=num -k  how often the Lua interpreter checks the interrupted flag,\n";
     std::cout << "                    it is useful for interrupting non-terminating user scripts,\n";
@@ -104,11 +116,28 @@ static void display_help(std::ostream & out) {
     std::cout << "  --discard -r      discard the proof of imported theorems after checking\n";
     std::cout << "  --to_axiom -X     discard proofs of all theorems after checking them, i.e.,\n";
     std::cout << "                    theorems become axioms after checking\n";
+    std::cout << "  --certs=dir       directory for storing certificates of type checked imported modules,\n";
+    std::cout << "                    modules with a valid certificate are not type checked again\n";
+    std::cout << "  --certs-mode=mode use (only use existing certificates), populate (default, use and store\n";
+    std::cout << "                    certificates) or ignore (do not use the certificate directory)\n";
+    std::cout << "  --tc-cache=num    number of entries of the cache shared by the kernel type checkers,\n";
+    std::cout << "                    it stores the results for closed terms, 0 means 'no shared cache' (default)\n";
+    std::cout << "  --closure-whnf    use closures (explicit substitutions) for beta reduction in the kernel\n";
+    std::cout << "  --nbe             use normalization by evaluation for checking definitional equality\n";
+    std::cout << "                    in the kernel (the default procedure is used when it fails)\n";
+    std::cout << "  --regions         allocate the terms created when elaborating a declaration in a region that\n";
+    std::cout << "                    is released at once when all of them have been deleted\n";
+    std::cout << "  --stats           display statistics about the kernel (e.g., cache hits, number of delta\n";
+    std::cout << "                    reductions per constant and number of allocated expressions) before exiting\n";
     std::cout << "  --quiet -q        do not print verbose messages\n";
 #if defined(LEAN_TRACK_MEMORY)
     std::cout << "  --memory=num -M   maximum amount of memory that should be used by Lean ";
     std::cout << "                    (in megabytes)\n";
 #endif
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES) && defined(LEAN_MULTI_THREAD)
+    std::cout << "  --memory-report=secs display the heap memory used by each subsystem (e.g., exprs, names,\n";
+    std::cout << "                    info_manager) every secs seconds\n";
+#endif
 #if defined(LEAN_MULTI_THREAD)
     std::cout << "  --server          start Lean in 'server' mode\n";
     std::cout << "  --threads=num -j  number of threads used to process lean files\n";
@@ -154,9 +183,21 @@ static struct option g_long_options[] = {
     {"output",       required_argument, 0, 'o'},
     {"cpp",          required_argument, 0, 'C'},
     {"memory",       required_argument, 0, 'M'},
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES) && defined(LEAN_MULTI_THREAD)
+    {"memory-report", required_argument, 0, 'K'},
+#endif
     {"trust",        required_argument, 0, 't'},
     {"discard",      no_argument,       0, 'r'},
     {"to_axiom",     no_argument,       0, 'X'},
+    {"certs",        required_argument, 0, 'e'},
+    {"compress",     no_argument,       0, 'Z'},
+    {"certs-mode",   required_argument, 0, 'E'},
+    {"profile-import", required_argument, 0, 'P'},
+    {"tc-cache",     required_argument, 0, 'T'},
+    {"closure-whnf", no_argument,       0, 'W'},
+    {"nbe",          no_argument,       0, 'N'},
+    {"stats",        no_argument,       0, 'A'},
+    {"regions",      no_argument,       0, 'Y'},
 #if defined(LEAN_MULTI_THREAD)
     {"server",       no_argument,       0, 'S'},
     {"threads",      required_argument, 0, 'j'},
@@ -251,6 +292,24 @@ static void export_as_cpp_file(std::string const & fname, char const * varname,
     out << "}\n";
 }
 
+/** \brief Save \c env as an .olean file.
+    We write to a temporary file and then rename it, because the existing file
+    may be memory mapped by other Lean processes importing it. */
+static void export_olean_file(std::string const & fname, environment const & env, bool compress) {
+    std::string tmp_fname = fname + ".tmp";
+    {
+        std::ofstream out(tmp_fname, std::ofstream::binary);
+        export_module(out, env, compress);
+        if (!out.good())
+            throw lean::exception(lean::sstream() << "failed to write file '" << tmp_fname << "'");
+    }
+#if defined(LEAN_WINDOWS)
+    std::remove(fname.c_str());
+#endif
+    if (std::rename(tmp_fname.c_str(), fname.c_str()) != 0)
+        throw lean::exception(lean::sstream() << "failed to rename '" << tmp_fname << "' to '" << fname << "'");
+}
+
 environment import_module(environment const & env, io_state const & ios, module_name const & mod, bool keep_proofs = true) {
     std::string base = ".";
     bool num_threads = 1;
@@ -337,13 +396,41 @@ int main() {
 }
 
 #else
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES) && defined(LEAN_MULTI_THREAD)
+/** \brief Auxiliary object for displaying the heap memory used by each subsystem periodically. */
+class memory_reporter {
+    std::unique_ptr<lean::interruptible_thread> m_thread;
+public:
+    void start(unsigned secs) {
+        m_thread.reset(new lean::interruptible_thread([=]() {
+                    try {
+                        while (true) {
+                            lean::sleep_for(secs * 1000);
+                            std::cerr << "-- memory report\n";
+                            lean::display_memory_category_stats(std::cerr);
+                        }
+                    } catch (lean::interrupted &) {
+                    }
+                }));
+    }
+    ~memory_reporter() {
+        if (m_thread) {
+            m_thread->request_interrupt();
+            m_thread->join();
+        }
+    }
+};
+#endif
+
 int main(int argc, char ** argv) {
     lean::initializer init;
     bool export_objects     = false;
+    bool compress_olean     = false;
     unsigned trust_lvl      = LEAN_BELIEVER_TRUST_LEVEL+1;
     bool server             = false;
     bool only_deps          = false;
     unsigned num_threads    = 1;
+    unsigned tc_cache_size  = 0;
     bool use_cache          = false;
     bool gen_index          = false;
     bool export_cpp         = false;
@@ -353,7 +440,13 @@ int main(int argc, char ** argv) {
     std::string cpp_output;
     std::string cache_name;
     std::string index_name;
+    std::string certs_dir;
+    std::string profile_import_name;
+    lean::import_cert_mode certs_mode = lean::import_cert_mode::Populate;
     optional<unsigned> line;
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES) && defined(LEAN_MULTI_THREAD)
+    memory_reporter mem_reporter;
+#endif
     optional<unsigned> column;
     bool show_goal = false;
     input_kind default_k = input_kind::Unspecified;
@@ -428,6 +521,47 @@ int main(int argc, char ** argv) {
         case 'X':
             tmode = keep_theorem_mode::DiscardAll;
             break;
+        case 'e':
+            certs_dir = optarg;
+            break;
+        case 'Z':
+            compress_olean = true;
+            break;
+        case 'P':
+            profile_import_name = optarg;
+            break;
+        case 'T':
+            tc_cache_size = atoi(optarg);
+            break;
+        case 'W':
+            lean::set_closure_whnf(true);
+            break;
+        case 'N':
+            lean::set_nbe_converter(true);
+            break;
+        case 'A':
+            lean::enable_stats(true);
+            break;
+        case 'Y':
+            lean::enable_regions(true);
+            break;
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES) && defined(LEAN_MULTI_THREAD)
+        case 'K':
+            mem_reporter.start(std::max(atoi(optarg), 1));
+            break;
+#endif
+        case 'E':
+            if (strcmp(optarg, "use") == 0) {
+                certs_mode = lean::import_cert_mode::Use;
+            } else if (strcmp(optarg, "populate") == 0) {
+                certs_mode = lean::import_cert_mode::Populate;
+            } else if (strcmp(optarg, "ignore") == 0) {
+                certs_mode = lean::import_cert_mode::Ignore;
+            } else {
+                std::cerr << "invalid --certs-mode argument, it must be use, populate or ignore" << std::endl;
+                return 1;
+            }
+            break;
         case 'q':
             opts = opts.update(lean::get_verbose_opt_name(), false);
             break;
@@ -499,7 +633,15 @@ int main(int argc, char ** argv) {
     if (has_hlean)
         lean::initialize_lean_path(true);
 
+    if (!certs_dir.empty())
+        lean::set_import_cert_store(certs_dir, certs_mode);
+
+    if (!profile_import_name.empty())
+        lean::set_import_profile(profile_import_name);
+
     environment env = has_hlean ? mk_hott_environment(trust_lvl) : mk_environment(trust_lvl);
+    if (tc_cache_size > 0)
+        env = lean::set_closed_term_cache(env, std::make_shared<lean::closed_term_cache>(env, tc_cache_size));
     io_state ios(opts, lean::mk_pretty_formatter_factory());
     script_state S = lean::get_thread_script_state();
     set_environment set1(S, env);
@@ -590,12 +732,18 @@ int main(int argc, char ** argv) {
             index.save(regular(env, ios));
         }
         if (export_objects && ok) {
-            std::ofstream out(output, std::ofstream::binary);
-            export_module(out, env);
+            export_olean_file(output, env, compress_olean);
         }
         if (export_cpp && ok) {
             export_as_cpp_file(cpp_output, "olean_lib", env);
         }
+        if (lean::stats_enabled()) {
+            lean::display_stats(std::cerr);
+            lean::display_memory_pool_stats(std::cerr);
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES)
+            lean::display_memory_category_stats(std::cerr);
+#endif
+        }
         return ok ? 0 : 1;
     } catch (lean::throwable & ex) {
         lean::display_error(diagnostic(env, ios), nullptr, ex);
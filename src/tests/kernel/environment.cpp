@@ -12,8 +12,12 @@ Author: Leonardo de Moura
 #include "util/sexpr/init_module.h"
 #include "kernel/environment.h"
 #include "kernel/type_checker.h"
+#include "kernel/default_converter.h"
+#include "kernel/nbe_converter.h"
+#include "kernel/closed_term_cache.h"
 #include "kernel/abstract.h"
 #include "kernel/kernel_exception.h"
+#include "kernel/kernel_stats.h"
 #include "kernel/init_module.h"
 #include "library/init_module.h"
 #include "library/print.h"
@@ -136,6 +140,12 @@ public:
     }
     virtual optional<expr> may_reduce_later(expr const &, extension_context &) const { return none_expr(); }
     virtual bool supports(name const &) const { return false; }
+    virtual optional<unsigned> get_major_idx(environment const &, expr const & fn) const {
+        if (is_constant(fn) && const_name(fn) == name("proj1"))
+            return optional<unsigned>(0);
+        else
+            return optional<unsigned>();
+    }
 };
 
 static void tst3() {
@@ -174,6 +184,235 @@ static void tst4() {
 }
 
 namespace lean {
+class counting_decoder : public declaration_decoder {
+public:
+    mutable unsigned m_num_decoded;
+    counting_decoder():m_num_decoded(0) {}
+    virtual expr decode_type(unsigned idx) const {
+        m_num_decoded++;
+        return idx == 0 ? mk_Prop() : mk_constant("A");
+    }
+    virtual expr decode_value(unsigned) const {
+        m_num_decoded++;
+        return mk_constant("a");
+    }
+};
+
+static void tst5() {
+    auto dec = std::make_shared<counting_decoder>();
+    declaration A = mk_lazy_constant_assumption("A", level_param_names(), dec, 0);
+    declaration a = mk_lazy_axiom("a", level_param_names(), dec, 1);
+    declaration b = mk_lazy_definition("b", level_param_names(), false, 1, 0, true, dec, 1);
+    declaration t = mk_lazy_theorem("t", level_param_names(), 0, dec, 1);
+    lean_assert(A.is_constant_assumption() && a.is_axiom() && b.is_definition() && t.is_theorem());
+    lean_assert(!b.is_opaque() && b.get_weight() == 1 && b.use_conv_opt());
+    lean_assert(dec->m_num_decoded == 0);
+    lean_assert(A.get_type() == mk_Prop());
+    lean_assert(A.get_type() == mk_Prop());
+    lean_assert(dec->m_num_decoded == 1);
+    lean_assert(b.get_value() == mk_constant("a"));
+    lean_assert(dec->m_num_decoded == 2);
+    lean_assert(b.get_type() == mk_constant("A"));
+    lean_assert(is_eqp(b.get_type(), b.get_type()));
+    lean_assert(dec->m_num_decoded == 3);
+    environment env;
+    env = env.add(check(env, A));
+    env = env.add(check(env, a));
+    env = env.add(check(env, t));
+    lean_assert(env.get("t").get_value() == mk_constant("a"));
+}
+
+static void tst6() {
+    // type checkers share the results for closed terms
+    environment env1;
+    auto cache = std::make_shared<closed_term_cache>(env1, 1u << 16);
+    env1 = set_closed_term_cache(env1, cache);
+    expr Type = mk_Type();
+    expr Prop = mk_Prop();
+    expr A = Local("A", Type);
+    expr x = Local("x", A);
+    auto env2 = add_decl(env1, mk_definition("id", level_param_names(), Pi(A, A >> A), Fun({A, x}, x)));
+    env2 = add_decl(env2, mk_axiom("p", level_param_names(), Prop));
+    lean_assert(get_closed_term_cache(env2) == cache);
+    expr id   = Const("id");
+    expr t    = mk_app(id, Prop, mk_app(id, Prop, Const("p")));
+    auto env3 = add_decl(env2, mk_definition("t1", level_param_names(), Prop, t));
+    auto hits = cache->get_stats(closed_term_cache::kind::Check).m_hits;
+    auto env4 = add_decl(env3, mk_definition("t2", level_param_names(), Prop, t));
+    lean_assert(cache->get_stats(closed_term_cache::kind::Check).m_hits > hits);
+    lean_assert(cache->find(closed_term_cache::kind::Check, env4, t));
+    // env5 is not a descendant of the environment used to check t
+    auto env5 = add_decl(env1, mk_definition("id", level_param_names(), Pi(A, A >> A), Fun({A, x}, x)));
+    env5 = add_decl(env5, mk_axiom("p", level_param_names(), Prop));
+    lean_assert(!cache->find(closed_term_cache::kind::Check, env5, t));
+    type_checker checker(env5, name_generator("tmp"), std::unique_ptr<converter>(new default_converter(env5, optional<module_idx>())),
+                         true, cache);
+    lean_assert(checker.check(t).first == Prop);
+    lean_assert(cache->find(closed_term_cache::kind::Check, env5, t));
+    cache->display_stats(std::cout);
+}
+
+static void tst7() {
+    // normalization by evaluation agrees with the default converter
+    // proof irrelevance is disabled because it would infer the type of proj1, which is not declared
+    environment env(0, false, true, true, std::unique_ptr<normalizer_extension>(new normalizer_extension_tst()));
+    expr Type = mk_Type();
+    expr A = Local("A", Type);
+    expr x = Local("x", A);
+    expr f = Local("f", A >> A);
+    env = add_decl(env, mk_definition("id", level_param_names(), Pi(A, A >> A), Fun({A, x}, x)));
+    expr id    = Const("id");
+    expr mk    = Const("mk");
+    expr proj1 = Const("proj1");
+    expr a     = Const("a");
+    expr b     = Const("b");
+    type_checker checker1(env, name_generator("tmp"), std::unique_ptr<converter>(new nbe_converter(env, optional<module_idx>())));
+    type_checker checker2(env, name_generator("tmp"), std::unique_ptr<converter>(new default_converter(env, optional<module_idx>())));
+    bool old_stats = stats_enabled();
+    enable_stats(true);
+    reset_stats();
+    buffer<pair<expr, expr>> tests;
+    expr t = mk_app(proj1, mk_app(proj1, mk_app(mk, mk_app(id, A, mk_app(mk, a, b)), b)));
+    tests.emplace_back(t, a);
+    tests.emplace_back(t, b);
+    tests.emplace_back(Fun(x, mk_app(f, x)), f);
+    tests.emplace_back(Fun(x, mk_app(id, A, mk_app(f, x))), mk_app(id, A >> A, f));
+    tests.emplace_back(mk_app(id, A, mk_app(f, x)), mk_app(f, mk_app(id, A, x)));
+    tests.emplace_back(mk_app(id, A, mk_app(f, x)), mk_app(f, mk_app(f, x)));
+    for (auto const & p : tests) {
+        bool r = checker1.is_def_eq(p.first, p.second).first;
+        lean_assert_eq(r, checker2.is_def_eq(p.first, p.second).first);
+        std::cout << p.first << " == " << p.second << " : " << r << "\n";
+    }
+    // t == a is decided by the evaluator, the failure on t == b is only tried once
+    stats_snapshot s1 = get_stats();
+    lean_assert(checker1.is_def_eq(t, a).first);
+    stats_snapshot s2 = get_stats();
+    lean_assert_eq(s2.get(g_nbe_success_stat), s1.get(g_nbe_success_stat) + 1);
+    lean_assert(!checker1.is_def_eq(t, b).first);
+    stats_snapshot s3 = get_stats();
+    lean_assert_eq(s3.get(g_nbe_stat), s2.get(g_nbe_stat));
+    lean_assert_eq(s3.get(g_nbe_failure_cache_hit_stat), s2.get(g_nbe_failure_cache_hit_stat) + 1);
+    lean_assert(s3.get(g_nbe_success_stat) > 0);
+    std::cout << "nbe: " << s3.get(g_nbe_stat) << ", successes: " << s3.get(g_nbe_success_stat)
+              << ", failure cache hits: " << s3.get(g_nbe_failure_cache_hit_stat) << "\n";
+    enable_stats(old_stats);
+}
+
+static void tst8() {
+    // the closure based whnf_core produces the same results as the eager one
+    environment env(0, true, true, true, std::unique_ptr<normalizer_extension>(new normalizer_extension_tst()));
+    name base("base");
+    expr Type = mk_Type();
+    expr Prop = mk_Prop();
+    env = add_decl(env, mk_constant_assumption(name(base, 0u), level_param_names(), Prop >> (Prop >> Prop)));
+    expr p = Local("p", Prop);
+    expr q = Local("q", Prop);
+    for (unsigned i = 1; i <= 10; i++) {
+        expr prev = Const(name(base, i-1));
+        env = add_decl(env, mk_definition(env, name(base, i), level_param_names(), Prop >> (Prop >> Prop),
+                                          Fun({p, q}, mk_app(prev, mk_app(prev, p, q), mk_app(prev, q, p)))));
+    }
+    expr A = Local("A", Type);
+    expr x = Local("x", A);
+    expr y = Local("y", A);
+    expr f = Local("f", A >> (A >> A));
+    env = add_decl(env, mk_definition("id", level_param_names(), Pi(A, A >> A), Fun({A, x}, x)));
+    expr id    = Const("id");
+    expr mk    = Const("mk");
+    expr proj1 = Const("proj1");
+    expr a     = Const("a");
+    expr b     = Const("b");
+    expr c1    = mk_local("c1", Prop);
+    expr c2    = mk_local("c2", Prop);
+    expr flip  = Fun({x, y}, mk_app(f, y, x));
+    expr k     = Fun({x, y}, x);
+    buffer<expr> tests;
+    tests.push_back(mk_app(id, Prop, c1));
+    tests.push_back(mk_app(id, Prop, mk_app(id, Prop, mk_app(id, Prop, c1))));
+    tests.push_back(mk_app(Const(name(base, 3)), c1, c2));
+    tests.push_back(mk_app(Const(name(base, 10)), c1, mk_app(id, Prop, c2)));
+    tests.push_back(mk_app(proj1, mk_app(proj1, mk_app(mk, mk_app(id, A, mk_app(mk, a, b)), b))));
+    tests.push_back(mk_app(flip, a, b));
+    tests.push_back(mk_app(flip, a));
+    tests.push_back(mk_app(k, mk_app(flip, a, b)));
+    tests.push_back(mk_app(k, mk_app(k, a), b, mk_app(flip, b, a)));
+    tests.push_back(mk_app(Fun(x, mk_app(x, a, x)), k));
+    tests.push_back(mk_app(Fun(x, Fun(y, mk_app(f, x, y))), mk_app(id, A, a)));
+    tests.push_back(mk_app(mk_lambda("x", A, mk_lambda("y", A, mk_app(mk_var(1), mk_var(2)))), k, a, b));
+    tests.push_back(mk_app(mk_lambda("x", A, mk_var(1)), a));
+    tests.push_back(mk_app(mk_lambda("x", A, mk_var(0)), mk_var(3), b));
+    bool old = get_closure_whnf();
+    set_closure_whnf(false);
+    type_checker checker1(env, name_generator("tmp"));
+    set_closure_whnf(true);
+    type_checker checker2(env, name_generator("tmp"));
+    set_closure_whnf(old);
+    for (expr const & t : tests) {
+        expr r1 = checker1.whnf(t).first;
+        expr r2 = checker2.whnf(t).first;
+        std::cout << t << " --> " << r1 << "\n";
+        lean_assert_eq(r1, r2);
+    }
+    for (expr const & t1 : tests) {
+        for (expr const & t2 : tests) {
+            if (!closed(t1) || !closed(t2))
+                continue;
+            // some of the terms are not type correct, then both engines must fail
+            optional<bool> r1, r2;
+            try { r1 = checker1.is_def_eq(t1, t2).first; } catch (exception &) {}
+            try { r2 = checker2.is_def_eq(t1, t2).first; } catch (exception &) {}
+            lean_assert(r1 == r2);
+        }
+    }
+}
+
+static void tst9() {
+    // failed is_def_eq checks are only cached for closed terms without metavariables
+    environment env;
+    name base("base");
+    expr Prop = mk_Prop();
+    env = add_decl(env, mk_constant_assumption(name(base, 0u), level_param_names(), Prop >> (Prop >> Prop)));
+    expr p = Local("p", Prop);
+    expr q = Local("q", Prop);
+    for (unsigned i = 1; i <= 4; i++) {
+        expr prev = Const(name(base, i-1));
+        env = add_decl(env, mk_definition(env, name(base, i), level_param_names(), Prop >> (Prop >> Prop),
+                                          Fun({p, q}, mk_app(prev, mk_app(prev, p, q), mk_app(prev, q, p)))));
+    }
+    expr c1 = mk_local("c1", Prop);
+    expr c2 = mk_local("c2", Prop);
+    expr m  = mk_metavar("m", Prop);
+    expr f  = Const(name(base, 4));
+    expr t1 = mk_app(f, c1, c2);
+    expr s1 = mk_app(f, c2, c1);
+    expr t2 = mk_app(f, c1, m);
+    bool old_stats = stats_enabled();
+    enable_stats(true);
+    reset_stats();
+    auto hits = []() { return get_stats().get(g_is_def_eq_failure_cache_hit_stat); };
+    type_checker checker(env, name_generator("tmp"));
+    lean_assert(!checker.is_def_eq(t1, s1).first);
+    uint64 h1 = hits();
+    // the second check is answered by the failure cache
+    lean_assert(!checker.is_def_eq(t1, s1).first);
+    uint64 h2 = hits();
+    lean_assert_eq(h2, h1 + 1);
+    // terms containing metavariables are not cached, the result depends on their assignment
+    checker.is_def_eq(t2, s1);
+    checker.is_def_eq(t2, s1);
+    uint64 h3 = hits();
+    lean_assert_eq(h3, h2);
+    // the cache belongs to the converter, a type checker for a different environment starts empty
+    environment env2 = add_decl(env, mk_constant_assumption("c", level_param_names(), Prop));
+    type_checker checker2(env2, name_generator("tmp"));
+    lean_assert(!checker2.is_def_eq(t1, s1).first);
+    uint64 h4 = hits();
+    lean_assert_eq(h4 - h3, h1);
+    std::cout << "failure cache hits: " << h1 << " " << h2 << " " << h3 << " " << h4 << "\n";
+    enable_stats(old_stats);
+}
+
 class environment_id_tester {
 public:
     static void tst1() {
@@ -259,6 +498,11 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
+    tst6();
+    tst7();
+    tst8();
+    tst9();
     environment_id_tester::tst1();
     environment_id_tester::tst2();
     finalize_library_module();
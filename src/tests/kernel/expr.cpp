@@ -9,11 +9,14 @@ Author: Leonardo de Moura
 #include <utility>
 #include <vector>
 #include <limits>
+#include <string>
+#include <unordered_map>
 #include "util/test.h"
 #include "util/init_module.h"
 #include "util/sexpr/init_module.h"
 #include "kernel/expr.h"
 #include "kernel/expr_sets.h"
+#include "kernel/expr_cache.h"
 #include "kernel/free_vars.h"
 #include "kernel/abstract.h"
 #include "kernel/instantiate.h"
@@ -374,6 +377,60 @@ static void tst18() {
     lean_assert(!has_local(mk_app(f, a0, a0, a0, a0)));
 }
 
+static void tst20() {
+    expr f  = Const("f");
+    expr r1 = mk_big(f, 12, 0);
+    expr r2 = deep_copy(r1);
+    lean_assert(!is_eqp(r1, r2));
+    lean_assert(r1.hash64() == r2.hash64());
+    lean_assert(static_cast<unsigned>(r1.hash64()) == r1.hash());
+    lean_assert(mk_big(f, 12, 1).hash64() != r1.hash64());
+    lean_assert(mk_app(f, Var(0)).hash64() != mk_app(f, Var(1)).hash64());
+    lean_assert(mk_Prop().hash64() != mk_Type().hash64());
+    // expr_cache with a single set
+    expr_cache c(LEAN_CACHE_WAYS);
+    for (unsigned i = 0; i < LEAN_CACHE_WAYS; i++)
+        c.insert(Var(i), Const(name("c", i)));
+    for (unsigned i = 0; i < LEAN_CACHE_WAYS; i++)
+        lean_assert(*c.find(Var(i)) == Const(name("c", i)));
+    lean_assert(c.hits() == LEAN_CACHE_WAYS);
+    // Var(0) is the least recently used entry
+    c.insert(r1, f);
+    lean_assert(c.evictions() == 1);
+    lean_assert(!c.find(Var(0)));
+    lean_assert(*c.find(r2) == f);
+    c.clear();
+    lean_assert(!c.find(r1));
+}
+
+static void tst21() {
+    // atoms whose names have the same 32-bit hash code must have different 64-bit hash codes
+    std::unordered_map<unsigned, std::string> hashes;
+    for (unsigned i = 0; i < (1u << 20); i++) {
+        std::string s = "x" + std::to_string(i);
+        name n(s.c_str());
+        auto it = hashes.find(n.hash());
+        if (it == hashes.end()) {
+            hashes.insert(mk_pair(n.hash(), s));
+            continue;
+        }
+        name n1(it->second.c_str());
+        expr c1 = mk_constant(n1);
+        expr c2 = mk_constant(n);
+        lean_assert(c1.hash() == c2.hash());
+        lean_assert(c1.hash64() != c2.hash64());
+        expr l1 = mk_local(n1, mk_Prop());
+        expr l2 = mk_local(n, mk_Prop());
+        lean_assert(l1.hash64() != l2.hash64());
+        expr s1 = mk_sort(mk_param_univ(n1));
+        expr s2 = mk_sort(mk_param_univ(n));
+        lean_assert(s1.hash64() != s2.hash64());
+        std::cout << n1 << " and " << n << " have the same 32-bit hash code\n";
+        return;
+    }
+    lean_unreachable();
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -400,6 +457,8 @@ int main() {
     tst16();
     tst17();
     tst18();
+    tst20();
+    tst21();
     std::cout << "sizeof(expr):            " << sizeof(expr) << "\n";
     std::cout << "sizeof(expr_cell):       " << sizeof(expr_cell) << "\n";
     std::cout << "sizeof(expr_app):        " << sizeof(expr_app) << "\n";
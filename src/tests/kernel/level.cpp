@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include "util/sexpr/init_module.h"
 #include "kernel/init_module.h"
 #include "kernel/level.h"
+#include "kernel/expr.h"
 #include "library/kernel_serializer.h"
 #include "library/init_module.h"
 using namespace lean;
@@ -65,6 +66,20 @@ static void tst2() {
     lean_assert(!is_equivalent(zero, p2));
 }
 
+static void tst3() {
+    // the 64-bit hash code is cached, it must not traverse the (exponential) tree of a shared DAG
+    level a = mk_param_univ("u");
+    level b = mk_param_univ("v");
+    for (unsigned i = 0; i < 64; i++) {
+        level new_a = mk_max(a, b);
+        level new_b = mk_max(b, a);
+        a = new_a;
+        b = new_b;
+    }
+    lean_assert(a.hash64() != b.hash64());
+    lean_assert(mk_sort(a).hash64() != mk_sort(b).hash64());
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -73,6 +88,7 @@ int main() {
     initialize_library_module();
     tst1();
     tst2();
+    tst3();
     finalize_library_module();
     finalize_kernel_module();
     finalize_sexpr_module();
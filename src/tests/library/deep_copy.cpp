@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "util/test.h"
+#include "util/region.h"
 #include "util/init_module.h"
 #include "util/sexpr/init_module.h"
 #include "kernel/for_each_fn.h"
@@ -28,6 +29,47 @@ static void tst1() {
     lean_assert(!is_eqp(F, G));
 }
 
+static bool has_region_cell(expr const & e) {
+    bool r = false;
+    for_each(e, [&](expr const & e, unsigned) {
+            if (e.raw()->in_region())
+                r = true;
+            return !r;
+        });
+    return r;
+}
+
+static void tst2() {
+    enable_regions(true);
+    expr f = Const("f");
+    expr Type = mk_Type();
+    expr G, H, K;
+    {
+        region_scope scope;
+        expr a = Const("a");
+        expr x = Var(0);
+        expr F = mk_pi("y", Type, mk_lambda("x", Type, mk_app(f, mk_app(f, mk_app(f, x, a), Const("10")), mk_app(f, x, a))));
+        lean_assert(F.raw()->in_region());
+        lean_assert(!f.raw()->in_region());
+        G = copy_out_of_region(F);
+        lean_assert(F == G);
+        lean_assert(!has_region_cell(G));
+        // terms that were not copied keep the region alive
+        H = mk_app(F, f);
+        {
+            no_region_scope scope2;
+            K = mk_app(f, f);
+        }
+        lean_assert(!K.raw()->in_region());
+    }
+    lean_assert(H.raw()->in_region());
+    lean_assert(app_arg(H) == f);
+    lean_assert(app_fn(H) == G);
+    H = expr();
+    enable_regions(false);
+    lean_assert(is_eqp(copy_out_of_region(G), G));
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -35,6 +77,7 @@ int main() {
     initialize_kernel_module();
     initialize_library_module();
     tst1();
+    tst2();
     finalize_library_module();
     finalize_kernel_module();
     finalize_sexpr_module();
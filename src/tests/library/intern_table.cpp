@@ -0,0 +1,111 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <sstream>
+#include <string>
+#include "util/test.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/init_module.h"
+#include "library/init_module.h"
+#include "library/intern_table.h"
+#include "library/kernel_serializer.h"
+using namespace lean;
+
+static void tst1() {
+    scoped_expr_caching disable(false);
+    intern_table t;
+    expr f  = Const("f");
+    expr a1 = mk_app(f, Const("a"));
+    expr a2 = mk_app(f, Const("a"));
+    lean_assert(!is_eqp(a1, a2));
+    lean_assert(is_eqp(t.intern(a1), a1));
+    lean_assert(is_eqp(t.intern(a2), a1));
+    lean_assert(!is_eqp(t.intern(mk_app(f, Const("b"))), a1));
+    lean_assert(t.get_num_exprs() == 2);
+    level l1 = mk_succ(mk_param_univ("l"));
+    level l2 = mk_succ(mk_param_univ("l"));
+    lean_assert(is_eqp(t.intern(l1), l1));
+    lean_assert(is_eqp(t.intern(l2), l1));
+    lean_assert(t.get_num_levels() == 1);
+}
+
+static expr read_expr(std::string const & s) {
+    std::istringstream in(s, std::ios_base::binary);
+    deserializer d(in);
+    expr r;
+    d >> r;
+    return r;
+}
+
+static void tst2() {
+    scoped_expr_caching disable(false);
+    expr l = mk_Type();
+    expr e = mk_app(Const("f"), mk_app(Const("g"), Const("a")), Const("b"), l);
+    std::ostringstream out(std::ios_base::binary);
+    serializer s(out);
+    s << e;
+    std::string data = out.str();
+    expr e1 = read_expr(data);
+    expr e2 = read_expr(data);
+    lean_assert(e1 == e && e2 == e);
+    lean_assert(!is_eqp(e1, e2));
+    intern_table t;
+    scoped_intern_table scope(&t);
+    expr e3 = read_expr(data);
+    expr e4 = read_expr(data);
+    lean_assert(e3 == e);
+    lean_assert(is_eqp(e3, e4));
+    lean_assert(is_eqp(app_arg(e3), app_arg(e4)));
+}
+
+static void tst3() {
+    scoped_expr_caching disable(false);
+    expr e = mk_app(Const("f"), mk_app(Const("g"), Const("a")));
+    std::ostringstream out(std::ios_base::binary);
+    serializer s(out);
+    s << e;
+    std::string data = out.str();
+    // Declarations decoded lazily only keep a weak reference to the table used to import them.
+    intern_table_ptr t = std::make_shared<intern_table>();
+    std::weak_ptr<intern_table> w = t;
+    expr e1;
+    {
+        intern_table_ptr t1 = w.lock();
+        scoped_intern_table scope(t1.get());
+        e1 = read_expr(data);
+    }
+    lean_assert(t->get_num_exprs() > 0);
+    lean_assert(get_rc(e1.raw()) > 1);
+    // Interned terms are freed when the table is deleted and they are not referenced anymore.
+    t.reset();
+    lean_assert(w.expired());
+    lean_assert(get_rc(e1.raw()) == 1);
+    lean_assert(get_rc(app_arg(e1).raw()) == 1);
+    {
+        intern_table_ptr t1 = w.lock();
+        scoped_intern_table scope(t1.get());
+        lean_assert(!get_intern_table());
+        expr e2 = read_expr(data);
+        lean_assert(e2 == e1 && !is_eqp(e2, e1));
+    }
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_library_module();
+    tst1();
+    tst2();
+    tst3();
+    finalize_library_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <random>
+#include <vector>
+#include "util/test.h"
+#include "util/thread.h"
+#include "util/rc.h"
+#include "util/name.h"
+#include "util/init_module.h"
+using namespace lean;
+
+#if defined(LEAN_MULTI_THREAD)
+static void tst1() {
+    // names created by one thread and deleted by another one
+    for (unsigned it = 0; it < 10; it++) {
+        std::vector<name> ns;
+        thread t([&]() {
+                name p("foo");
+                for (unsigned i = 0; i < 1000; i++)
+                    ns.push_back(name(name(p, i), "bar"));
+                run_thread_finalizers();
+                run_post_thread_finalizers();
+            });
+        t.join();
+        for (unsigned i = 0; i < ns.size(); i++)
+            lean_assert(ns[i] == name(name(name("foo"), i), "bar"));
+        std::vector<name> copies(ns);
+        ns.clear();
+        thread t2([&]() {
+                copies.clear();
+                run_thread_finalizers();
+                run_post_thread_finalizers();
+            });
+        t2.join();
+    }
+}
+#else
+static void tst1() {}
+#endif
+
+#if defined(LEAN_BIASED_RC)
+static atomic<int> g_num_nodes(0);
+
+class node {
+    MK_LEAN_BIASED_RC(node)
+private:
+    node * m_next;
+    void dealloc() {
+        node * n = m_next;
+        delete this;
+        g_num_nodes--;
+        if (n)
+            n->dec_ref();
+    }
+public:
+    explicit node(node * n):m_rc(0), m_next(n) { g_num_nodes++; if (n) n->inc_ref(); }
+};
+
+class node_ref {
+    node * m_ptr;
+public:
+    node_ref():m_ptr(nullptr) {}
+    explicit node_ref(node * n):m_ptr(n) { if (m_ptr) m_ptr->inc_ref(); }
+    node_ref(node_ref const & s):m_ptr(s.m_ptr) { if (m_ptr) m_ptr->inc_ref(); }
+    ~node_ref() { if (m_ptr) m_ptr->dec_ref(); }
+    node_ref & operator=(node_ref const & s) { LEAN_COPY_REF(s); }
+    node * raw() const { return m_ptr; }
+};
+
+static void worker(unsigned seed, mutex & mtx, std::vector<node_ref> & shared) {
+    std::mt19937 rng(seed);
+    std::vector<node_ref> local;
+    for (unsigned i = 0; i < 100000; i++) {
+        unsigned op = rng() % 6;
+        if (op == 0 || local.empty()) {
+            local.push_back(node_ref(new node(local.empty() ? nullptr : local[rng() % local.size()].raw())));
+        } else if (op == 1) {
+            lock_guard<mutex> lock(mtx);
+            shared.push_back(local[rng() % local.size()]);
+        } else if (op == 2) {
+            lock_guard<mutex> lock(mtx);
+            if (!shared.empty()) {
+                unsigned j = rng() % shared.size();
+                local.push_back(shared[j]);
+                shared[j] = shared.back();
+                shared.pop_back();
+            }
+        } else if (op == 3) {
+            unsigned j = rng() % local.size();
+            local[j] = local.back();
+            local.pop_back();
+        } else if (op == 4) {
+            local.push_back(local[rng() % local.size()]);
+        } else {
+            process_rc_merge_queue();
+        }
+        if (local.size() > 1000)
+            local.clear();
+    }
+    local.clear();
+    run_thread_finalizers();
+    run_post_thread_finalizers();
+}
+
+static void tst2() {
+    // references created by one thread are deleted by other threads, all nodes must be deleted
+    mutex mtx;
+    std::vector<node_ref> shared;
+    for (unsigned it = 0; it < 10; it++) {
+        std::vector<thread> ts;
+        for (unsigned i = 0; i < 4; i++)
+            ts.push_back(thread([&, i]() { worker(4*it + i, mtx, shared); }));
+        for (thread & t : ts)
+            t.join();
+        shared.clear();
+        process_rc_merge_queue();
+        lean_assert(g_num_nodes == 0);
+    }
+}
+#else
+static void tst2() {}
+#endif
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    tst1();
+    tst2();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
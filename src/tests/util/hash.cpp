@@ -5,6 +5,8 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include "util/test.h"
 #include "util/hash.h"
 using namespace lean;
@@ -17,7 +19,29 @@ static void tst1() {
     lean_assert(h1 != h3);
 }
 
+static void tst2() {
+    // XXH64 reference values
+    lean_assert(hash64("", 0) == 0xEF46DB3751D8E999ull);
+    lean_assert(hash64("a", 1) == 0xD24EC4F1A98C6E5Bull);
+    lean_assert(hash64("abc", 3) == 0x44BC2CF5AD770999ull);
+    std::vector<char> data;
+    for (unsigned i = 0; i < 1000; i++)
+        data.push_back(static_cast<char>(i * 7 + i / 13));
+    uint64 h = hash64(data.data(), data.size());
+    // result does not depend on how data is split
+    for (unsigned step : {1u, 3u, 8u, 31u, 32u, 33u, 100u}) {
+        hash64_stream s;
+        for (unsigned i = 0; i < data.size(); i += step)
+            s.update(data.data() + i, std::min<size_t>(step, data.size() - i));
+        lean_assert(s.digest() == h);
+    }
+    lean_assert(hash64(data.data(), data.size(), 1) != h);
+    data[500]++;
+    lean_assert(hash64(data.data(), data.size()) != h);
+}
+
 int main() {
     tst1();
+    tst2();
     return has_violations() ? 1 : 0;
 }
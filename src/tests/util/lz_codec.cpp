@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <vector>
+#include <string>
+#include "util/test.h"
+#include "util/exception.h"
+#include "util/lz_codec.h"
+using namespace lean;
+
+static void check_roundtrip(std::vector<char> const & data) {
+    std::vector<char> c;
+    lz_compress(data.data(), data.size(), c);
+    std::vector<char> r(data.size());
+    lz_decompress(c.data(), c.size(), r.data(), r.size());
+    lean_assert(r == data);
+}
+
+static std::vector<char> mk_data(unsigned n, unsigned period) {
+    std::vector<char> r;
+    unsigned seed = 17;
+    for (unsigned i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        r.push_back(static_cast<char>(period == 0 ? (seed >> 16) : (i % period) * 31));
+    }
+    return r;
+}
+
+static void tst1() {
+    for (unsigned n : {0u, 1u, 5u, 12u, 13u, 100u, 1000u, 70000u, 300000u}) {
+        check_roundtrip(mk_data(n, 0));
+        check_roundtrip(mk_data(n, 1));
+        check_roundtrip(mk_data(n, 7));
+        check_roundtrip(mk_data(n, 1000));
+    }
+    std::string s;
+    for (unsigned i = 0; i < 1000; i++)
+        s += "theorem foo : bar = baz := rfl\n";
+    std::vector<char> data(s.begin(), s.end());
+    std::vector<char> c;
+    lz_compress(data.data(), data.size(), c);
+    lean_assert(c.size() < data.size() / 10);
+    check_roundtrip(data);
+}
+
+static void tst2() {
+    std::vector<char> data = mk_data(100000, 333);
+    std::vector<char> c;
+    lz_compress_blocks(data.data(), data.size(), c, 4096);
+    std::vector<lz_block> blocks;
+    unsigned sz = lz_read_blocks(c.data(), c.size(), blocks);
+    lean_assert(sz == data.size());
+    lean_assert(blocks.size() == 25);
+    std::vector<char> r(sz);
+    // blocks can be decompressed in any order
+    for (unsigned i = blocks.size(); i > 0; i--) {
+        lean_verify(lz_decompress_block(blocks[i-1], r.data()));
+    }
+    lean_assert(r == data);
+    // corrupted block
+    c[c.size() - 10]++;
+    lz_read_blocks(c.data(), c.size(), blocks);
+    lean_assert(!lz_decompress_block(blocks.back(), r.data()));
+    // truncated stream
+    try {
+        lz_read_blocks(c.data(), c.size() - 1, blocks);
+        lean_unreachable();
+    } catch (exception &) {}
+    // invalid data
+    std::vector<char> junk = mk_data(100, 0);
+    try {
+        lz_decompress(junk.data(), junk.size(), r.data(), r.size());
+        lean_unreachable();
+    } catch (exception &) {}
+}
+
+int main() {
+    tst1();
+    tst2();
+    return has_violations() ? 1 : 0;
+}
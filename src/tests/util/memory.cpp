@@ -27,7 +27,72 @@ static void tst1() {
     lean_assert_eq(old_mem, lean::get_allocated_memory());
 }
 
+static void tst2() {
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES)
+    lean::memory_category c1 = lean::register_memory_category("tst2_c1");
+    lean::memory_category c2 = lean::register_memory_category("tst2_c2");
+    auto get = [](lean::memory_category c) { return lean::get_memory_category_stats()[c]; };
+    void * p1;
+    void * p2;
+    {
+        lean::memory_scope s1(c1);
+        p1 = lean::malloc(100);
+        {
+            lean::memory_scope s2(c2);
+            p2 = lean::malloc(200);
+        }
+        lean_assert(lean::g_memory_category == c1);
+    }
+    lean_assert(lean::g_memory_category == 0);
+    lean_assert(get(c1).live() >= 100 && get(c1).live() < 200);
+    lean_assert(get(c2).live() >= 200);
+    {
+        lean::memory_scope s(c2);
+        lean::free(p2);
+    }
+    lean_assert(get(c2).live() == 0);
+    lean_assert(get(c2).m_allocated == get(c2).m_freed);
+    {
+        lean::memory_scope s(c1);
+        lean::free(p1);
+    }
+    lean_assert(get(c1).live() == 0);
+    lean::display_memory_category_stats(std::cout);
+#endif
+}
+
+static void tst3() {
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES) && defined(LEAN_MULTI_THREAD)
+    // Blocks are credited back to the category they were allocated in, even when they are
+    // reallocated or released in a different category or thread.
+    lean::memory_category c1 = lean::register_memory_category("tst3_c1");
+    lean::memory_category c2 = lean::register_memory_category("tst3_c2");
+    auto get = [](lean::memory_category c) { return lean::get_memory_category_stats()[c]; };
+    void * p;
+    {
+        lean::memory_scope s(c1);
+        p = lean::malloc(100);
+    }
+    {
+        lean::memory_scope s(c2);
+        p = lean::realloc(p, 1000);
+    }
+    lean_assert(get(c1).live() >= 1000);
+    lean_assert(get(c2).m_allocated == 0);
+    lean::thread t([&]() {
+            lean::get_allocated_memory(); // initialize the accounting data of this thread
+            lean::memory_scope s(c2);
+            lean::free(p);
+        });
+    t.join();
+    lean_assert(get(c1).live() == 0);
+    lean_assert(get(c2).m_allocated == 0 && get(c2).m_freed == 0);
+#endif
+}
+
 int main() {
     tst1();
+    tst2();
+    tst3();
     return lean::has_violations() ? 1 : 0;
 }
@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <iostream>
+#include <vector>
+#include "util/test.h"
+#include "util/thread.h"
+#include "util/memory_pool.h"
+#include "util/init_module.h"
+using namespace lean;
+
+static uint64 get_num_cells(unsigned sz) {
+    for (memory_pool_stats const & s : get_memory_pool_stats()) {
+        if (s.m_cell_size == sz)
+            return s.m_num_cells;
+    }
+    return 0;
+}
+
+static void tst1() {
+    // cells allocated by one pool and recycled by another one are reused by the first one
+    unsigned sz = 5 * sizeof(void*); // NOLINT
+    memory_pool p1(sz);
+    memory_pool p2(sz);
+    std::vector<void*> cells;
+    for (unsigned it = 0; it < 1000; it++) {
+        for (unsigned i = 0; i < 1000; i++)
+            cells.push_back(p1.allocate());
+        for (void * c : cells)
+            p2.recycle(c);
+        cells.clear();
+        lean_assert(get_num_cells(sz) <= 1000 + 4*LEAN_MEMORY_POOL_BATCH);
+    }
+    display_memory_pool_stats(std::cout);
+}
+
+#if defined(LEAN_MULTI_THREAD)
+static void tst2() {
+    // simulate a long session: each task allocates cells on a new thread, and they are recycled by the main thread
+    unsigned sz = 7 * sizeof(void*); // NOLINT
+    unsigned n  = 10000;
+    memory_pool * main_pool = allocate_thread_memory_pool(sz);
+    std::vector<void*> cells;
+    for (unsigned it = 0; it < 100; it++) {
+        thread t([&]() {
+                memory_pool * pool = allocate_thread_memory_pool(sz);
+                for (unsigned i = 0; i < n; i++)
+                    cells.push_back(pool->allocate());
+                run_thread_finalizers();
+                run_post_thread_finalizers();
+            });
+        t.join();
+        for (void * c : cells)
+            main_pool->recycle(c);
+        cells.clear();
+        lean_assert(get_num_cells(sz) <= n + 4*LEAN_MEMORY_POOL_BATCH);
+    }
+    display_memory_pool_stats(std::cout);
+}
+#else
+static void tst2() {}
+#endif
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    tst1();
+    tst2();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
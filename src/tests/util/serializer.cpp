@@ -171,6 +171,68 @@ static void tst4() {
     lean_assert_eq(d5, o5);
 }
 
+static void tst5() {
+    std::ostringstream out;
+    serializer s(out);
+    name n1{"foo", "bla"};
+    s.write_int(10); s.write_string("hello"); s << n1 << n1;
+    s.write_unsigned(3); s.write_char('a'); s.write_char('b'); s.write_char('c');
+    s.write_bool(true);
+    std::string str = out.str();
+    deserializer d(str.data(), str.data() + str.size());
+    name m1, m2;
+    lean_assert(d.read_int() == 10);
+    lean_assert(d.read_string() == "hello");
+    d >> m1 >> m2;
+    lean_assert(n1 == m1);
+    lean_assert(n1 == m2);
+    unsigned sz = d.read_unsigned();
+    lean_assert(std::string(d.read_block(sz), sz) == "abc");
+    lean_assert(d.read_bool());
+    try {
+        d.read_block(1);
+        lean_unreachable();
+    } catch (corrupted_stream_exception &) {}
+    try {
+        d.read_string();
+        lean_unreachable();
+    } catch (corrupted_stream_exception &) {}
+}
+
+static void tst6() {
+    list<int> l1{1, 2, 3, 4};
+    list<int> l2 = cons(10, l1);
+    name n1{"foo", "bla"};
+    std::ostringstream out;
+    serializer s1(out);
+    std::vector<char> buffer;
+    serializer s2(buffer);
+    for (serializer * s : {&s1, &s2}) {
+        s->write_unsigned(0xdeadbeef); s->write_int(-20); s->write_string("hello");
+        s->write_uint64(1ull << 40); s->write_char('x');
+        *s << l1 << l2 << n1 << l2 << n1 << 0.25;
+    }
+    // both backends must produce the same data
+    std::string str = out.str();
+    lean_assert(str == std::string(buffer.data(), buffer.size()));
+    deserializer d(buffer.data(), buffer.data() + buffer.size());
+    lean_assert(d.read_unsigned() == 0xdeadbeef);
+    lean_assert(d.read_int() == -20);
+    lean_assert(d.read_string() == "hello");
+    lean_assert(d.read_uint64() == (1ull << 40));
+    lean_assert(d.read_char() == 'x');
+    list<int> new_l1, new_l2, new_l3;
+    name m1, m2;
+    double v;
+    d >> new_l1 >> new_l2 >> m1 >> new_l3 >> m2 >> v;
+    lean_assert_eq(l1, new_l1);
+    lean_assert_eq(l2, new_l2);
+    lean_assert(is_eqp(new_l1, tail(new_l2)));
+    lean_assert(is_eqp(new_l2, new_l3));
+    lean_assert(n1 == m1 && n1 == m2);
+    lean_assert_eq(v, 0.25);
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -179,6 +241,8 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
+    tst6();
     finalize_util_module();
     return has_violations() ? 1 : 0;
 }
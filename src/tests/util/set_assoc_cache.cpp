@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include "util/test.h"
+#include "util/set_assoc_cache.h"
+#include "util/init_module.h"
+using namespace lean;
+
+struct int_entry {
+    int m_key;
+    int m_value;
+    int_entry():m_key(-1), m_value(0) {}
+    bool is_empty() const { return m_key < 0; }
+    void reset() { m_key = -1; }
+};
+
+typedef set_assoc_cache<int_entry> int_cache;
+
+static int * find(int_cache & c, int k) {
+    int_entry * e = c.find(k, [&](int_entry const & e) { return e.m_key == k; });
+    return e ? &e->m_value : nullptr;
+}
+
+static void insert(int_cache & c, int k, int v) {
+    int_entry & e = c.insert(k, [&](int_entry const & e) { return e.m_key == k; });
+    e.m_key   = k;
+    e.m_value = v;
+}
+
+static void tst1() {
+    // single set
+    int_cache c(LEAN_CACHE_WAYS);
+    lean_assert(c.capacity() == LEAN_CACHE_WAYS);
+    for (int i = 0; i < LEAN_CACHE_WAYS; i++)
+        insert(c, i, 2*i);
+    for (int i = 0; i < LEAN_CACHE_WAYS; i++)
+        lean_assert(*find(c, i) == 2*i);
+    lean_assert(c.hits() == LEAN_CACHE_WAYS);
+    lean_assert(c.evictions() == 0);
+    // 0 is now the least recently used entry
+    insert(c, 100, 1);
+    lean_assert(c.evictions() == 1);
+    lean_assert(!find(c, 0));
+    lean_assert(c.misses() == 1);
+    lean_assert(*find(c, 100) == 1);
+    // update existing entry
+    insert(c, 100, 2);
+    lean_assert(*find(c, 100) == 2);
+    lean_assert(c.evictions() == 1);
+    c.clear();
+    lean_assert(c.hits() == 0 && c.misses() == 0 && c.evictions() == 0);
+    for (int i = 1; i < LEAN_CACHE_WAYS; i++)
+        lean_assert(!find(c, i));
+    lean_assert(!find(c, 100));
+}
+
+static void tst2() {
+    // keys that collide in a direct-mapped cache do not evict each other
+    int_cache c(1024);
+    unsigned num_sets = 1024 / LEAN_CACHE_WAYS;
+    for (int i = 0; i < LEAN_CACHE_WAYS; i++)
+        insert(c, i * num_sets, i);
+    for (int i = 0; i < LEAN_CACHE_WAYS; i++)
+        lean_assert(*find(c, i * num_sets) == i);
+    lean_assert(c.evictions() == 0);
+    for (int i = 0; i < 10000; i++)
+        insert(c, i, i);
+    for (int i = 10000 - 256; i < 10000; i++)
+        lean_assert(*find(c, i) == i);
+    c.clear();
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    tst1();
+    tst2();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
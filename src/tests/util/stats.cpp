@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <iostream>
+#include <vector>
+#include "util/test.h"
+#include "util/thread.h"
+#include "util/stats.h"
+#include "util/init_module.h"
+using namespace lean;
+
+static stat_counter   g_c1;
+static stat_counter   g_c2;
+static stat_histogram g_h;
+
+static void tst1() {
+    reset_stats();
+    enable_stats(false);
+    inc_stat(g_c1);
+    inc_stat(g_h, name("foo"));
+    stats_snapshot s = get_stats();
+    lean_assert(s.get(g_c1) == 0);
+    lean_assert(s.get(g_h, name("foo")) == 0);
+    enable_stats(true);
+    inc_stat(g_c1);
+    inc_stat(g_c1);
+    add_stat(g_c2, 10);
+    inc_stat(g_h, name("foo"));
+    inc_stat(g_h, name("foo"));
+    inc_stat(g_h, name({"foo", "bar"}));
+    s = get_stats();
+    lean_assert(s.get(g_c1) == 2);
+    lean_assert(s.get(g_c2) == 10);
+    lean_assert(s.get(g_h, name("foo")) == 2);
+    lean_assert(s.get(g_h, name({"foo", "bar"})) == 1);
+    lean_assert(s.get(g_h, name("bar")) == 0);
+    display_stats(std::cout, s);
+    reset_stats();
+    s = get_stats();
+    lean_assert(s.get(g_c1) == 0);
+    lean_assert(s.get(g_h, name("foo")) == 0);
+    enable_stats(false);
+}
+
+#if defined(LEAN_MULTI_THREAD) && !defined(__APPLE__)
+static void tst2() {
+    reset_stats();
+    enable_stats(true);
+    unsigned n = 4;
+    std::vector<thread> threads;
+    for (unsigned i = 0; i < n; i++) {
+        threads.push_back(thread([]() {
+                    for (unsigned j = 0; j < 1000; j++)
+                        inc_stat(g_c1);
+                    inc_stat(g_h, name("foo"));
+                    run_thread_finalizers();
+                }));
+    }
+    for (thread & t : threads)
+        t.join();
+    inc_stat(g_c1);
+    stats_snapshot s = get_stats();
+    lean_assert(s.get(g_c1) == n * 1000 + 1);
+    lean_assert(s.get(g_h, name("foo")) == n);
+    enable_stats(false);
+}
+
+/** \brief Post thread finalizers (e.g., memory pools) may update counters after the thread finalizers were executed */
+static void tst3() {
+    reset_stats();
+    enable_stats(true);
+    thread t([]() {
+            inc_stat(g_c1);
+            run_thread_finalizers();
+            inc_stat(g_c1);
+            add_stat(g_c2, 5);
+            inc_stat(g_h, name("foo"));
+            run_post_thread_finalizers();
+        });
+    t.join();
+    stats_snapshot s = get_stats();
+    lean_assert(s.get(g_c1) == 2);
+    lean_assert(s.get(g_c2) == 5);
+    lean_assert(s.get(g_h, name("foo")) == 1);
+    enable_stats(false);
+}
+#else
+static void tst2() {}
+static void tst3() {}
+#endif
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    g_c1 = register_stat_counter("counter 1");
+    g_c2 = register_stat_counter("counter 2");
+    g_h  = register_stat_histogram("histogram");
+    tst1();
+    tst2();
+    tst3();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <string>
+#include <vector>
+#include "util/test.h"
+#include "util/task_scheduler.h"
+using namespace lean;
+
+static void tst1() {
+    // tasks creating new tasks
+    task_scheduler s(8);
+    atomic<unsigned> counter(0);
+    atomic<unsigned> pending(100);
+    for (unsigned i = 0; i < 100; i++) {
+        s.add([&, i]() {
+                for (unsigned j = 0; j < 10; j++)
+                    s.add([&]() { for (unsigned k = 0; k < 100000; k++) {} counter++; }, i % 3);
+                counter++;
+                if (--pending == 0)
+                    s.done();
+            });
+    }
+    s.run();
+    lean_assert(counter == 1100);
+    unsigned num_tasks = 0;
+    for (unsigned i = 0; i < s.get_num_threads(); i++)
+        num_tasks += s.get_stats(i).m_num_tasks;
+    lean_assert(num_tasks == 1100);
+    s.display_stats(std::cout);
+}
+
+static void tst2() {
+    // a single thread executes the tasks with the highest priority first
+    task_scheduler s(1);
+    std::vector<unsigned> order;
+    s.add([&]() { order.push_back(1); }, 1);
+    s.add([&]() { order.push_back(3); }, 3);
+    s.add([&]() { order.push_back(0); s.done(); }, 0);
+    s.add([&]() { order.push_back(2); }, 2);
+    s.run();
+    lean_assert(order.size() == 4);
+    lean_assert(order[0] == 3 && order[1] == 2 && order[2] == 1 && order[3] == 0);
+}
+
+static void tst3() {
+    // exceptions are propagated
+    task_scheduler s(4);
+    for (unsigned i = 0; i < 20; i++) {
+        s.add([=]() {
+                if (i == 10)
+                    throw exception("task failed");
+            });
+    }
+    try {
+        s.run();
+        lean_unreachable();
+    } catch (exception & ex) {
+        lean_assert(std::string(ex.what()) == "task failed");
+    }
+}
+
+static void tst4() {
+    // the scheduler can be reused after a successful run and after a failed one
+    task_scheduler s(4);
+    atomic<unsigned> counter(0);
+    for (unsigned r = 0; r < 3; r++) {
+        atomic<unsigned> pending(10);
+        s.reset();
+        for (unsigned i = 0; i < 10; i++) {
+            s.add([&]() {
+                    counter++;
+                    if (--pending == 0)
+                        s.done();
+                });
+        }
+        s.run();
+        lean_assert(counter == 10 * (r + 1));
+    }
+    s.reset();
+    for (unsigned i = 0; i < 20; i++)
+        s.add([]() { throw exception("task failed"); });
+    try {
+        s.run();
+        lean_unreachable();
+    } catch (exception &) {
+    }
+    s.reset();
+    s.add([&]() { counter++; s.done(); });
+    s.run();
+    lean_assert(counter == 31);
+}
+
+int main() {
+    save_stack_info();
+    tst1();
+    tst2();
+    tst3();
+    tst4();
+    return has_violations() ? 1 : 0;
+}
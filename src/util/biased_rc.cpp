@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#if defined(LEAN_BIASED_RC)
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "util/pair.h"
+#include "util/biased_rc.h"
+
+namespace lean {
+/** \brief Objects that must be merged by a thread. */
+struct rc_merge_queue {
+    mutex                                      m_mutex;
+    std::vector<std::pair<void*, rc_merge_fn>> m_todo;
+    atomic<bool>                               m_nonempty;
+    rc_merge_queue():m_nonempty(false) {}
+};
+
+struct rc_registry {
+    mutex                                         m_mutex;
+    atomic<unsigned>                              m_next_id;
+    std::unordered_map<unsigned, rc_merge_queue*> m_queues; // queues of running threads
+    rc_registry():m_next_id(1) {}
+};
+
+/** \brief The registry is never deleted because objects may be deleted by static destructors. */
+static rc_registry & get_rc_registry() {
+    static rc_registry * r = new rc_registry();
+    return *r;
+}
+
+LEAN_THREAD_LOCAL unsigned g_rc_thread_id = 0;
+LEAN_THREAD_PTR(rc_merge_queue, g_rc_queue);
+
+/** \brief Merge the queued objects, and then remove the queue from the registry. After that,
+    other threads merge the objects owned by this thread themselves. */
+static void finalize_rc_thread() {
+    rc_registry & r = get_rc_registry();
+    while (true) {
+        process_rc_merge_queue();
+        lock_guard<mutex> lock1(r.m_mutex);
+        lock_guard<mutex> lock2(g_rc_queue->m_mutex);
+        if (g_rc_queue->m_todo.empty()) {
+            r.m_queues.erase(g_rc_thread_id);
+            break;
+        }
+    }
+    delete g_rc_queue;
+    g_rc_queue = nullptr;
+}
+
+unsigned init_rc_thread() {
+    rc_registry & r = get_rc_registry();
+    unsigned id = r.m_next_id.fetch_add(1);
+    g_rc_queue  = new rc_merge_queue();
+    {
+        lock_guard<mutex> lock(r.m_mutex);
+        r.m_queues.insert(mk_pair(id, g_rc_queue));
+    }
+    g_rc_thread_id = id;
+    // Remark: this is usually one of the first finalizers registered by a thread, thus it is
+    // one of the last to be executed, after the thread local caches have been deleted.
+    register_thread_finalizer(finalize_rc_thread);
+    return id;
+}
+
+void enqueue_rc_merge(unsigned owner, void * obj, rc_merge_fn fn) {
+    rc_registry & r = get_rc_registry();
+    {
+        lock_guard<mutex> lock1(r.m_mutex);
+        auto it = r.m_queues.find(owner);
+        if (it != r.m_queues.end()) {
+            rc_merge_queue * q = it->second;
+            lock_guard<mutex> lock2(q->m_mutex);
+            q->m_todo.push_back(mk_pair(obj, fn));
+            q->m_nonempty.store(true, memory_order_release);
+            return;
+        }
+    }
+    // owner has already finished
+    fn(obj);
+}
+
+void process_rc_merge_queue() {
+    rc_merge_queue * q = g_rc_queue;
+    if (!q || !q->m_nonempty.load(memory_order_acquire))
+        return;
+    while (true) {
+        std::pair<void*, rc_merge_fn> p;
+        {
+            lock_guard<mutex> lock(q->m_mutex);
+            if (q->m_todo.empty()) {
+                q->m_nonempty.store(false, memory_order_relaxed);
+                return;
+            }
+            p = q->m_todo.back();
+            q->m_todo.pop_back();
+        }
+        // Remark: p.second may delete objects, and queue new ones.
+        p.second(p.first);
+    }
+}
+}
+#endif
@@ -0,0 +1,121 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include "util/thread.h"
+#include "util/debug.h"
+
+#if !defined(LEAN_MULTI_THREAD)
+#error "biased reference counting requires multi-thread support"
+#endif
+
+namespace lean {
+/** \brief Function for merging the counters of a biased_rc object stored in an object of type T.
+    It deletes the object if its reference counter is zero. */
+typedef void (*rc_merge_fn)(void * obj);
+
+extern LEAN_THREAD_LOCAL unsigned g_rc_thread_id;
+unsigned init_rc_thread();
+/** \brief Return a nonzero identifier for the current thread. Identifiers are never reused. */
+inline unsigned get_rc_thread_id() {
+    unsigned id = g_rc_thread_id;
+    return id ? id : init_rc_thread();
+}
+
+/** \brief Ask the thread \c owner to merge the counters of \c obj. If \c owner has already finished,
+    the merge is performed by the current thread. */
+void enqueue_rc_merge(unsigned owner, void * obj, rc_merge_fn fn);
+
+/** \brief Merge the counters of the objects queued by other threads for the current thread.
+    It is invoked by \c check_system and when the thread finishes. */
+void process_rc_merge_queue();
+
+/**
+   \brief Biased reference counter. The thread that creates an object (the owner) updates
+   a counter that is not shared with other threads using plain loads and stores, and other threads
+   update an atomic counter. Thus, there is no atomic read-modify-write operation when a term is
+   created, copied and deleted by the same thread.
+
+   The shared counter stores <tt>(n << 2) | flags</tt>. The value \c n may become negative, i.e.,
+   a thread deleted a reference created by the owner. The first time it happens, the object is
+   marked as \c QUEUED and sent to the owner, which merges the two counters at its next safe point
+   (see \c process_rc_merge_queue). After the counters are merged (flag \c MERGED), all threads,
+   including the owner, use the shared counter, and the object is deleted when it reaches zero.
+   The owner also performs the merge when its own counter reaches zero and the object is not queued.
+
+   An object is only deleted after it has been merged, and queued objects are only merged by
+   the owner (or by the thread that queued it when the owner has already finished). Thus, the owner
+   never processes a queued object that has already been deleted.
+*/
+class biased_rc {
+    static constexpr int MERGED = 1;
+    static constexpr int QUEUED = 2;
+    static constexpr int ONE    = 4;
+    unsigned const   m_owner;
+    atomic<int>      m_biased; // only updated by the owner, it may become negative after the object is queued
+    atomic<int>      m_shared;
+    static int count(int v) { return (v & ~(MERGED | QUEUED)) / ONE; }
+    bool use_biased() const {
+        return m_owner == get_rc_thread_id() && (m_shared.load(memory_order_relaxed) & MERGED) == 0;
+    }
+    /** \brief Invoked by the owner when its counter reaches zero. Return true if the object must be deleted. */
+    bool implicit_merge() {
+        int v = m_shared.load(memory_order_relaxed);
+        while (true) {
+            if (v & QUEUED)
+                return false; // the object will be merged when the owner processes its queue
+            if (m_shared.compare_exchange_weak(v, v | MERGED, memory_order_acq_rel, memory_order_relaxed))
+                return count(v) == 0;
+        }
+    }
+public:
+    explicit biased_rc(unsigned v):m_owner(get_rc_thread_id()), m_biased(static_cast<int>(v)), m_shared(0) {}
+
+    /** \brief Return the sum of both counters. The result is only an approximation when the object is
+        being updated by other threads. */
+    unsigned get() const {
+        return static_cast<unsigned>(m_biased.load(memory_order_relaxed) + count(m_shared.load(memory_order_relaxed)));
+    }
+
+    void inc() {
+        if (use_biased())
+            m_biased.store(m_biased.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        else
+            m_shared.fetch_add(ONE, memory_order_relaxed);
+    }
+
+    /** \brief Decrement the counter, and return true if \c obj must be deleted. */
+    bool dec(void * obj, rc_merge_fn fn) {
+        if (use_biased()) {
+            int b = m_biased.load(memory_order_relaxed) - 1;
+            m_biased.store(b, memory_order_relaxed);
+            return b == 0 && implicit_merge();
+        }
+        int v = m_shared.load(memory_order_relaxed);
+        while (true) {
+            int new_v   = v - ONE;
+            bool queue  = (new_v & (MERGED | QUEUED)) == 0 && count(new_v) < 0;
+            if (queue)
+                new_v |= QUEUED;
+            if (m_shared.compare_exchange_weak(v, new_v, memory_order_acq_rel, memory_order_relaxed)) {
+                if (queue)
+                    enqueue_rc_merge(m_owner, obj, fn);
+                return (new_v & MERGED) != 0 && count(new_v) == 0;
+            }
+        }
+    }
+
+    /** \brief Merge the counters of a queued object. Return true if the object must be deleted.
+        \remark This method is only invoked by \c process_rc_merge_queue and \c enqueue_rc_merge. */
+    bool merge() {
+        int b = m_biased.load(memory_order_relaxed);
+        m_biased.store(0, memory_order_relaxed);
+        int v = m_shared.fetch_add(b * ONE + MERGED, memory_order_acq_rel);
+        lean_assert((v & QUEUED) && !(v & MERGED));
+        return count(v) + b == 0;
+    }
+};
+}
@@ -4,6 +4,9 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <cstring>
+#include "util/hash.h"
+
 namespace lean {
 
 void mix(unsigned & a, unsigned & b, unsigned & c) {
@@ -60,4 +63,114 @@ unsigned hash_str(unsigned length, char const * str, unsigned init_value) {
     return c;
 }
 
+static uint64 const g_prime1 = 11400714785074694791ull;
+static uint64 const g_prime2 = 14029467366897019727ull;
+static uint64 const g_prime3 =  1609587929392839161ull;
+static uint64 const g_prime4 =  9650029242287828579ull;
+static uint64 const g_prime5 =  2870177450012600261ull;
+
+static inline uint64 rotl64(uint64 x, unsigned r) { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64 read64(unsigned char const * p) {
+    return
+        static_cast<uint64>(p[0])       | (static_cast<uint64>(p[1]) << 8)  |
+        (static_cast<uint64>(p[2]) << 16) | (static_cast<uint64>(p[3]) << 24) |
+        (static_cast<uint64>(p[4]) << 32) | (static_cast<uint64>(p[5]) << 40) |
+        (static_cast<uint64>(p[6]) << 48) | (static_cast<uint64>(p[7]) << 56);
+}
+
+static inline uint64 read32(unsigned char const * p) {
+    return
+        static_cast<uint64>(p[0])       | (static_cast<uint64>(p[1]) << 8) |
+        (static_cast<uint64>(p[2]) << 16) | (static_cast<uint64>(p[3]) << 24);
+}
+
+static inline uint64 hash64_round(uint64 acc, uint64 input) {
+    acc += input * g_prime2;
+    acc  = rotl64(acc, 31);
+    return acc * g_prime1;
+}
+
+static inline uint64 hash64_merge(uint64 acc, uint64 lane) {
+    acc ^= hash64_round(0, lane);
+    return acc * g_prime1 + g_prime4;
+}
+
+/** \brief Consume 32-byte stripes from \c p, and return the number of bytes consumed. */
+static inline size_t hash64_stripes(uint64 * lanes, unsigned char const * p, size_t n) {
+    uint64 v1 = lanes[0], v2 = lanes[1], v3 = lanes[2], v4 = lanes[3];
+    size_t i  = 0;
+    for (; i + 32 <= n; i += 32) {
+        v1 = hash64_round(v1, read64(p + i));
+        v2 = hash64_round(v2, read64(p + i + 8));
+        v3 = hash64_round(v3, read64(p + i + 16));
+        v4 = hash64_round(v4, read64(p + i + 24));
+    }
+    lanes[0] = v1; lanes[1] = v2; lanes[2] = v3; lanes[3] = v4;
+    return i;
+}
+
+hash64_stream::hash64_stream(uint64 seed):m_total(0), m_seed(seed) {
+    m_lanes[0] = seed + g_prime1 + g_prime2;
+    m_lanes[1] = seed + g_prime2;
+    m_lanes[2] = seed;
+    m_lanes[3] = seed - g_prime1;
+}
+
+void hash64_stream::update(char const * data, size_t n) {
+    unsigned char const * p = reinterpret_cast<unsigned char const *>(data);
+    size_t used = m_total % 32;
+    m_total += n;
+    if (used > 0) {
+        size_t k = 32 - used;
+        if (n < k) {
+            std::memcpy(m_buffer + used, p, n);
+            return;
+        }
+        std::memcpy(m_buffer + used, p, k);
+        hash64_stripes(m_lanes, m_buffer, 32);
+        p += k; n -= k;
+    }
+    size_t k = hash64_stripes(m_lanes, p, n);
+    std::memcpy(m_buffer, p + k, n - k);
+}
+
+uint64 hash64_stream::digest() const {
+    uint64 h;
+    if (m_total >= 32) {
+        h = rotl64(m_lanes[0], 1) + rotl64(m_lanes[1], 7) + rotl64(m_lanes[2], 12) + rotl64(m_lanes[3], 18);
+        for (unsigned i = 0; i < 4; i++)
+            h = hash64_merge(h, m_lanes[i]);
+    } else {
+        h = m_seed + g_prime5;
+    }
+    h += m_total;
+    unsigned char const * p   = m_buffer;
+    unsigned char const * end = m_buffer + m_total % 32;
+    for (; p + 8 <= end; p += 8) {
+        h ^= hash64_round(0, read64(p));
+        h  = rotl64(h, 27) * g_prime1 + g_prime4;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * g_prime1;
+        h  = rotl64(h, 23) * g_prime2 + g_prime3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * g_prime5;
+        h  = rotl64(h, 11) * g_prime1;
+    }
+    h ^= h >> 33;
+    h *= g_prime2;
+    h ^= h >> 29;
+    h *= g_prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64 hash64(char const * data, size_t n, uint64 seed) {
+    hash64_stream h(seed);
+    h.update(data, n);
+    return h.digest();
+}
 }
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <cstddef>
 #include "util/debug.h"
 #include "util/int64.h"
 
@@ -28,6 +29,39 @@ inline uint64 hash(uint64 h1, uint64 h2) {
     return h2;
 }
 
+/** \brief Combine two 64-bit hash codes. The result is passed through the MurmurHash3 finalizer
+    because all its bits are used (e.g., the high 32 bits of expr_cell::hash64 distinguish expressions
+    that have the same 32-bit hash code). */
+inline uint64 hash64(uint64 h1, uint64 h2) {
+    uint64 h = h1 ^ (h2 + 0x9e3779b97f4a7c15ull + (h1 << 6) + (h1 >> 2));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/** \brief Incremental 64-bit hash for blocks of data (e.g., the contents of .olean files).
+
+    The data is consumed 8 bytes at a time using four independent lanes (the XXH64 algorithm).
+    The result does not depend on how the data is split in \c update calls, nor on the host byte order.
+*/
+class hash64_stream {
+    uint64        m_lanes[4];
+    unsigned char m_buffer[32]; // pending bytes, m_total % 32 bytes are used
+    uint64        m_total;
+    uint64        m_seed;
+public:
+    hash64_stream(uint64 seed = 0);
+    void update(char const * data, size_t n);
+    /** \brief Return the hash code of the data consumed so far. */
+    uint64 digest() const;
+};
+
+/** \brief Return the 64-bit hash code of the given block of data. \see hash64_stream */
+uint64 hash64(char const * data, size_t n, uint64 seed = 0);
+
 template<typename H>
 unsigned hash(unsigned n, H h, unsigned init_value = 31) {
     unsigned a, b, c;
@@ -15,6 +15,8 @@ Author: Leonardo de Moura
 #include "util/lean_path.h"
 #include "util/thread.h"
 #include "util/memory_pool.h"
+#include "util/stats.h"
+#include "util/region.h"
 
 namespace lean {
 void initialize_util_module() {
@@ -28,8 +30,14 @@ void initialize_util_module() {
     initialize_name();
     initialize_name_generator();
     initialize_lean_path();
+    initialize_stats();
+    initialize_memory_pool();
+    initialize_region();
 }
 void finalize_util_module() {
+    finalize_region();
+    finalize_memory_pool();
+    finalize_stats();
     finalize_lean_path();
     finalize_name_generator();
     finalize_name();
@@ -8,6 +8,9 @@ Author: Leonardo de Moura
 #include "util/interrupt.h"
 #include "util/exception.h"
 #include "util/memory.h"
+#if defined(LEAN_BIASED_RC)
+#include "util/biased_rc.h"
+#endif
 
 namespace lean {
 MK_THREAD_LOCAL_GET(atomic_bool, get_g_interrupt, false);
@@ -35,6 +38,9 @@ void check_system(char const * component_name) {
     check_stack(component_name);
     check_memory(component_name);
     check_interrupted();
+#if defined(LEAN_BIASED_RC)
+    process_rc_merge_queue();
+#endif
 }
 
 void sleep_for(unsigned ms, unsigned step_ms) {
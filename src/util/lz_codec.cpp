@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "util/exception.h"
+#include "util/hash.h"
+#include "util/serializer.h"
+#include "util/lz_codec.h"
+
+namespace lean {
+/*
+   Command format:
+   - token: the 4 most significant bits contain the number of literals, and
+     the 4 least significant bits contain the length of the match minus g_min_match.
+     The value 15 means the length continues in the following bytes, each byte is added to it,
+     and a byte different from 255 terminates the sequence.
+   - literals
+   - offset of the match (2 bytes, little endian)
+
+   The last command contains only literals.
+*/
+static unsigned const g_min_match   = 4;
+static unsigned const g_last_lits   = 5;  // the last bytes are always literals
+static unsigned const g_match_limit = 12; // matches do not start in the last bytes
+static unsigned const g_max_offset  = 65535;
+static unsigned const g_hash_log    = 12;
+
+static inline unsigned read32(unsigned char const * p) {
+    unsigned r;
+    std::memcpy(&r, p, sizeof(unsigned));
+    return r;
+}
+
+static inline unsigned hash_seq(unsigned v) {
+    return (v * 2654435761u) >> (32 - g_hash_log);
+}
+
+static void write_length(std::vector<char> & out, size_t len) {
+    while (len >= 255) {
+        out.push_back(static_cast<char>(255));
+        len -= 255;
+    }
+    out.push_back(static_cast<char>(len));
+}
+
+static void write_command(std::vector<char> & out, unsigned char const * lits, size_t num_lits,
+                          size_t offset, size_t match_len) {
+    size_t m = match_len > 0 ? match_len - g_min_match : 0;
+    unsigned char token = static_cast<unsigned char>(((num_lits < 15 ? num_lits : 15) << 4) | (m < 15 ? m : 15));
+    out.push_back(static_cast<char>(token));
+    if (num_lits >= 15)
+        write_length(out, num_lits - 15);
+    out.insert(out.end(), lits, lits + num_lits);
+    if (match_len > 0) {
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (m >= 15)
+            write_length(out, m - 15);
+    }
+}
+
+void lz_compress(char const * data, size_t n, std::vector<char> & out) {
+    unsigned char const * in = reinterpret_cast<unsigned char const *>(data);
+    size_t anchor = 0; // first literal of the current command
+    if (n > g_match_limit) {
+        std::vector<unsigned> table(1u << g_hash_log, 0); // position + 1 of the last occurrence of a hash code
+        size_t limit     = n - g_match_limit;
+        size_t match_end = n - g_last_lits;
+        size_t i         = 0;
+        while (i < limit) {
+            unsigned v   = read32(in + i);
+            unsigned h   = hash_seq(v);
+            size_t cand  = table[h];
+            table[h]     = i + 1;
+            if (cand == 0 || i - (cand - 1) > g_max_offset || read32(in + cand - 1) != v) {
+                i++;
+                continue;
+            }
+            cand--;
+            size_t len = g_min_match;
+            while (i + len < match_end && in[cand + len] == in[i + len])
+                len++;
+            write_command(out, in + anchor, i - anchor, i - cand, len);
+            i     += len;
+            anchor = i;
+        }
+    }
+    write_command(out, in + anchor, n - anchor, 0, 0);
+}
+
+static void throw_corrupted() {
+    throw exception("failed to decompress block, data is corrupted");
+}
+
+static size_t read_length(unsigned char const * & p, unsigned char const * end) {
+    size_t r = 0;
+    while (true) {
+        if (p == end)
+            throw_corrupted();
+        unsigned char c = *p++;
+        r += c;
+        if (c != 255)
+            return r;
+    }
+}
+
+void lz_decompress(char const * data, size_t n, char * out, size_t out_size) {
+    unsigned char const * p   = reinterpret_cast<unsigned char const *>(data);
+    unsigned char const * end = p + n;
+    size_t o = 0;
+    while (true) {
+        if (p == end)
+            throw_corrupted();
+        unsigned char token = *p++;
+        size_t num_lits = token >> 4;
+        if (num_lits == 15)
+            num_lits += read_length(p, end);
+        if (num_lits > static_cast<size_t>(end - p) || num_lits > out_size - o)
+            throw_corrupted();
+        std::memcpy(out + o, p, num_lits);
+        p += num_lits;
+        o += num_lits;
+        if (p == end) {
+            if (o != out_size)
+                throw_corrupted();
+            return;
+        }
+        if (end - p < 2)
+            throw_corrupted();
+        size_t offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        size_t len = (token & 15);
+        if (len == 15)
+            len += read_length(p, end);
+        len += g_min_match;
+        if (offset == 0 || offset > o || len > out_size - o)
+            throw_corrupted();
+        char const * src = out + o - offset;
+        if (offset >= len) {
+            std::memcpy(out + o, src, len);
+        } else {
+            // overlapping copy
+            for (size_t i = 0; i < len; i++)
+                out[o + i] = src[i];
+        }
+        o += len;
+    }
+}
+
+void lz_compress_blocks(char const * data, size_t n, std::vector<char> & out, unsigned block_size) {
+    lean_assert(block_size > 0);
+    std::vector<std::vector<char>> blocks;
+    for (size_t i = 0; i < n; i += block_size) {
+        blocks.push_back(std::vector<char>());
+        lz_compress(data + i, std::min<size_t>(block_size, n - i), blocks.back());
+    }
+    serializer s(out);
+    s.write_unsigned(n);
+    s.write_unsigned(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        s.write_unsigned(blocks[i].size());
+        s.write_unsigned(std::min<size_t>(block_size, n - i * block_size));
+        s.write_uint64(hash64(blocks[i].data(), blocks[i].size()));
+    }
+    for (auto const & b : blocks)
+        s.write_block(b.data(), b.size());
+}
+
+unsigned lz_read_blocks(char const * data, size_t n, std::vector<lz_block> & blocks) {
+    deserializer d(data, data + n);
+    unsigned raw_size   = d.read_unsigned();
+    unsigned num_blocks = d.read_unsigned();
+    unsigned raw_offset = 0;
+    blocks.clear();
+    for (unsigned i = 0; i < num_blocks; i++) {
+        lz_block b;
+        b.m_data       = nullptr;
+        b.m_size       = d.read_unsigned();
+        b.m_raw_size   = d.read_unsigned();
+        b.m_hash       = d.read_uint64();
+        b.m_raw_offset = raw_offset;
+        if (b.m_raw_size > raw_size - raw_offset)
+            throw corrupted_stream_exception();
+        raw_offset    += b.m_raw_size;
+        blocks.push_back(b);
+    }
+    if (raw_offset != raw_size)
+        throw corrupted_stream_exception();
+    for (lz_block & b : blocks)
+        b.m_data = d.read_block(b.m_size);
+    return raw_size;
+}
+
+bool lz_decompress_block(lz_block const & b, char * out) {
+    if (hash64(b.m_data, b.m_size) != b.m_hash)
+        return false;
+    lz_decompress(b.m_data, b.m_size, out + b.m_raw_offset, b.m_raw_size);
+    return true;
+}
+}
@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "util/int64.h"
+
+namespace lean {
+/**
+   \brief Compress the block \c data[0, n) using a LZ77 codec, and append the result to \c out.
+
+   The compressed block is a sequence of commands. Each command contains a sequence of literals
+   followed by a back reference (offset, length) into the data already decompressed.
+   The codec is tuned for speed, the compression ratio is secondary.
+*/
+void lz_compress(char const * data, size_t n, std::vector<char> & out);
+
+/**
+   \brief Decompress the block \c data[0, n) into \c out[0, out_size).
+   Throws an exception if \c data is not a block produced by \c lz_compress for data of size \c out_size.
+*/
+void lz_decompress(char const * data, size_t n, char * out, size_t out_size);
+
+/** \brief Block of a compressed stream. \see lz_compress_blocks */
+struct lz_block {
+    char const * m_data;       // compressed data
+    unsigned     m_size;       // size of the compressed data
+    unsigned     m_raw_offset; // position of the decompressed data in the stream
+    unsigned     m_raw_size;   // size of the decompressed data
+    uint64       m_hash;       // hash code of the compressed data
+};
+
+/**
+   \brief Compress \c data[0, n) and append the result to \c out.
+   The data is split in blocks of \c block_size bytes, and each block is compressed independently, and has its
+   own checksum. Thus, blocks can be verified and decompressed in parallel (see \c lz_read_blocks).
+*/
+void lz_compress_blocks(char const * data, size_t n, std::vector<char> & out, unsigned block_size = 256*1024);
+
+/**
+   \brief Read the block table of a stream produced by \c lz_compress_blocks, store its blocks in \c blocks,
+   and return the size of the decompressed stream.
+   Throws corrupted_stream_exception if the block table is not valid.
+*/
+unsigned lz_read_blocks(char const * data, size_t n, std::vector<lz_block> & blocks);
+
+/**
+   \brief Verify the checksum of the given block, and decompress it at \c out + b.m_raw_offset.
+   Return false if the checksum does not match. Throws an exception if the data is corrupted.
+*/
+bool lz_decompress_block(lz_block const & b, char * out);
+}
@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <string>
+#include <fstream>
+#include <vector>
+#include "util/exception.h"
+#include "util/sstream.h"
+#include "util/mapped_file.h"
+
+#if (defined(LEAN_WINDOWS) && !defined(LEAN_CYGWIN)) || defined(LEAN_EMSCRIPTEN)
+#define LEAN_NO_MMAP
+#endif
+
+#if !defined(LEAN_NO_MMAP)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace lean {
+static void throw_open_error(std::string const & fname) {
+    throw exception(sstream() << "failed to open file '" << fname << "'");
+}
+
+static void read_file(std::string const & fname, std::vector<char> & buffer) {
+    std::ifstream in(fname, std::ifstream::binary);
+    if (!in.good())
+        throw_open_error(fname);
+    in.seekg(0, std::ios::end);
+    std::streamoff sz = in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (sz < 0)
+        throw_open_error(fname);
+    buffer.resize(static_cast<size_t>(sz));
+    if (sz > 0 && !in.read(buffer.data(), sz))
+        throw exception(sstream() << "failed to read file '" << fname << "'");
+}
+
+mapped_file::mapped_file(std::string const & fname):
+    m_fname(fname), m_data(nullptr), m_size(0), m_mapped(false) {
+#if !defined(LEAN_NO_MMAP)
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw_open_error(fname);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw_open_error(fname);
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size > 0) {
+        void * p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            m_data   = static_cast<char const *>(p);
+            m_mapped = true;
+        }
+    }
+    close(fd);
+    if (m_mapped || m_size == 0)
+        return;
+    // mmap failed (e.g., special file system), fallback to regular read
+#endif
+    read_file(fname, m_buffer);
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+}
+
+mapped_file::~mapped_file() {
+#if !defined(LEAN_NO_MMAP)
+    if (m_mapped)
+        munmap(const_cast<char *>(m_data), m_size);
+#endif
+}
+}
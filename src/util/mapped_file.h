@@ -0,0 +1,41 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <string>
+#include <vector>
+
+namespace lean {
+/**
+   \brief Read-only view of the contents of a file.
+
+   On platforms that support it, the file is memory mapped, and no copy is performed.
+   Otherwise, the whole file is read into an internal buffer.
+
+   \remark The file must not be modified in place while it is mapped.
+   Writers should create a new file and rename it over the old one.
+*/
+class mapped_file {
+    std::string       m_fname;
+    char const *      m_data;
+    size_t            m_size;
+    bool              m_mapped;  //!< true if m_data is a memory mapping
+    std::vector<char> m_buffer;  //!< used when memory mapping is not available
+    mapped_file(mapped_file const &) = delete;
+    mapped_file & operator=(mapped_file const &) = delete;
+public:
+    /** \brief Map the given file. Throws an exception if the file cannot be opened. */
+    mapped_file(std::string const & fname);
+    ~mapped_file();
+    std::string const & get_file_name() const { return m_fname; }
+    char const * data() const { return m_data; }
+    char const * begin() const { return m_data; }
+    char const * end() const { return m_data + m_size; }
+    size_t size() const { return m_size; }
+    /** \brief Return true iff the file is memory mapped. */
+    bool is_mapped() const { return m_mapped; }
+};
+}
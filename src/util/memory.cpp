@@ -7,6 +7,8 @@ Author: Leonardo de Moura
 #include <new>
 #include <cstdlib>
 #include <iostream>
+#include <iomanip>
+#include <vector>
 #include "util/exception.h"
 #include "util/memory.h"
 
@@ -16,6 +18,24 @@ void set_max_memory_megabyte(unsigned max) {
     m *= 1024 * 1024;
     set_max_memory(m);
 }
+
+LEAN_THREAD_LOCAL memory_category g_memory_category = 0;
+
+void display_memory_category_stats(std::ostream & out) {
+    std::vector<memory_category_stats> s = get_memory_category_stats();
+    if (s.empty()) {
+        out << "memory accounting is not available (possible solution: compile using LEAN_TRACK_MEMORY_CATEGORIES)\n";
+        return;
+    }
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::left << std::setw(20) << "memory category" << std::right
+        << std::setw(16) << "live" << std::setw(16) << "allocated" << std::setw(16) << "freed" << "\n";
+    for (memory_category_stats const & c : s) {
+        out << std::left << std::setw(20) << c.m_name << std::right
+            << std::setw(16) << c.live() << std::setw(16) << c.m_allocated << std::setw(16) << c.m_freed << "\n";
+    }
+    out.flags(flags);
+}
 }
 
 #if !defined(LEAN_TRACK_MEMORY)
@@ -33,6 +53,14 @@ void check_memory(char const * component_name) {
     // do nothing when LEAN_TRACK_MEMORY is not defined
 }
 
+memory_category register_memory_category(char const *) {
+    return 0;
+}
+
+std::vector<memory_category_stats> get_memory_category_stats() {
+    return std::vector<memory_category_stats>();
+}
+
 void * malloc(size_t sz, bool use_ex)  {
     void * r = ::malloc(sz);
     if (r || sz == 0)
@@ -130,11 +158,149 @@ public:
 static alloc_info g_global_memory;
 static size_t     g_max_memory = 0;
 
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES)
+/** \brief Memory charged to each category by a thread. The counters are atomic because they are
+    read by \c get_memory_category_stats. Since there is no contention, the cost of a relaxed atomic
+    increment is small.
+
+    Remark: the objects used for accounting are allocated using ::malloc and may be used by
+    static initializers. So, we only use objects that do not need dynamic initialization. */
+struct thread_memory {
+    atomic<int64>   m_allocated[LEAN_MAX_MEMORY_CATEGORIES];
+    atomic<int64>   m_freed[LEAN_MAX_MEMORY_CATEGORIES];
+    thread_memory * m_prev;
+    thread_memory * m_next;
+    thread_memory():m_prev(nullptr), m_next(nullptr) {
+        for (unsigned i = 0; i < LEAN_MAX_MEMORY_CATEGORIES; i++) {
+            m_allocated[i].store(0);
+            m_freed[i].store(0);
+        }
+    }
+};
+
+static mutex           g_memory_mutex;
+static char const *    g_memory_category_names[LEAN_MAX_MEMORY_CATEGORIES] = { "other" };
+static unsigned        g_num_memory_categories = 1;
+static thread_memory * g_thread_memory_list = nullptr; // running threads
+static int64           g_finished_allocated[LEAN_MAX_MEMORY_CATEGORIES];
+static int64           g_finished_freed[LEAN_MAX_MEMORY_CATEGORIES];
+LEAN_THREAD_PTR(thread_memory, g_thread_memory);
+LEAN_THREAD_VALUE(bool, g_thread_memory_finalized, false);
+
+memory_category register_memory_category(char const * name) {
+    lock_guard<mutex> lock(g_memory_mutex);
+    if (g_num_memory_categories >= LEAN_MAX_MEMORY_CATEGORIES)
+        throw exception("too many memory categories, recompile Lean using a bigger LEAN_MAX_MEMORY_CATEGORIES");
+    g_memory_category_names[g_num_memory_categories] = name;
+    return g_num_memory_categories++;
+}
+
+static void finalize_thread_memory() {
+    thread_memory * m = g_thread_memory;
+    g_thread_memory_finalized = true;
+    g_thread_memory = nullptr;
+    {
+        lock_guard<mutex> lock(g_memory_mutex);
+        for (unsigned i = 0; i < LEAN_MAX_MEMORY_CATEGORIES; i++) {
+            g_finished_allocated[i] += atomic_load(&m->m_allocated[i]);
+            g_finished_freed[i]     += atomic_load(&m->m_freed[i]);
+        }
+        if (m->m_prev)
+            m->m_prev->m_next = m->m_next;
+        else
+            g_thread_memory_list = m->m_next;
+        if (m->m_next)
+            m->m_next->m_prev = m->m_prev;
+    }
+    m->~thread_memory();
+    ::free(m);
+}
+
+static thread_memory * get_thread_memory() {
+    if (!g_thread_memory) {
+        if (g_thread_memory_finalized)
+            return nullptr;
+        void * mem = ::malloc(sizeof(thread_memory));
+        if (!mem)
+            return nullptr;
+        thread_memory * m = new (mem) thread_memory();
+        {
+            lock_guard<mutex> lock(g_memory_mutex);
+            m->m_next = g_thread_memory_list;
+            if (g_thread_memory_list)
+                g_thread_memory_list->m_prev = m;
+            g_thread_memory_list = m;
+        }
+        g_thread_memory = m;
+        // Remark: register_post_thread_finalizer may allocate memory, and it uses g_thread_memory.
+        register_post_thread_finalizer(finalize_thread_memory);
+    }
+    return g_thread_memory;
+}
+
+static void add_to(atomic<int64> & c, size_t sz) {
+    atomic_fetch_add_explicit(&c, static_cast<int64>(sz), memory_order_relaxed);
+}
+
+static void charge_alloc(size_t sz, memory_category c) {
+    g_global_memory.inc(sz);
+    if (thread_memory * m = get_thread_memory())
+        add_to(m->m_allocated[c], sz);
+}
+
+static void charge_free(size_t sz, memory_category c) {
+    g_global_memory.dec(sz);
+    if (thread_memory * m = get_thread_memory())
+        add_to(m->m_freed[c], sz);
+}
+
+/** \brief Header stored before each block. It records the category the block was charged to when it was allocated,
+    and the block is released in the same category, even if it is deleted by a different subsystem or thread
+    (e.g., snapshots discarded by the server, or unifier states released by a lazy list). */
+union alloc_header {
+    memory_category m_category;
+    long double     m_align; // preserve the alignment provided by malloc
+};
+
+static alloc_header * get_header(void * ptr) { return static_cast<alloc_header*>(ptr) - 1; }
+
+std::vector<memory_category_stats> get_memory_category_stats() {
+    std::vector<memory_category_stats> r;
+    lock_guard<mutex> lock(g_memory_mutex);
+    for (unsigned i = 0; i < g_num_memory_categories; i++) {
+        memory_category_stats s;
+        s.m_name      = g_memory_category_names[i];
+        s.m_allocated = g_finished_allocated[i];
+        s.m_freed     = g_finished_freed[i];
+        for (thread_memory * m = g_thread_memory_list; m; m = m->m_next) {
+            s.m_allocated += atomic_load(&m->m_allocated[i]);
+            s.m_freed     += atomic_load(&m->m_freed[i]);
+        }
+        r.push_back(s);
+    }
+    return r;
+}
+
+#else
+memory_category register_memory_category(char const *) {
+    return 0;
+}
+
+std::vector<memory_category_stats> get_memory_category_stats() {
+    return std::vector<memory_category_stats>();
+}
+#endif
+
 void set_max_memory(size_t max) {
     g_max_memory = max;
 }
 
 size_t get_allocated_memory() {
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES)
+    // Remark: the accounting data of this thread is created (and the memory needed to delete it is
+    // allocated) before reading the counter. Thus, two consecutive readings are not affected by it.
+    get_thread_memory();
+#endif
     return g_global_memory.size();
 }
 
@@ -143,6 +309,52 @@ void check_memory(char const * component_name) {
         throw memory_exception(component_name);
 }
 
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES)
+void * malloc(size_t sz, bool use_ex)  {
+    void * r = malloc_core(sz + sizeof(alloc_header));
+    if (r) {
+        alloc_header * h = static_cast<alloc_header*>(r);
+        h->m_category = g_memory_category;
+        charge_alloc(malloc_size(r), h->m_category);
+        return h + 1;
+    } else if (use_ex) {
+        throw std::bad_alloc();
+    } else {
+        return nullptr;
+    }
+}
+
+void * malloc(size_t sz) {
+    return malloc(sz, true);
+}
+
+void * realloc(void * ptr, size_t sz) {
+    if (ptr == nullptr)
+        return malloc(sz);
+    if (sz == 0) {
+        free(ptr);
+        return nullptr;
+    }
+    // Remark: the block remains in its original category.
+    alloc_header * h  = get_header(ptr);
+    memory_category c = h->m_category;
+    size_t old_sz     = malloc_size(h);
+    void * r          = realloc_core(h, sz + sizeof(alloc_header));
+    if (!r)
+        throw std::bad_alloc();
+    charge_free(old_sz, c);
+    charge_alloc(malloc_size(r), c);
+    return static_cast<alloc_header*>(r) + 1;
+}
+
+void free(void * ptr) {
+    if (ptr) {
+        alloc_header * h = get_header(ptr);
+        charge_free(malloc_size(h), h->m_category);
+        free_core(h);
+    }
+}
+#else
 void * malloc(size_t sz, bool use_ex)  {
     void * r = malloc_core(sz);
     if (r || sz == 0) {
@@ -168,14 +380,12 @@ void * realloc(void * ptr, size_t sz) {
         return nullptr;
     }
     size_t old_sz = malloc_size(ptr);
-    g_global_memory.dec(old_sz);
     void * r = realloc_core(ptr, sz);
-    size_t new_sz = malloc_size(r);
-    g_global_memory.inc(new_sz);
-    if (r || sz == 0)
-        return r;
-    else
+    if (!r)
         throw std::bad_alloc();
+    g_global_memory.dec(old_sz);
+    g_global_memory.inc(malloc_size(r));
+    return r;
 }
 
 void free(void * ptr) {
@@ -185,6 +395,7 @@ void free(void * ptr) {
     }
     free_core(ptr);
 }
+#endif
 }
 
 void* operator new(std::size_t sz) throw(std::bad_alloc) { return lean::malloc(sz, true); }
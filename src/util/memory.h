@@ -6,6 +6,14 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "util/int64.h"
+#include "util/thread.h"
+
+#ifndef LEAN_MAX_MEMORY_CATEGORIES
+#define LEAN_MAX_MEMORY_CATEGORIES 32
+#endif
 
 namespace lean {
 /** \brief Set maximum amount of memory in bytes */
@@ -17,4 +25,47 @@ size_t get_allocated_memory();
 void * malloc(size_t sz);
 void * realloc(void * ptr, size_t sz);
 void free(void * ptr);
+
+/**
+   \brief Memory categories are used to account the heap memory used by each subsystem (e.g., names,
+   expressions, the info_manager). Each thread has a current category, and the memory allocated and
+   freed by the thread is charged to it. The current category is set using \c memory_scope.
+   Memory that is not allocated in any scope is charged to the category "other".
+   The category is recorded in each block, and the block is credited back to the same category when it
+   is released, no matter which thread or subsystem releases it. Thus, the scope only needs to be set
+   where the objects of a subsystem are created.
+
+   Categories are only available when Lean is compiled with LEAN_TRACK_MEMORY_CATEGORIES
+   (CMake option TRACK_MEMORY_CATEGORIES, off by default). The category of each block is stored in a
+   header of 16 bytes, and every allocation updates the counters of the current thread.
+   Without it, only the total amount of memory is tracked (LEAN_TRACK_MEMORY).
+*/
+typedef unsigned memory_category;
+/** \brief Register a new category. This function should only be invoked by the initialize_* procedures. */
+memory_category register_memory_category(char const * name);
+
+extern LEAN_THREAD_LOCAL memory_category g_memory_category;
+
+/** \brief Charge the memory allocated by this thread to \c c while this object is alive. */
+class memory_scope {
+#if defined(LEAN_TRACK_MEMORY_CATEGORIES)
+    memory_category m_old;
+public:
+    memory_scope(memory_category c):m_old(g_memory_category) { g_memory_category = c; }
+    ~memory_scope() { g_memory_category = m_old; }
+#else
+public:
+    memory_scope(memory_category) {}
+#endif
+};
+
+struct memory_category_stats {
+    char const * m_name;
+    int64        m_allocated; // bytes allocated in the category
+    int64        m_freed;     // bytes released in the category
+    int64 live() const { return m_allocated - m_freed; }
+};
+/** \brief Return the memory accounted for each category (including threads that have already finished). */
+std::vector<memory_category_stats> get_memory_category_stats();
+void display_memory_category_stats(std::ostream & out);
 }
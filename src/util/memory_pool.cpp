@@ -5,24 +5,130 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <vector>
+#include <iomanip>
 #include "util/thread.h"
+#include "util/debug.h"
 #include "util/memory_pool.h"
+#include "util/stats.h"
+
+#ifndef LEAN_MEMORY_DEPOT_MAX_CELL_SIZE
+#define LEAN_MEMORY_DEPOT_MAX_CELL_SIZE 512
+#endif
+
+#ifndef LEAN_MEMORY_DEPOT_MAX_BATCHES
+#define LEAN_MEMORY_DEPOT_MAX_BATCHES 1024
+#endif
 
 namespace lean {
-memory_pool::~memory_pool() {
-    while (m_free_list != nullptr) {
-        void * r = m_free_list;
-        m_free_list = *(reinterpret_cast<void **>(r));
+static stat_counter g_pool_mallocs;
+static stat_counter g_pool_bytes;
+static stat_counter g_pool_released_batches;
+static stat_counter g_pool_reused_batches;
+
+/** \brief Free cells of a given size shared by all threads. The free cells are stored in batches of
+    LEAN_MEMORY_POOL_BATCH cells. Each batch is a linked list (the first word of a free cell is a pointer to the next one). */
+struct memory_depot {
+    mutex              m_mutex;
+    std::vector<void*> m_batches;
+    atomic<unsigned>   m_num_batches; // m_batches.size(), it allows us to skip the lock when the depot is empty
+    atomic<uint64>     m_num_cells;   // number of cells allocated using malloc and not released yet
+    memory_depot():m_num_batches(0), m_num_cells(0) {}
+};
+
+static unsigned const g_num_depots = LEAN_MEMORY_DEPOT_MAX_CELL_SIZE / sizeof(void*) + 1; // NOLINT
+static memory_depot * g_depots     = nullptr;
+
+static memory_depot * get_depot(unsigned sz) {
+    if (g_depots == nullptr || sz > LEAN_MEMORY_DEPOT_MAX_CELL_SIZE || sz % sizeof(void*) != 0) // NOLINT
+        return nullptr;
+    return &g_depots[sz / sizeof(void*)]; // NOLINT
+}
+
+static void * & next_cell(void * c) {
+    return *(reinterpret_cast<void **>(c));
+}
+
+static void free_cells(void * l, memory_depot * d) {
+    while (l != nullptr) {
+        void * r = l;
+        l = next_cell(r);
         free(r);
+        if (d)
+            atomic_fetch_sub_explicit(&d->m_num_cells, static_cast<uint64>(1), memory_order_relaxed);
+    }
+}
+
+/** \brief Store the batch \c b in \c d. Return false if the depot is full. */
+static bool push_batch(memory_depot * d, void * b) {
+    lock_guard<mutex> lock(d->m_mutex);
+    if (d->m_batches.size() >= LEAN_MEMORY_DEPOT_MAX_BATCHES)
+        return false;
+    d->m_batches.push_back(b);
+    d->m_num_batches.store(d->m_batches.size());
+    inc_stat(g_pool_released_batches);
+    return true;
+}
+
+static void * pop_batch(memory_depot * d) {
+    if (atomic_load(&d->m_num_batches) == 0)
+        return nullptr;
+    lock_guard<mutex> lock(d->m_mutex);
+    if (d->m_batches.empty())
+        return nullptr;
+    void * b = d->m_batches.back();
+    d->m_batches.pop_back();
+    d->m_num_batches.store(d->m_batches.size());
+    inc_stat(g_pool_reused_batches);
+    return b;
+}
+
+memory_pool::~memory_pool() {
+    memory_depot * d = get_depot(m_size);
+    if (d) {
+        // return the complete batches to the depot
+        while (m_num_free >= LEAN_MEMORY_POOL_BATCH)
+            release_batch();
+    }
+    free_cells(m_free_list, d);
+}
+
+void memory_pool::release_batch() {
+    lean_assert(m_num_free >= LEAN_MEMORY_POOL_BATCH);
+    void * b    = m_free_list;
+    void * last = b;
+    for (unsigned i = 1; i < LEAN_MEMORY_POOL_BATCH; i++)
+        last = next_cell(last);
+    m_free_list     = next_cell(last);
+    m_num_free     -= LEAN_MEMORY_POOL_BATCH;
+    next_cell(last) = nullptr;
+    memory_depot * d = get_depot(m_size);
+    if (!d || !push_batch(d, b)) {
+        // there is no depot for this cell size or it is full, then we return the memory to the system
+        free_cells(b, d);
     }
 }
 
 void * memory_pool::allocate() {
+    memory_depot * d = nullptr;
+    if (m_free_list == nullptr) {
+        d = get_depot(m_size);
+        if (d) {
+            if (void * b = pop_batch(d)) {
+                m_free_list = b;
+                m_num_free  = LEAN_MEMORY_POOL_BATCH;
+            }
+        }
+    }
     if (m_free_list != nullptr) {
         void * r = m_free_list;
-        m_free_list = *(reinterpret_cast<void **>(r));
+        m_free_list = next_cell(r);
+        m_num_free--;
         return r;
     } else {
+        inc_stat(g_pool_mallocs);
+        add_stat(g_pool_bytes, m_size);
+        if (d)
+            atomic_fetch_add_explicit(&d->m_num_cells, static_cast<uint64>(1), memory_order_relaxed);
         return malloc(m_size);
     }
 }
@@ -50,4 +156,50 @@ memory_pool * allocate_thread_memory_pool(unsigned sz) {
     g_thread_pools->push_back(r);
     return r;
 }
+
+std::vector<memory_pool_stats> get_memory_pool_stats() {
+    std::vector<memory_pool_stats> r;
+    if (!g_depots)
+        return r;
+    for (unsigned i = 0; i < g_num_depots; i++) {
+        memory_depot & d = g_depots[i];
+        uint64 num_cells = atomic_load(&d.m_num_cells);
+        if (num_cells == 0)
+            continue;
+        memory_pool_stats s;
+        s.m_cell_size       = i * sizeof(void*); // NOLINT
+        s.m_num_cells       = num_cells;
+        s.m_num_depot_cells = static_cast<uint64>(atomic_load(&d.m_num_batches)) * LEAN_MEMORY_POOL_BATCH;
+        r.push_back(s);
+    }
+    return r;
+}
+
+void display_memory_pool_stats(std::ostream & out) {
+    std::ios_base::fmtflags flags = out.flags();
+    out << "memory pools\n";
+    out << " cell size       cells  depot cells       bytes\n";
+    for (memory_pool_stats const & s : get_memory_pool_stats()) {
+        out << std::right << std::setw(10) << s.m_cell_size << std::setw(12) << s.m_num_cells
+            << std::setw(13) << s.m_num_depot_cells << std::setw(12) << s.m_num_cells * s.m_cell_size << "\n";
+    }
+    out.flags(flags);
+}
+
+void initialize_memory_pool() {
+    g_pool_mallocs          = register_stat_counter("memory pool growth (cells)");
+    g_pool_bytes            = register_stat_counter("memory pool growth (bytes)");
+    g_pool_released_batches = register_stat_counter("memory pool batches moved to depot");
+    g_pool_reused_batches   = register_stat_counter("memory pool batches taken from depot");
+    g_depots                = new memory_depot[g_num_depots];
+}
+
+void finalize_memory_pool() {
+    for (unsigned i = 0; i < g_num_depots; i++) {
+        for (void * b : g_depots[i].m_batches)
+            free_cells(b, nullptr);
+    }
+    delete[] g_depots;
+    g_depots = nullptr;
+}
 }
@@ -5,20 +5,41 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <iostream>
+#include <vector>
 #include "util/memory.h"
+#include "util/int64.h"
+
+#ifndef LEAN_MEMORY_POOL_BATCH
+#define LEAN_MEMORY_POOL_BATCH 256
+#endif
 
 namespace lean {
-/** \brief Auxiliary object for "recycling" allocated memory of fixed size */
+/**
+   \brief Auxiliary object for "recycling" allocated memory of fixed size.
+
+   Each thread has its own pools, but a cell allocated by one thread may be recycled by another one
+   (e.g., a theorem checked by a worker thread is deleted by the main thread). To prevent the pool
+   of one thread from growing without bound while the pool of another thread keeps invoking malloc,
+   a pool containing more than 2*LEAN_MEMORY_POOL_BATCH free cells moves LEAN_MEMORY_POOL_BATCH of them
+   to a global depot shared by all pools of the same cell size. A pool with an empty free list takes a batch
+   from the depot before invoking malloc.
+*/
 class memory_pool {
     unsigned m_size;
     void *   m_free_list;
+    unsigned m_num_free; // number of cells in m_free_list
+    void release_batch();
 public:
-    memory_pool(unsigned size):m_size(size), m_free_list(nullptr) {}
+    memory_pool(unsigned size):m_size(size), m_free_list(nullptr), m_num_free(0) {}
     ~memory_pool();
     void * allocate();
     void recycle(void * ptr) {
         *(reinterpret_cast<void**>(ptr)) = m_free_list;
         m_free_list = ptr;
+        m_num_free++;
+        if (m_num_free > 2*LEAN_MEMORY_POOL_BATCH)
+            release_batch();
     }
 };
 
@@ -31,4 +52,17 @@ memory_pool & NAME() {                                          \
         NAME ## _tlocal = allocate_thread_memory_pool(SZ);      \
     return *(NAME ## _tlocal);                                  \
 }
+
+/** \brief Occupancy of the memory pools for cells of a given size. */
+struct memory_pool_stats {
+    unsigned m_cell_size;
+    uint64   m_num_cells;       // number of cells allocated using malloc and not released yet
+    uint64   m_num_depot_cells; // number of free cells in the global depot
+};
+/** \brief Return the occupancy of the memory pools. Only cell sizes with allocated cells are included. */
+std::vector<memory_pool_stats> get_memory_pool_stats();
+void display_memory_pool_stats(std::ostream & out);
+
+void initialize_memory_pool();
+void finalize_memory_pool();
 }
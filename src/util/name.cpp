@@ -16,6 +16,7 @@ Author: Leonardo de Moura
 #include "util/rc.h"
 #include "util/buffer.h"
 #include "util/memory_pool.h"
+#include "util/memory.h"
 #include "util/hash.h"
 #include "util/trace.h"
 #include "util/ascii.h"
@@ -26,9 +27,10 @@ namespace lean {
 constexpr char const * anonymous_str = "[anonymous]";
 /** \brief Actual implementation of hierarchical names. */
 struct name::imp {
-    MK_LEAN_RC()
+    MK_LEAN_BIASED_RC(imp)
     bool     m_is_string;
     unsigned m_hash;
+    uint64   m_hash64; // 64-bit hash code, it is used to compute expr_cell::hash64
     imp *    m_prefix;
     union {
         char * m_str;
@@ -37,7 +39,7 @@ struct name::imp {
 
     void dealloc();
 
-    imp(bool s, imp * p):m_rc(1), m_is_string(s), m_hash(0), m_prefix(p) { if (p) p->inc_ref(); }
+    imp(bool s, imp * p):m_rc(1), m_is_string(s), m_hash(0), m_hash64(0), m_prefix(p) { if (p) p->inc_ref(); }
 
     static void display_core(std::ostream & out, imp * p, char const * sep) {
         lean_assert(p != nullptr);
@@ -69,6 +71,7 @@ struct name::imp {
 };
 
 DEF_THREAD_MEMORY_POOL(get_numeric_name_allocator, sizeof(name::imp));
+static memory_category g_name_memory = 0;
 
 void name::imp::dealloc() {
     imp * curr = this;
@@ -98,23 +101,33 @@ name::name() {
 name::name(name const & prefix, char const * name) {
     size_t sz  = strlen(name);
     lean_assert(sz < (1u << 31));
+    memory_scope scope(g_name_memory);
     char * mem = new char[sizeof(imp) + sz + 1];
     m_ptr      = new (mem) imp(true, prefix.m_ptr);
     std::memcpy(mem + sizeof(imp), name, sz + 1);
     m_ptr->m_str       = mem + sizeof(imp);
-    if (m_ptr->m_prefix)
-        m_ptr->m_hash = hash_str(sz, name, m_ptr->m_prefix->m_hash);
-    else
-        m_ptr->m_hash = hash_str(sz, name, 0);
+    if (m_ptr->m_prefix) {
+        m_ptr->m_hash   = hash_str(sz, name, m_ptr->m_prefix->m_hash);
+        m_ptr->m_hash64 = ::lean::hash64(name, sz, m_ptr->m_prefix->m_hash64);
+    } else {
+        m_ptr->m_hash   = hash_str(sz, name, 0);
+        m_ptr->m_hash64 = ::lean::hash64(name, sz, 11);
+    }
 }
 
 name::name(name const & prefix, unsigned k, bool) {
-    m_ptr      = new (get_numeric_name_allocator().allocate()) imp(false, prefix.m_ptr);
+    {
+        memory_scope scope(g_name_memory);
+        m_ptr  = new (get_numeric_name_allocator().allocate()) imp(false, prefix.m_ptr);
+    }
     m_ptr->m_k = k;
-    if (m_ptr->m_prefix)
-        m_ptr->m_hash = ::lean::hash(m_ptr->m_prefix->m_hash, k);
-    else
-        m_ptr->m_hash = k;
+    if (m_ptr->m_prefix) {
+        m_ptr->m_hash   = ::lean::hash(m_ptr->m_prefix->m_hash, k);
+        m_ptr->m_hash64 = ::lean::hash64(m_ptr->m_prefix->m_hash64 ^ 1, k);
+    } else {
+        m_ptr->m_hash   = k;
+        m_ptr->m_hash64 = ::lean::hash64(11 ^ 1, k);
+    }
 }
 
 name::name(name const & prefix, unsigned k):name(prefix, k, true) {
@@ -322,6 +335,10 @@ unsigned name::hash() const {
     return m_ptr ? m_ptr->m_hash : 11;
 }
 
+uint64 name::hash64() const {
+    return m_ptr ? m_ptr->m_hash64 : 11;
+}
+
 bool name::is_safe_ascii() const {
     imp * i       = m_ptr;
     while (i) {
@@ -441,8 +458,21 @@ name_ll_kind ll_kind(name const & n) {
 
 class name_serializer : public object_serializer<name, name::ptr_hash, name::ptr_eq> {
     typedef object_serializer<name, name::ptr_hash, name::ptr_eq> super;
+    shared_name_table const * m_shared;
 public:
+    name_serializer():m_shared(nullptr) {}
+    void set_shared(shared_name_table const & t) {
+        set_num_shared(t.size());
+        m_shared = &t;
+    }
     void write(name const & n) {
+        if (m_shared) {
+            auto it = m_shared->find(n);
+            if (it != m_shared->end()) {
+                write_ref(it->second);
+                return;
+            }
+        }
         name_ll_kind k = ll_kind(n);
         super::write_core(n, k, [&]() {
                 serializer & s = get_owner();
@@ -500,6 +530,14 @@ name read_name(deserializer & d) {
     return d.get_extension<name_deserializer>(g_name_sd->m_deserializer_extid).read();
 }
 
+void set_shared_names(serializer & s, shared_name_table const & t) {
+    s.get_extension<name_serializer>(g_name_sd->m_serializer_extid).set_shared(t);
+}
+
+void set_shared_names(deserializer & d, std::vector<name> const & t) {
+    d.get_extension<name_deserializer>(g_name_sd->m_deserializer_extid).set_shared(t);
+}
+
 DECL_UDATA(name)
 
 static int mk_name(lua_State * L) {
@@ -628,6 +666,7 @@ void open_name(lua_State * L) {
 }
 
 void initialize_name() {
+    g_name_memory = register_memory_category("names");
     g_anonymous = new name();
     g_name_sd   = new name_sd();
     g_next_id   = new atomic<unsigned>(0);
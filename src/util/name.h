@@ -6,6 +6,8 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <iostream>
 #include <functional>
 #include <algorithm>
@@ -101,6 +103,9 @@ public:
     /** \brief Size of the this name (in characters). */
     size_t size() const;
     unsigned hash() const;
+    /** \brief 64-bit hash code. Remark: it is not an extension of \c hash, names with the same
+        32-bit hash code usually have different 64-bit hash codes. */
+    uint64 hash64() const;
     /** \brief Return true iff the name contains only safe ASCII chars */
     bool is_safe_ascii() const;
     friend std::ostream & operator<<(std::ostream & out, name const & n);
@@ -190,6 +195,16 @@ serializer & operator<<(serializer & s, name const & n);
 name read_name(deserializer & d);
 inline deserializer & operator>>(deserializer & d, name & n) { n = read_name(d); return d; }
 
+/** \brief Names shared by several streams (e.g., the declarations stored in an .olean file),
+    and their positions. \see set_shared_names */
+typedef std::unordered_map<name, unsigned, name_hash, name_eq> shared_name_table;
+/** \brief The names stored in \c t are written by \c s as references to their positions.
+    \pre No name has been written to \c s, and \c t is alive while \c s is used. */
+void set_shared_names(serializer & s, shared_name_table const & t);
+/** \brief Set the table used to read the names written using set_shared_names(serializer &, shared_name_table const &).
+    The position of each name in \c t must be the one used when it was written. */
+void set_shared_names(deserializer & d, std::vector<name> const & t);
+
 UDATA_DEFS(name)
 name to_name_ext(lua_State * L, int idx);
 optional<name> to_optional_name(lua_State * L, int idx);
@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #pragma once
 #include <unordered_map>
 #include <vector>
+#include "util/debug.h"
 #include "util/serializer.h"
 
 #ifndef LEAN_OBJECT_SERIALIZER_BUCKET_SIZE
@@ -18,8 +19,10 @@ namespace lean {
 template<class T, class HashFn, class EqFn>
 class object_serializer : public serializer::extension {
     std::unordered_map<T, unsigned, HashFn, EqFn> m_table;
+    unsigned m_num_shared; // the first m_num_shared indices are used by a shared table (\see set_num_shared)
 public:
-    object_serializer(HashFn const & h = HashFn(), EqFn const & e = EqFn()):m_table(LEAN_OBJECT_SERIALIZER_BUCKET_SIZE, h, e) {}
+    object_serializer(HashFn const & h = HashFn(), EqFn const & e = EqFn()):
+        m_table(LEAN_OBJECT_SERIALIZER_BUCKET_SIZE, h, e), m_num_shared(0) {}
 
     template<typename F>
     void write_core(T const & v, char k, F && f) {
@@ -28,13 +31,27 @@ public:
         if (it == m_table.end()) {
             s.write_char(k + 1);
             f();
-            m_table.insert(std::make_pair(v, m_table.size()));
+            m_table.insert(std::make_pair(v, m_num_shared + m_table.size()));
         } else {
-            s.write_char(0);
-            s.write_unsigned(it->second);
+            write_ref(it->second);
         }
     }
 
+    /** \brief Write a reference to the object at position \c idx. */
+    void write_ref(unsigned idx) {
+        serializer & s = get_owner();
+        s.write_char(0);
+        s.write_unsigned(idx);
+    }
+
+    /** \brief Reserve the first \c n indices for objects stored in a table shared by several streams
+        (e.g., the names used by the declarations of an .olean file). They are written using \c write_ref,
+        and the deserializer must be given the same table (\see object_deserializer::set_shared). */
+    void set_num_shared(unsigned n) {
+        lean_assert(m_table.empty());
+        m_num_shared = n;
+    }
+
     template<typename F>
     void write(T const & v, F && f) {
         write_core(v, 0, f);
@@ -44,8 +61,11 @@ public:
 /** \brief Helper class for deserializing objects. */
 template<class T>
 class object_deserializer : public deserializer::extension {
-    std::vector<T> m_table;
+    std::vector<T>         m_table;
+    std::vector<T> const * m_shared; // objects stored in a shared table, \see object_serializer::set_num_shared
 public:
+    object_deserializer():m_shared(nullptr) {}
+
     template<typename F>
     T read_core(F && f) {
         deserializer & d = get_owner();
@@ -56,12 +76,23 @@ public:
             return r;
         } else {
             unsigned i = d.read_unsigned();
+            if (m_shared) {
+                if (i < m_shared->size())
+                    return (*m_shared)[i];
+                i -= m_shared->size();
+            }
             if (i >= m_table.size())
                 throw corrupted_stream_exception();
             return m_table[i];
         }
     }
 
+    /** \brief Use \c t as the shared table, the object must be alive while this deserializer is used. */
+    void set_shared(std::vector<T> const & t) {
+        lean_assert(m_table.empty());
+        m_shared = &t;
+    }
+
     template<typename F>
     T read(F && f) {
         return read_core([&](char ) { return f(); });
@@ -27,6 +27,26 @@ bool dec_ref_core() {                                                   \
 }                                                                       \
 void dec_ref() { if (dec_ref_core()) { dealloc(); } }
 
+#if defined(LEAN_BIASED_RC)
+#include "util/biased_rc.h"
+// Reference counter for objects of type T that are usually created, copied and deleted by the same thread.
+// See biased_rc. T must provide the method dealloc.
+#define MK_LEAN_BIASED_RC(T)                                            \
+private:                                                                \
+biased_rc m_rc;                                                         \
+static void rc_merge(void * o) {                                        \
+    T * t = static_cast<T*>(o);                                         \
+    if (t->m_rc.merge()) { t->dealloc(); }                              \
+}                                                                       \
+public:                                                                 \
+unsigned get_rc() const { return m_rc.get(); }                          \
+void inc_ref() { m_rc.inc(); }                                          \
+bool dec_ref_core() { return m_rc.dec(this, rc_merge); }                \
+void dec_ref() { if (dec_ref_core()) { dealloc(); } }
+#else
+#define MK_LEAN_BIASED_RC(T) MK_LEAN_RC()
+#endif
+
 #define LEAN_COPY_REF(Arg)                      \
     if (Arg.m_ptr)                              \
         Arg.m_ptr->inc_ref();                   \
@@ -0,0 +1,173 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <vector>
+#include "util/debug.h"
+#include "util/int64.h"
+#include "util/memory.h"
+#include "util/stats.h"
+#include "util/region.h"
+
+namespace lean {
+static stat_counter g_region_stat;
+static stat_counter g_region_cell_stat;
+static stat_counter g_region_bytes_stat;
+static stat_counter g_region_pinned_stat;
+static stat_counter g_region_exhausted_stat;
+
+class region {
+    unsigned           m_id;
+    std::vector<void*> m_chunks;
+    char *             m_next;
+    char *             m_end;
+    int64              m_num_cells; // number of allocated cells, only updated by the thread that owns the region
+    int64              m_owner_deleted; // number of cells deleted by the owner thread while the region is open
+    // While the region is open, it is the number of cells deleted by other threads (as a negative value),
+    // and the number of live cells after it has been closed.
+    atomic<int64>      m_live;
+public:
+    region(unsigned id):m_id(id), m_next(nullptr), m_end(nullptr), m_num_cells(0), m_owner_deleted(0), m_live(0) {}
+    ~region() {
+        for (void * c : m_chunks)
+            lean::free(c);
+    }
+    unsigned id() const { return m_id; }
+    void * allocate(unsigned sz) {
+        sz = (sz + sizeof(void*) - 1) & ~static_cast<unsigned>(sizeof(void*) - 1); // NOLINT
+        lean_assert(sz <= LEAN_REGION_CHUNK_SIZE);
+        if (m_next + sz > m_end) {
+            m_next = static_cast<char*>(lean::malloc(LEAN_REGION_CHUNK_SIZE));
+            m_end  = m_next + LEAN_REGION_CHUNK_SIZE;
+            m_chunks.push_back(m_next);
+            add_stat(g_region_bytes_stat, LEAN_REGION_CHUNK_SIZE);
+        }
+        void * r = m_next;
+        m_next  += sz;
+        m_num_cells++;
+        return r;
+    }
+    /** \brief Record that a cell has been deleted by the owner thread while the region is open.
+        It does not need synchronization, most of the scratch cells are deleted this way. */
+    void recycle_owner() { m_owner_deleted++; }
+    /** \brief Return true if all cells have been deleted. */
+    bool close() {
+        add_stat(g_region_cell_stat, m_num_cells);
+        int64 n = m_num_cells - m_owner_deleted;
+        return atomic_fetch_add_explicit(&m_live, n, memory_order_acq_rel) + n == 0;
+    }
+    /** \brief Return true if the region has been closed, and the deleted cell was its last one. */
+    bool recycle() {
+        return atomic_fetch_sub_explicit(&m_live, static_cast<int64>(1), memory_order_acq_rel) == 1;
+    }
+};
+
+bool g_regions_enabled = false;
+static mutex *                 g_region_mutex = nullptr;
+static std::vector<unsigned> * g_free_region_ids = nullptr;
+static unsigned                g_next_region_id = 1;
+static atomic<region*>         g_regions[LEAN_MAX_REGIONS];
+LEAN_THREAD_PTR(region, g_region);
+
+void enable_regions(bool flag) {
+    g_regions_enabled = flag;
+}
+
+static region * mk_region() {
+    lock_guard<mutex> lock(*g_region_mutex);
+    unsigned id;
+    if (!g_free_region_ids->empty()) {
+        id = g_free_region_ids->back();
+        g_free_region_ids->pop_back();
+    } else if (g_next_region_id < LEAN_MAX_REGIONS) {
+        id = g_next_region_id;
+        g_next_region_id++;
+    } else {
+        return nullptr; // too many regions are alive
+    }
+    region * r = new region(id);
+    g_regions[id].store(r);
+    inc_stat(g_region_stat);
+    return r;
+}
+
+static void del_region(region * r) {
+    unsigned id = r->id();
+    delete r;
+    if (!g_region_mutex)
+        return; // module has already been finalized
+    lock_guard<mutex> lock(*g_region_mutex);
+    g_regions[id].store(nullptr);
+    g_free_region_ids->push_back(id);
+}
+
+unsigned get_region_id() {
+    return g_region ? g_region->id() : 0;
+}
+
+void * region_allocate(unsigned sz) {
+    lean_assert(g_region);
+    return g_region->allocate(sz);
+}
+
+void region_recycle(unsigned id) {
+    if (g_region && g_region->id() == id) {
+        // the current region of this thread is open
+        g_region->recycle_owner();
+        return;
+    }
+    region * r = g_regions[id].load();
+    lean_assert(r);
+    if (r->recycle())
+        del_region(r);
+}
+
+region_scope::region_scope(bool use_region):m_old(g_region), m_region(nullptr) {
+    if (use_region && g_regions_enabled && g_region_mutex) {
+        m_region = mk_region();
+        if (m_region)
+            g_region = m_region;
+        else
+            inc_stat(g_region_exhausted_stat);
+    }
+}
+
+region_scope::~region_scope() {
+    if (m_region) {
+        g_region = m_old;
+        if (m_region->close())
+            del_region(m_region);
+        else
+            inc_stat(g_region_pinned_stat);
+    }
+}
+
+no_region_scope::no_region_scope():m_old(g_region) {
+    g_region = nullptr;
+}
+
+no_region_scope::~no_region_scope() {
+    g_region = m_old;
+}
+
+void initialize_region() {
+    g_region_mutex          = new mutex();
+    g_free_region_ids       = new std::vector<unsigned>();
+    g_region_stat           = register_stat_counter("regions");
+    g_region_cell_stat      = register_stat_counter("region cells");
+    g_region_bytes_stat     = register_stat_counter("region bytes");
+    g_region_pinned_stat    = register_stat_counter("regions alive after their scope");
+    g_region_exhausted_stat = register_stat_counter("region scopes without region (too many alive)");
+}
+
+void finalize_region() {
+    // Remark: regions that are still alive are not deleted since some of their cells may be
+    // deleted later (e.g., by static destructors).
+    delete g_free_region_ids;
+    delete g_region_mutex;
+    g_free_region_ids = nullptr;
+    g_region_mutex    = nullptr;
+}
+}
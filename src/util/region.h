@@ -0,0 +1,66 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include "util/thread.h"
+
+#ifndef LEAN_MAX_REGIONS
+#define LEAN_MAX_REGIONS 4096
+#endif
+
+#ifndef LEAN_REGION_CHUNK_SIZE
+#define LEAN_REGION_CHUNK_SIZE (64*1024)
+#endif
+
+namespace lean {
+/**
+   \brief Regions are bump allocators for short lived cells (e.g., the terms created when elaborating a declaration).
+
+   A cell allocated in a region is not recycled individually: deleting it only decrements the number of
+   live cells of its region, and the memory of the whole region is released when the region has been closed
+   and all its cells have been deleted. Thus, cells that escape the scope of the region (e.g., they are stored
+   in a cache) are still valid, but they keep the region alive. To avoid that, the objects that must survive
+   should be copied out of the region before it is closed (see \c copy_out_of_region in kernel/expr.h).
+
+   Each region has an identifier in <tt>[1, LEAN_MAX_REGIONS)</tt>, and the identifier is stored in the cell.
+   Cells are allocated in the current region of the thread. Cells may be deleted by any thread.
+*/
+class region;
+
+extern bool g_regions_enabled;
+/** \brief Enable/disable regions. When they are disabled (default), \c region_scope does not create regions. */
+void enable_regions(bool flag);
+inline bool regions_enabled() { return g_regions_enabled; }
+
+/** \brief Return the identifier of the current region of this thread, 0 if there is none. */
+unsigned get_region_id();
+/** \brief Allocate \c sz bytes in the current region.
+    \pre get_region_id() != 0 */
+void * region_allocate(unsigned sz);
+/** \brief Notify the region \c id that one of its cells has been deleted. */
+void region_recycle(unsigned id);
+
+/** \brief Create a new region (if regions are enabled and \c use_region is true), and make it the current region
+    until the scope is destroyed. Remark: no region is created if LEAN_MAX_REGIONS regions are alive. */
+class region_scope {
+    region * m_old;
+    region * m_region;
+public:
+    region_scope(bool use_region = true);
+    ~region_scope();
+};
+
+/** \brief Cells are not allocated in regions while this object is alive. */
+class no_region_scope {
+    region * m_old;
+public:
+    no_region_scope();
+    ~no_region_scope();
+};
+
+void initialize_region();
+void finalize_region();
+}
@@ -21,6 +21,7 @@ Author: Leonardo de Moura
 #include "util/name_set.h"
 #include "util/rb_map.h"
 #include "util/lean_path.h"
+#include "util/stats.h"
 
 extern "C" void * lua_realloc(void *, void * q, size_t, size_t new_size) { return lean::realloc(q, new_size); }
 
@@ -99,6 +100,7 @@ struct script_state::imp {
         open_name_set(m_state);
         open_rb_map(m_state);
         open_extra(m_state);
+        open_stats(m_state);
 
         for (auto f : *g_modules) {
             f(m_state);
@@ -22,12 +22,11 @@ void finalize_serializer() {
     serializer::finalize();
 }
 
-void serializer_core::write_unsigned(unsigned i) {
-    static_assert(sizeof(i) == 4, "unexpected unsigned size");
-    m_out.put((i >> 24) & 0xff);
-    m_out.put((i >> 16) & 0xff);
-    m_out.put((i >> 8) & 0xff);
-    m_out.put(i & 0xff);
+void serializer_core::write_unsigned_core(unsigned i) {
+    m_out->put((i >> 24) & 0xff);
+    m_out->put((i >> 16) & 0xff);
+    m_out->put((i >> 8) & 0xff);
+    m_out->put(i & 0xff);
 }
 
 void serializer_core::write_uint64(uint64 i) {
@@ -57,26 +56,26 @@ void serializer_core::write_double(double d) {
     write_string(out.str());
 }
 
-std::string deserializer_core::read_string() {
+std::string deserializer_core::read_string_core() {
     std::string r;
     while (true) {
-        char c = m_in.get();
+        int c = get();
         if (c == 0)
             break;
         if (c == EOF)
             throw corrupted_stream_exception();
-        r += c;
+        r += static_cast<char>(c);
     }
     return r;
 }
 
-unsigned deserializer_core::read_unsigned() {
+unsigned deserializer_core::read_unsigned_core() {
     unsigned r;
     static_assert(sizeof(r) == 4, "unexpected unsigned size");
-    r  = static_cast<unsigned>(m_in.get()) << 24;
-    r |= static_cast<unsigned>(m_in.get()) << 16;
-    r |= static_cast<unsigned>(m_in.get()) << 8;
-    r |= static_cast<unsigned>(m_in.get());
+    r  = static_cast<unsigned>(get()) << 24;
+    r |= static_cast<unsigned>(get()) << 16;
+    r |= static_cast<unsigned>(get()) << 8;
+    r |= static_cast<unsigned>(get());
     return r;
 }
 
@@ -92,6 +91,15 @@ int deserializer_core::read_int() {
     return read_unsigned();
 }
 
+char const * deserializer_core::read_block(size_t n) {
+    lean_assert(!m_in);
+    if (static_cast<size_t>(m_end - m_it) < n)
+        throw corrupted_stream_exception();
+    char const * r = m_it;
+    m_it += n;
+    return r;
+}
+
 double deserializer_core::read_double() {
     // TODO(Leo): use std::hexfloat as soon as it is supported by g++
     std::istringstream in(read_string());
@@ -9,6 +9,8 @@ Author: Leonardo de Moura
 #include <string>
 #include <sstream>
 #include <cstring>
+#include <cstdio>
+#include <vector>
 #include "util/extensible_object.h"
 #include "util/list.h"
 #include "util/buffer.h"
@@ -19,18 +21,51 @@ namespace lean {
 /**
    \brief Low-tech serializer.
    The actual functionality is implemented using extensions.
+
+   There are two backends: an output stream, and a contiguous growable buffer.
+   The buffer backend avoids the overhead of std::ostream::put for every character,
+   it should be used when large amounts of data are written (e.g., .olean files).
 */
 class serializer_core {
-    std::ostream & m_out;
+    std::ostream *      m_out;
+    // When m_out == nullptr, the data is appended to m_buffer
+    std::vector<char> * m_buffer;
+    void write_unsigned_core(unsigned i);
 public:
-    serializer_core(std::ostream & out):m_out(out) {}
-    void write_string(char const * str) { m_out.write(str, strlen(str) + 1); }
-    void write_string(std::string const & str) { m_out.write(str.c_str(), str.size() + 1); }
-    void write_unsigned(unsigned i);
+    serializer_core(std::ostream & out):m_out(&out), m_buffer(nullptr) {}
+    /** \brief Append the serialized data to the given buffer. */
+    serializer_core(std::vector<char> & buffer):m_out(nullptr), m_buffer(&buffer) {}
+    void write_block(char const * data, size_t n) {
+        if (m_buffer)
+            m_buffer->insert(m_buffer->end(), data, data + n);
+        else
+            m_out->write(data, n);
+    }
+    void write_string(char const * str) { write_block(str, strlen(str) + 1); }
+    void write_string(std::string const & str) { write_block(str.c_str(), str.size() + 1); }
+    void write_unsigned(unsigned i) {
+        static_assert(sizeof(i) == 4, "unexpected unsigned size");
+        if (m_buffer) {
+            size_t sz = m_buffer->size();
+            m_buffer->resize(sz + 4);
+            char * p = m_buffer->data() + sz;
+            p[0] = (i >> 24) & 0xff;
+            p[1] = (i >> 16) & 0xff;
+            p[2] = (i >> 8) & 0xff;
+            p[3] = i & 0xff;
+        } else {
+            write_unsigned_core(i);
+        }
+    }
     void write_uint64(uint64 i);
     void write_int(int i);
-    void write_char(char c) { m_out.put(c); }
-    void write_bool(bool b) { m_out.put(b ? 1 : 0); }
+    void write_char(char c) {
+        if (m_buffer)
+            m_buffer->push_back(c);
+        else
+            m_out->put(c);
+    }
+    void write_bool(bool b) { write_char(b ? 1 : 0); }
     void write_double(double b);
 };
 
@@ -50,16 +85,55 @@ inline serializer & operator<<(serializer & s, double b) { s.write_double(b); re
    The actual functionality is implemented using extensions.
 */
 class deserializer_core {
-    std::istream & m_in;
+    std::istream * m_in;
+    // When m_in == nullptr, the data is read from the memory range [m_it, m_end)
+    char const *   m_it;
+    char const *   m_end;
+    int get() {
+        if (m_in)
+            return m_in->get();
+        else if (m_it != m_end)
+            return static_cast<unsigned char>(*(m_it++));
+        else
+            return EOF;
+    }
+    std::string read_string_core();
+    unsigned read_unsigned_core();
 public:
-    deserializer_core(std::istream & in):m_in(in) {}
-    std::string read_string();
-    unsigned read_unsigned();
+    deserializer_core(std::istream & in):m_in(&in), m_it(nullptr), m_end(nullptr) {}
+    /** \brief Read directly from the memory range [begin, end) (e.g., a memory mapped file). No copy is performed. */
+    deserializer_core(char const * begin, char const * end):m_in(nullptr), m_it(begin), m_end(end) {}
+    std::string read_string() {
+        if (!m_in && m_it != m_end) {
+            char const * z = static_cast<char const *>(memchr(m_it, 0, m_end - m_it));
+            if (z) {
+                std::string r(m_it, z);
+                m_it = z + 1;
+                return r;
+            }
+        }
+        return read_string_core();
+    }
+    unsigned read_unsigned() {
+        if (!m_in && m_end - m_it >= 4) {
+            unsigned char const * p = reinterpret_cast<unsigned char const *>(m_it);
+            m_it += 4;
+            return
+                (static_cast<unsigned>(p[0]) << 24) |
+                (static_cast<unsigned>(p[1]) << 16) |
+                (static_cast<unsigned>(p[2]) << 8)  |
+                static_cast<unsigned>(p[3]);
+        }
+        return read_unsigned_core();
+    }
     uint64 read_uint64();
     int read_int();
-    char read_char() { return m_in.get(); }
-    bool read_bool() { return m_in.get() != 0; }
+    char read_char() { return get(); }
+    bool read_bool() { return get() != 0; }
     double read_double();
+    /** \brief Return a pointer to the next \c n bytes, and skip them.
+        \pre This deserializer reads from a memory range. */
+    char const * read_block(size_t n);
 };
 
 typedef extensible_object<deserializer_core> deserializer;
@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include "util/debug.h"
+#include "util/int64.h"
+#include "util/stats.h"
+
+#ifndef LEAN_CACHE_WAYS
+#define LEAN_CACHE_WAYS 4
+#endif
+
+namespace lean {
+/** \brief Bounded cache where each key can be stored in one of the LEAN_CACHE_WAYS entries of a set.
+    The set is selected using the hash code of the key, and when all entries of the set are used,
+    the least recently used one is evicted. This is much less sensitive to collisions than a direct-mapped
+    cache, and it is still cheap: a lookup inspects at most LEAN_CACHE_WAYS consecutive entries.
+
+    The type \c Entry must be default constructible, cheap to swap, and provide the methods
+    - <tt>bool is_empty() const</tt>
+    - <tt>void reset()</tt>: make the entry empty, and release the objects it references.
+
+    The number of hits, misses and evictions is tracked by each cache, and it is added to the
+    statistics counters provided in the constructor (if any) when the cache is cleared.
+*/
+template<typename Entry>
+class set_assoc_cache {
+    unsigned                    m_num_sets;
+    std::vector<Entry>          m_entries; // entries of each set are sorted from the most to the least recently used
+    std::vector<unsigned>       m_used;    // sets that contain at least one entry
+    cache_stat_counters const * m_counters;
+    uint64                      m_hits;
+    uint64                      m_misses;
+    uint64                      m_evictions;
+
+    Entry * get_set(unsigned h) { return m_entries.data() + (h % m_num_sets) * LEAN_CACHE_WAYS; }
+
+    /** \brief Move the i-th entry of the given set to the front. */
+    static void move_front(Entry * s, unsigned i) {
+        for (; i > 0; i--)
+            std::swap(s[i], s[i-1]);
+    }
+
+    /** \brief Return the position of the entry satisfying \c pred in the given set, or the number of used entries
+        if there is none. Remark: the used entries of a set are always at the beginning. */
+    template<typename Pred>
+    static unsigned find_core(Entry * s, Pred && pred, bool & found) {
+        unsigned i = 0;
+        for (; i < LEAN_CACHE_WAYS && !s[i].is_empty(); i++) {
+            if (pred(s[i])) {
+                found = true;
+                return i;
+            }
+        }
+        found = false;
+        return i;
+    }
+
+public:
+    /** \brief Create a cache with \c capacity entries. */
+    set_assoc_cache(unsigned capacity, cache_stat_counters const * counters = nullptr):
+        m_num_sets(std::max(capacity / LEAN_CACHE_WAYS, 1u)), m_entries(m_num_sets * LEAN_CACHE_WAYS),
+        m_counters(counters), m_hits(0), m_misses(0), m_evictions(0) {}
+
+    /** \brief Return the entry satisfying \c pred in the set selected by \c h, nullptr if there is none. */
+    template<typename Pred>
+    Entry * find(unsigned h, Pred && pred) {
+        Entry * s = get_set(h);
+        bool found;
+        unsigned i = find_core(s, pred, found);
+        if (found) {
+            m_hits++;
+            move_front(s, i);
+            return s;
+        } else {
+            m_misses++;
+            return nullptr;
+        }
+    }
+
+    /** \brief Return the entry that should be used to store the key satisfying \c pred in the set selected by \c h.
+        It is the entry already associated with the key, if there is one, and a new entry otherwise.
+        The least recently used entry of the set is evicted if the set is full. */
+    template<typename Pred>
+    Entry & insert(unsigned h, Pred && pred) {
+        Entry * s = get_set(h);
+        bool found;
+        unsigned i = find_core(s, pred, found);
+        if (!found) {
+            if (i == 0) {
+                m_used.push_back(h % m_num_sets);
+            } else if (i == LEAN_CACHE_WAYS) {
+                i--;
+                m_evictions++;
+            }
+        }
+        move_front(s, i);
+        return *s;
+    }
+
+    void clear() {
+        for (unsigned idx : m_used) {
+            Entry * s = m_entries.data() + idx * LEAN_CACHE_WAYS;
+            for (unsigned i = 0; i < LEAN_CACHE_WAYS && !s[i].is_empty(); i++)
+                s[i].reset();
+        }
+        m_used.clear();
+        if (m_counters) {
+            add_stat(m_counters->m_hit,      m_hits);
+            add_stat(m_counters->m_miss,     m_misses);
+            add_stat(m_counters->m_eviction, m_evictions);
+        }
+        m_hits = m_misses = m_evictions = 0;
+    }
+
+    unsigned capacity() const { return m_entries.size(); }
+    /** \brief Number of hits, misses and evictions since the last time the cache was cleared. */
+    uint64 hits() const { return m_hits; }
+    uint64 misses() const { return m_misses; }
+    uint64 evictions() const { return m_evictions; }
+};
+}
@@ -0,0 +1,259 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+#include <vector>
+#include <string>
+#include "util/thread.h"
+#include "util/debug.h"
+#include "util/exception.h"
+#include "util/stats.h"
+
+#ifndef LEAN_MAX_STAT_COUNTERS
+#define LEAN_MAX_STAT_COUNTERS 128
+#endif
+
+#ifndef LEAN_MAX_STAT_HISTOGRAMS
+#define LEAN_MAX_STAT_HISTOGRAMS 16
+#endif
+
+namespace lean {
+atomic<bool> g_stats_enabled(false);
+
+/** \brief Counters of a thread. The counters are atomic because they may be read by \c get_stats and
+    reset by \c reset_stats while the thread is running. Since there is no contention, the cost of
+    a relaxed atomic increment is small. */
+struct thread_stats {
+    atomic<uint64>        m_counters[LEAN_MAX_STAT_COUNTERS];
+    mutex                 m_mutex; // protects m_histograms
+    name_hash_map<uint64> m_histograms[LEAN_MAX_STAT_HISTOGRAMS];
+    thread_stats() { reset(); }
+    void reset() {
+        for (unsigned i = 0; i < LEAN_MAX_STAT_COUNTERS; i++)
+            m_counters[i].store(0);
+        lock_guard<mutex> lock(m_mutex);
+        for (unsigned i = 0; i < LEAN_MAX_STAT_HISTOGRAMS; i++)
+            m_histograms[i].clear();
+    }
+};
+
+struct stats_registry {
+    mutex                        m_mutex;
+    std::vector<std::string>     m_counter_descrs;
+    std::vector<std::string>     m_histogram_descrs;
+    std::vector<thread_stats *>  m_threads;  // counters of running threads
+    stats_snapshot               m_finished; // counters of threads that have already finished
+};
+
+static stats_registry * g_registry = nullptr;
+LEAN_THREAD_PTR(thread_stats, g_thread_stats);
+// True after the counters of this thread were moved to the registry. Post thread finalizers may still update
+// counters (e.g., memory pools returning their batches to the depot), they are added to the registry directly.
+LEAN_THREAD_VALUE(bool, g_thread_stats_finalized, false);
+
+static void add_to(stats_snapshot & s, thread_stats & t) {
+    for (unsigned i = 0; i < s.m_counters.size(); i++)
+        s.m_counters[i] += atomic_load(&t.m_counters[i]);
+    lock_guard<mutex> lock(t.m_mutex);
+    for (unsigned i = 0; i < s.m_histograms.size(); i++) {
+        for (auto const & p : t.m_histograms[i])
+            s.m_histograms[i][p.first] += p.second;
+    }
+}
+
+static void finalize_thread_stats() {
+    if (!g_thread_stats)
+        return;
+    if (g_registry) {
+        lock_guard<mutex> lock(g_registry->m_mutex);
+        add_to(g_registry->m_finished, *g_thread_stats);
+        auto & ts = g_registry->m_threads;
+        ts.erase(std::remove(ts.begin(), ts.end(), g_thread_stats), ts.end());
+    }
+    delete g_thread_stats;
+    g_thread_stats = nullptr;
+    g_thread_stats_finalized = true;
+}
+
+static thread_stats * get_thread_stats() {
+    if (!g_thread_stats) {
+        if (!g_registry || g_thread_stats_finalized)
+            return nullptr; // module has not been initialized, or the counters of this thread were finalized
+        g_thread_stats = new thread_stats();
+        register_thread_finalizer(finalize_thread_stats);
+        lock_guard<mutex> lock(g_registry->m_mutex);
+        g_registry->m_threads.push_back(g_thread_stats);
+    }
+    return g_thread_stats;
+}
+
+stat_counter register_stat_counter(char const * descr) {
+    lean_assert(g_registry);
+    lock_guard<mutex> lock(g_registry->m_mutex);
+    unsigned idx = g_registry->m_counter_descrs.size();
+    if (idx >= LEAN_MAX_STAT_COUNTERS)
+        throw exception("too many statistics counters, recompile Lean using a bigger LEAN_MAX_STAT_COUNTERS");
+    g_registry->m_counter_descrs.push_back(descr);
+    g_registry->m_finished.m_counters.push_back(0);
+    return stat_counter(idx);
+}
+
+cache_stat_counters register_cache_stat_counters(char const * descr) {
+    cache_stat_counters r;
+    r.m_hit      = register_stat_counter((std::string(descr) + " hits").c_str());
+    r.m_miss     = register_stat_counter((std::string(descr) + " misses").c_str());
+    r.m_eviction = register_stat_counter((std::string(descr) + " evictions").c_str());
+    return r;
+}
+
+stat_histogram register_stat_histogram(char const * descr) {
+    lean_assert(g_registry);
+    lock_guard<mutex> lock(g_registry->m_mutex);
+    unsigned idx = g_registry->m_histogram_descrs.size();
+    if (idx >= LEAN_MAX_STAT_HISTOGRAMS)
+        throw exception("too many statistics histograms, recompile Lean using a bigger LEAN_MAX_STAT_HISTOGRAMS");
+    g_registry->m_histogram_descrs.push_back(descr);
+    g_registry->m_finished.m_histograms.push_back(name_hash_map<uint64>());
+    return stat_histogram(idx);
+}
+
+void enable_stats(bool flag) {
+    g_stats_enabled = flag;
+}
+
+void add_stat_core(stat_counter c, uint64 n) {
+    if (thread_stats * t = get_thread_stats()) {
+        atomic_fetch_add_explicit(&t->m_counters[c.m_idx], n, memory_order_relaxed);
+    } else if (g_thread_stats_finalized && g_registry) {
+        lock_guard<mutex> lock(g_registry->m_mutex);
+        g_registry->m_finished.m_counters[c.m_idx] += n;
+    }
+}
+
+void inc_stat_core(stat_histogram h, name const & n) {
+    if (thread_stats * t = get_thread_stats()) {
+        lock_guard<mutex> lock(t->m_mutex);
+        t->m_histograms[h.m_idx][n]++;
+    } else if (g_thread_stats_finalized && g_registry) {
+        lock_guard<mutex> lock(g_registry->m_mutex);
+        g_registry->m_finished.m_histograms[h.m_idx][n]++;
+    }
+}
+
+uint64 stats_snapshot::get(stat_histogram h, name const & n) const {
+    auto it = m_histograms[h.m_idx].find(n);
+    return it == m_histograms[h.m_idx].end() ? 0 : it->second;
+}
+
+stats_snapshot get_stats() {
+    lock_guard<mutex> lock(g_registry->m_mutex);
+    stats_snapshot r = g_registry->m_finished;
+    for (thread_stats * t : g_registry->m_threads)
+        add_to(r, *t);
+    return r;
+}
+
+void reset_stats() {
+    lock_guard<mutex> lock(g_registry->m_mutex);
+    stats_snapshot & f = g_registry->m_finished;
+    std::fill(f.m_counters.begin(), f.m_counters.end(), 0);
+    for (auto & h : f.m_histograms)
+        h.clear();
+    for (thread_stats * t : g_registry->m_threads)
+        t->reset();
+}
+
+void display_stats(std::ostream & out, stats_snapshot const & s, unsigned max_entries) {
+    std::vector<std::string> counter_descrs, histogram_descrs;
+    {
+        lock_guard<mutex> lock(g_registry->m_mutex);
+        counter_descrs   = g_registry->m_counter_descrs;
+        histogram_descrs = g_registry->m_histogram_descrs;
+    }
+    std::ios_base::fmtflags flags = out.flags();
+    unsigned width = 0;
+    for (std::string const & d : counter_descrs)
+        width = std::max(width, static_cast<unsigned>(d.size()));
+    for (unsigned i = 0; i < s.m_counters.size(); i++) {
+        if (s.m_counters[i] != 0)
+            out << std::left << std::setw(width) << counter_descrs[i] << std::right
+                << std::setw(14) << s.m_counters[i] << "\n";
+    }
+    for (unsigned i = 0; i < s.m_histograms.size(); i++) {
+        name_hash_map<uint64> const & h = s.m_histograms[i];
+        if (h.empty())
+            continue;
+        std::vector<std::pair<name, uint64>> entries(h.begin(), h.end());
+        std::sort(entries.begin(), entries.end(), [](std::pair<name, uint64> const & p1, std::pair<name, uint64> const & p2) {
+                return p1.second > p2.second || (p1.second == p2.second && quick_cmp(p1.first, p2.first) < 0);
+            });
+        uint64 total = 0;
+        for (auto const & p : entries)
+            total += p.second;
+        out << histogram_descrs[i] << ", total: " << total << ", " << entries.size() << " distinct entries\n";
+        for (unsigned j = 0; j < entries.size() && j < max_entries; j++)
+            out << std::setw(14) << entries[j].second << "  " << entries[j].first << "\n";
+    }
+    out.flags(flags);
+}
+
+void display_stats(std::ostream & out) {
+    display_stats(out, get_stats());
+}
+
+static int get_stats(lua_State * L) {
+    stats_snapshot s = get_stats();
+    std::vector<std::string> counter_descrs, histogram_descrs;
+    {
+        lock_guard<mutex> lock(g_registry->m_mutex);
+        counter_descrs   = g_registry->m_counter_descrs;
+        histogram_descrs = g_registry->m_histogram_descrs;
+    }
+    lua_newtable(L);
+    for (unsigned i = 0; i < s.m_counters.size(); i++) {
+        lua_pushinteger(L, static_cast<lua_Integer>(s.m_counters[i]));
+        lua_setfield(L, -2, counter_descrs[i].c_str());
+    }
+    for (unsigned i = 0; i < s.m_histograms.size(); i++) {
+        lua_newtable(L);
+        for (auto const & p : s.m_histograms[i]) {
+            lua_pushinteger(L, static_cast<lua_Integer>(p.second));
+            lua_setfield(L, -2, p.first.to_string().c_str());
+        }
+        lua_setfield(L, -2, histogram_descrs[i].c_str());
+    }
+    return 1;
+}
+
+static int reset_stats(lua_State *) { // NOLINT
+    reset_stats();
+    return 0;
+}
+
+static int enable_stats(lua_State * L) {
+    enable_stats(lua_toboolean(L, 1));
+    return 0;
+}
+
+void open_stats(lua_State * L) {
+    SET_GLOBAL_FUN(get_stats,    "get_stats");
+    SET_GLOBAL_FUN(reset_stats,  "reset_stats");
+    SET_GLOBAL_FUN(enable_stats, "enable_stats");
+}
+
+void initialize_stats() {
+    g_registry = new stats_registry();
+}
+
+void finalize_stats() {
+    finalize_thread_stats();
+    // Remark: all other threads must have been finalized at this point.
+    delete g_registry;
+    g_registry = nullptr;
+}
+}
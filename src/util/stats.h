@@ -0,0 +1,85 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <iostream>
+#include <vector>
+#include <string>
+#include "util/int64.h"
+#include "util/thread.h"
+#include "util/name.h"
+#include "util/name_hash_map.h"
+#include "util/lua.h"
+
+namespace lean {
+/** \brief Counter created using \c register_stat_counter. */
+struct stat_counter {
+    unsigned m_idx;
+    stat_counter():m_idx(0) {}
+    explicit stat_counter(unsigned idx):m_idx(idx) {}
+};
+
+/** \brief Family of counters indexed by names (e.g., number of times each constant was unfolded).
+    It is created using \c register_stat_histogram. */
+struct stat_histogram {
+    unsigned m_idx;
+    stat_histogram():m_idx(0) {}
+    explicit stat_histogram(unsigned idx):m_idx(idx) {}
+};
+
+/** \brief Register a new counter with the given description.
+    This function should only be invoked by the initialize_* procedures. */
+stat_counter register_stat_counter(char const * descr);
+/** \brief Counters for the hits, misses and evictions of a cache (e.g., \c set_assoc_cache). */
+struct cache_stat_counters {
+    stat_counter m_hit;
+    stat_counter m_miss;
+    stat_counter m_eviction;
+};
+/** \brief Register the counters "<descr> hits", "<descr> misses" and "<descr> evictions".
+    This function should only be invoked by the initialize_* procedures. */
+cache_stat_counters register_cache_stat_counters(char const * descr);
+/** \brief Register a new histogram with the given description.
+    This function should only be invoked by the initialize_* procedures. */
+stat_histogram register_stat_histogram(char const * descr);
+
+/** \brief Flag for enabling the collection of statistics. It is read on every counter update,
+    so relaxed loads are used: updates performed concurrently with \c enable_stats may be missed. */
+extern atomic<bool> g_stats_enabled;
+/** \brief Enable/disable the collection of statistics. Statistics are not collected by default. */
+void enable_stats(bool flag);
+inline bool stats_enabled() { return g_stats_enabled.load(memory_order_relaxed); }
+
+void add_stat_core(stat_counter c, uint64 n);
+void inc_stat_core(stat_histogram h, name const & n);
+
+/** \brief Increment the counter \c c by \c n.
+    Each thread has its own set of counters, they are only aggregated by \c get_stats.
+    When the collection of statistics is disabled, the cost is a test of a global flag. */
+inline void add_stat(stat_counter c, uint64 n) { if (stats_enabled()) add_stat_core(c, n); }
+inline void inc_stat(stat_counter c) { if (stats_enabled()) add_stat_core(c, 1); }
+inline void inc_stat(stat_histogram h, name const & n) { if (stats_enabled()) inc_stat_core(h, n); }
+
+/** \brief Values of all registered counters and histograms. */
+struct stats_snapshot {
+    std::vector<uint64>                      m_counters;
+    std::vector<name_hash_map<uint64>>       m_histograms;
+    uint64 get(stat_counter c) const { return m_counters[c.m_idx]; }
+    uint64 get(stat_histogram h, name const & n) const;
+};
+
+/** \brief Return the sum of the counters of all threads (including threads that have already finished). */
+stats_snapshot get_stats();
+/** \brief Reset the counters of all threads. */
+void reset_stats();
+/** \brief Display the nonzero counters of \c s, and the \c max_entries largest entries of each histogram. */
+void display_stats(std::ostream & out, stats_snapshot const & s, unsigned max_entries = 20);
+void display_stats(std::ostream & out);
+
+void open_stats(lua_State * L);
+void initialize_stats();
+void finalize_stats();
+}
@@ -0,0 +1,177 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include "util/interrupt.h"
+#include "util/task_scheduler.h"
+
+namespace lean {
+LEAN_THREAD_PTR(task_scheduler, g_current_scheduler);
+LEAN_THREAD_VALUE(unsigned, g_current_thread, 0);
+
+typedef std::chrono::steady_clock clock_type;
+
+static double elapsed_secs(clock_type::time_point const & start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+task_scheduler::task_scheduler(unsigned num_threads):
+    m_num_threads(std::max(num_threads, 1u)), m_workers(new worker[m_num_threads]),
+    m_num_queued(0), m_num_idle(0), m_next_seq(0), m_done(false), m_failed_thread(-1) {
+#if !defined(LEAN_MULTI_THREAD)
+    m_num_threads = 1;
+#endif
+    m_thread_exceptions.resize(m_num_threads);
+}
+
+void task_scheduler::add(task const & fn, unsigned priority) {
+    worker & w = m_workers[g_current_scheduler == this ? g_current_thread : 0];
+    {
+        lock_guard<mutex> lock(w.m_mutex);
+        m_num_queued++;
+        w.m_tasks.emplace_back(fn, priority, m_next_seq++);
+        std::push_heap(w.m_tasks.begin(), w.m_tasks.end(), entry_lt());
+    }
+    // Remark: an idle thread increments m_num_idle before checking m_num_queued.
+    if (m_num_idle > 0) {
+        lock_guard<mutex> lock(m_idle_mutex);
+        m_idle_cv.notify_one();
+    }
+}
+
+void task_scheduler::done() {
+    m_done = true;
+    lock_guard<mutex> lock(m_idle_mutex);
+    m_idle_cv.notify_all();
+}
+
+bool task_scheduler::pop(unsigned victim, task & r) {
+    worker & w = m_workers[victim];
+    lock_guard<mutex> lock(w.m_mutex);
+    if (w.m_tasks.empty())
+        return false;
+    std::pop_heap(w.m_tasks.begin(), w.m_tasks.end(), entry_lt());
+    r = std::move(w.m_tasks.back().m_fn);
+    w.m_tasks.pop_back();
+    m_num_queued--;
+    return true;
+}
+
+bool task_scheduler::next_task(unsigned i, task & r) {
+    thread_stats & s = m_workers[i].m_stats;
+    while (true) {
+        check_interrupted();
+        if (m_failed_thread >= 0)
+            return false;
+        if (pop(i, r))
+            return true;
+        for (unsigned k = 1; k < m_num_threads; k++) {
+            if (pop((i + k) % m_num_threads, r)) {
+                s.m_num_stolen++;
+                return true;
+            }
+        }
+        auto start = clock_type::now();
+        {
+            unique_lock<mutex> lock(m_idle_mutex);
+            m_num_idle++;
+            if (m_num_queued == 0) {
+                if (m_done) {
+                    m_num_idle--;
+                    return false;
+                }
+                m_idle_cv.wait(lock);
+            }
+            m_num_idle--;
+        }
+        s.m_idle_secs += elapsed_secs(start);
+    }
+}
+
+void task_scheduler::worker_loop(unsigned i) {
+    task_scheduler * old_scheduler = g_current_scheduler;
+    unsigned old_thread            = g_current_thread;
+    g_current_scheduler = this;
+    g_current_thread    = i;
+    try {
+        thread_stats & s = m_workers[i].m_stats;
+        task t;
+        while (next_task(i, t)) {
+            auto start = clock_type::now();
+            t();
+            t = nullptr;
+            s.m_busy_secs += elapsed_secs(start);
+            s.m_num_tasks++;
+        }
+    } catch (...) {
+        g_current_scheduler = old_scheduler;
+        g_current_thread    = old_thread;
+        throw;
+    }
+    g_current_scheduler = old_scheduler;
+    g_current_thread    = old_thread;
+}
+
+void task_scheduler::run() {
+    std::vector<std::unique_ptr<interruptible_thread>> extra_threads;
+    for (unsigned i = 1; i < m_num_threads; i++) {
+        extra_threads.push_back(std::unique_ptr<interruptible_thread>(new interruptible_thread([=]() {
+                        try {
+                            worker_loop(i);
+                        } catch (throwable & ex) {
+                            m_thread_exceptions[i].reset(ex.clone());
+                            m_failed_thread = i;
+                            done(); // wake up the other threads
+                        } catch (...) {
+                            m_thread_exceptions[i].reset(new exception("task scheduler thread failed for unknown reasons"));
+                            m_failed_thread = i;
+                            done(); // wake up the other threads
+                        }
+                    })));
+    }
+    try {
+        worker_loop(0);
+        for (auto & th : extra_threads)
+            th->join();
+    } catch (...) {
+        m_failed_thread = 0;
+        done();
+        for (auto & th : extra_threads)
+            th->request_interrupt();
+        for (auto & th : extra_threads)
+            th->join();
+        throw;
+    }
+    int idx = m_failed_thread;
+    if (idx > 0)
+        m_thread_exceptions[idx]->rethrow();
+}
+
+void task_scheduler::reset() {
+    for (unsigned i = 0; i < m_num_threads; i++) {
+        m_workers[i].m_tasks.clear(); // tasks left by a failed run
+        m_thread_exceptions[i].reset();
+    }
+    m_num_queued    = 0;
+    m_done          = false;
+    m_failed_thread = -1;
+}
+
+void task_scheduler::display_stats(std::ostream & out) const {
+    out << "thread     tasks    stolen   busy(s)   idle(s)  utilization\n";
+    for (unsigned i = 0; i < m_num_threads; i++) {
+        thread_stats const & s = m_workers[i].m_stats;
+        double total = s.m_busy_secs + s.m_idle_secs;
+        out << std::setw(6) << i << std::setw(10) << s.m_num_tasks << std::setw(10) << s.m_num_stolen
+            << std::fixed << std::setprecision(3)
+            << std::setw(10) << s.m_busy_secs << std::setw(10) << s.m_idle_secs
+            << std::setprecision(1) << std::setw(12) << (total > 0.0 ? 100.0 * s.m_busy_secs / total : 100.0) << "%\n";
+    }
+}
+}
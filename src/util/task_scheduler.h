@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include "util/thread.h"
+#include "util/exception.h"
+
+namespace lean {
+/**
+   \brief Scheduler for executing tasks using a fixed number of threads.
+
+   Each thread owns a task queue. A task created by a thread executing a task of the scheduler
+   is stored in the queue of this thread. When the queue of a thread is empty, it steals tasks from the
+   queues of other threads (aka work stealing). So, there is no global lock.
+
+   Each task has a priority. A thread always executes (and steals) the task with the highest priority first.
+   Tasks with the same priority are executed in LIFO order.
+*/
+class task_scheduler {
+public:
+    typedef std::function<void()> task;
+    /** \brief Statistics for each thread of the scheduler. */
+    struct thread_stats {
+        unsigned m_num_tasks;  // number of executed tasks
+        unsigned m_num_stolen; // number of executed tasks that were stolen from other threads
+        double   m_busy_secs;  // time spent executing tasks
+        double   m_idle_secs;  // time spent waiting for tasks
+        thread_stats():m_num_tasks(0), m_num_stolen(0), m_busy_secs(0.0), m_idle_secs(0.0) {}
+    };
+private:
+    struct entry {
+        task     m_fn;
+        unsigned m_priority;
+        unsigned m_seq;
+        entry(task const & fn, unsigned p, unsigned seq):m_fn(fn), m_priority(p), m_seq(seq) {}
+    };
+    struct entry_lt {
+        bool operator()(entry const & e1, entry const & e2) const {
+            return e1.m_priority < e2.m_priority || (e1.m_priority == e2.m_priority && e1.m_seq < e2.m_seq);
+        }
+    };
+    struct worker {
+        mutex              m_mutex;
+        std::vector<entry> m_tasks; // heap
+        thread_stats       m_stats;
+    };
+    unsigned                                m_num_threads;
+    std::unique_ptr<worker[]>               m_workers;
+    atomic<unsigned>                        m_num_queued; // number of tasks stored in the queues
+    atomic<unsigned>                        m_num_idle;   // number of threads waiting for tasks
+    atomic<unsigned>                        m_next_seq;
+    atomic<bool>                            m_done;
+    mutex                                   m_idle_mutex;
+    condition_variable                      m_idle_cv;
+    atomic<int>                             m_failed_thread; // >= 0 if a thread failed
+    std::vector<std::unique_ptr<throwable>> m_thread_exceptions;
+
+    bool pop(unsigned victim, task & r);
+    bool next_task(unsigned i, task & r);
+    void worker_loop(unsigned i);
+public:
+    /** \brief Create a scheduler that uses \c num_threads threads (including the one executing \c run). */
+    task_scheduler(unsigned num_threads);
+
+    unsigned get_num_threads() const { return m_num_threads; }
+
+    /** \brief Add a new task. If the current thread is executing a task of this scheduler, then
+        it is stored in its own queue. Otherwise, it is stored in the queue of the first thread. */
+    void add(task const & fn, unsigned priority = 0);
+
+    /** \brief Notify the scheduler that tasks not being executed will not create new tasks.
+        After this method is invoked, the threads stop as soon as all queues are empty. */
+    void done();
+
+    /** \brief Execute the tasks using the current thread and <tt>get_num_threads() - 1</tt> new threads.
+        It returns after \c done has been invoked, and all tasks have been executed.
+        If a task throws an exception, the remaining threads are interrupted, and the exception is rethrown. */
+    void run();
+
+    /** \brief Prepare the scheduler for another call to \c run. The statistics are preserved.
+        \pre \c run is not being executed. */
+    void reset();
+
+    thread_stats const & get_stats(unsigned i) const { return m_workers[i].m_stats; }
+
+    /** \brief Display the statistics of each thread. */
+    void display_stats(std::ostream & out) const;
+};
+}
@@ -56,11 +56,15 @@ void run_thread_finalizers(thread_finalizers * fns) {
     }
 }
 
+// Remark: the pointers are reset because finalizers may still be registered after the thread finalizers
+// were executed, e.g., when a post thread finalizer uses a thread local object that registers a finalizer.
 void run_thread_finalizers() {
     run_thread_finalizers(g_finalizers);
+    g_finalizers = nullptr;
 }
 
 void run_post_thread_finalizers() {
     run_thread_finalizers(g_post_finalizers);
+    g_post_finalizers = nullptr;
 }
 }
@@ -33,6 +33,7 @@ using std::atomic_fetch_sub_explicit;
 using std::memory_order_relaxed;
 using std::memory_order_release;
 using std::memory_order_acquire;
+using std::memory_order_acq_rel;
 using std::memory_order_seq_cst;
 using std::atomic_thread_fence;
 namespace chrono      = std::chrono;
@@ -53,6 +54,7 @@ using boost::atomic;
 using boost::memory_order_relaxed;
 using boost::memory_order_acquire;
 using boost::memory_order_release;
+using boost::memory_order_acq_rel;
 using boost::memory_order_seq_cst;
 using boost::condition_variable;
 using boost::unique_lock;
@@ -82,6 +84,7 @@ typedef unsigned milliseconds;
 constexpr int memory_order_relaxed = 0;
 constexpr int memory_order_release = 0;
 constexpr int memory_order_acquire = 0;
+constexpr int memory_order_acq_rel = 0;
 constexpr int memory_order_seq_cst = 0;
 inline void atomic_thread_fence(int ) {}
 template<typename T>
@@ -97,8 +100,8 @@ public:
     atomic & operator=(atomic const & v) { m_value = v.m_value; return *this; }
     atomic & operator=(atomic && v) { m_value = std::forward<T>(v.m_value); return *this; }
     operator T() const { return m_value; }
-    void store(T const & v) { m_value = v; }
-    T load() const { return m_value; }
+    void store(T const & v, int = 0) { m_value = v; }
+    T load(int = 0) const { return m_value; }
     atomic & operator|=(T const & v) { m_value |= v; return *this; }
     atomic & operator+=(T const & v) { m_value += v; return *this; }
     atomic & operator-=(T const & v) { m_value -= v; return *this; }
@@ -0,0 +1,18 @@
+prelude
+-- The kernel extension for nat operations must not be used for definitions of the current module
+inductive nat :=
+| zero : nat
+| succ : nat → nat
+
+inductive eq {A : Type} (a : A) : A → Type.{0} :=
+refl : eq a a
+
+namespace nat
+definition add (a b : nat) : nat := a
+
+example : eq (add (succ zero) (succ zero)) (succ zero) :=
+eq.refl _
+
+example : eq (add (succ zero) (succ zero)) (succ (succ zero)) :=
+eq.refl _
+end nat
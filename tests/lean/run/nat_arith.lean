@@ -0,0 +1,12 @@
+import data.nat
+open nat
+
+example : (1000 : nat) * 1000 = 1000000 := rfl
+example : (123456 : nat) + 654321 = 777777 := rfl
+example : (100 : nat) - 300 = 0 := rfl
+example : (1000000 : nat) div 7 = 142857 := rfl
+example : (1000000 : nat) mod 7 = 1 := rfl
+example : (10 : nat) div 0 = 0 := rfl
+example : (100000 : nat) ≠ 100001 := dec_trivial
+example : (1000 : nat) ≤ 1000000 := dec_trivial
+example : ¬ (1000001 : nat) ≤ 1000000 := dec_trivial
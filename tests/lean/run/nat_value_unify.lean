@@ -0,0 +1,13 @@
+import data.nat
+open nat eq.ops
+
+-- the unifier must assign ?n by unfolding nat.mul, evaluating ?n * 0 to 0 loses the solution
+example (n : ℕ) : succ n * 0 = n * 0 + 0 :=
+!mul_zero ⬝ !mul_zero⁻¹ ⬝ !add_zero⁻¹
+
+-- the calc assistant first tries sub_self using only reducible definitions, nat.add is not reducible
+example (n : ℕ) : (n - n) + (n - n) = 0 :=
+calc
+  (n - n) + (n - n) = 0 + (n - n) : sub_self
+                ... = 0 + 0       : sub_self
+                ... = 0           : rfl